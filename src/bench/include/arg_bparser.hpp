@@ -0,0 +1,132 @@
+#ifndef __BENCH_ARG__
+#define __BENCH_ARG__
+
+#include <map>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <string>
+
+using ValidResolution = std::vector<std::string>;
+using ArgStringMap = std::map<std::string, std::string>;
+
+class ArgParser
+{
+
+public:
+    ArgParser()
+    {
+        string_map.insert(std::make_pair(std::string("-o"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-res"), std::string("all")));
+        string_map.insert(std::make_pair(std::string("-k"), std::string("all")));
+        string_map.insert(std::make_pair(std::string("-t"), std::string("0.2")));
+
+        valid_resolution.push_back("all");
+        valid_resolution.push_back("wvga");
+        valid_resolution.push_back("720p");
+        valid_resolution.push_back("1080p");
+        valid_resolution.push_back("2.2k");
+    }
+
+    void parse(int argc, char *argv[])
+    {
+        std::vector<std::string> args;
+
+        if (argc > 1)
+        {
+            args.assign(argv + 1, argv + argc);
+            bool kw_flag = false;
+            std::string *key = nullptr;
+            for (auto &arg : args)
+            {
+                if (kw_flag)
+                {
+                    if (check_keyword(*key, arg))
+                    {
+                        string_map.at(*key) = arg;
+                    }
+                    else
+                        bad_keyword(*key, arg);
+
+                    kw_flag = false;
+                    key = nullptr;
+                }
+                else
+                {
+                    if (string_map.find(arg) != string_map.end())
+                    {
+                        kw_flag = true;
+                        key = &arg;
+                    }
+                    else
+                    {
+                        std::string message = "Invalid option: " + arg;
+                        throw std::invalid_argument(message);
+                    }
+                }
+            }
+            if (kw_flag == true)
+                bad_keyword(args.back(), "");
+        }
+    }
+
+    // JSON output file, empty for stdout
+    std::string get_output_file()
+    {
+        return string_map.at("-o");
+    }
+    std::string get_resolution()
+    {
+        return string_map.at("-res");
+    }
+    // Kernel name prefix or all
+    std::string get_kernels()
+    {
+        return string_map.at("-k");
+    }
+    // Minimum measuring time per kernel and resolution in seconds
+    double get_min_seconds()
+    {
+        return std::stod(string_map.at("-t"));
+    }
+
+private:
+    ArgStringMap string_map;
+    ValidResolution valid_resolution;
+
+    bool check_keyword(const std::string &key, const std::string &value)
+    {
+        if (key.compare("-res") == 0)
+        {
+            if (std::find(valid_resolution.begin(), valid_resolution.end(), value) != valid_resolution.end())
+                return true;
+        }
+        else if (key.compare("-t") == 0)
+        {
+            if (is_decimal(value) && std::stod(value) <= 60.0)
+                return true;
+        }
+        else
+        {
+            if (value.compare("") != 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool is_decimal(const std::string &s)
+    {
+        return !s.empty() && s.size() < 10 && std::count(s.begin(), s.end(), '.') <= 1 &&
+               std::find_if(s.begin(), s.end(), [](unsigned char c)
+                            { return !std::isdigit(c) && c != '.'; }) == s.end() &&
+               s != ".";
+    }
+
+    void bad_keyword(const std::string &key, const std::string &value)
+    {
+        std::string message = "Invalid keyword value pair: (" + key + ", " + value + ").";
+        throw std::invalid_argument(message);
+    }
+};
+
+#endif
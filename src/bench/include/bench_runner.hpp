@@ -0,0 +1,165 @@
+#ifndef __BENCH_RUNNER__
+#define __BENCH_RUNNER__
+
+#include <synthetic_depth.hpp>
+#include <depth_stats.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define BENCH_WARMUP_ITERATIONS 2
+#define BENCH_MIN_ITERATIONS 10
+#define BENCH_MAX_ITERATIONS 100000
+
+struct BenchResult
+{
+    std::string kernel;
+    std::string resolution;
+    int width = 0;
+    int height = 0;
+    uint64_t iterations = 0;
+    // Per frame: median, mean and fastest iteration
+    double ns_per_frame = 0.0;
+    double ns_mean = 0.0;
+    double ns_min = 0.0;
+    // F32 depth read per frame, throughput is bytes_per_frame / ns_per_frame
+    double bytes_per_frame = 0.0;
+    double gb_per_s = 0.0;
+    // Kernel specific figures, e.g. the compression ratio of an encoder
+    std::map<std::string, double> extra;
+};
+
+// Times a kernel call by call until both min_seconds and BENCH_MIN_ITERATIONS are
+// reached. The median is the headline number since a preempted call only moves the
+// mean, which makes runs comparable across machines and releases.
+class BenchRunner
+{
+public:
+    BenchRunner(double min_seconds, const std::string &filter)
+        : min_seconds(min_seconds), filter(filter)
+    {
+    }
+
+    // Kernels are selected by name prefix, "all" runs everything
+    bool selected(const std::string &kernel) const
+    {
+        return filter.compare("all") == 0 || kernel.compare(0, filter.size(), filter) == 0;
+    }
+
+    // `body(iteration)` processes one frame
+    template <typename Body>
+    void run(const std::string &kernel, const BenchResolution &resolution, double bytes_per_frame, Body body,
+             const std::map<std::string, double> &extra = std::map<std::string, double>())
+    {
+        if (!selected(kernel))
+            return;
+
+        using clock = std::chrono::steady_clock;
+        for (int i = 0; i < BENCH_WARMUP_ITERATIONS; ++i)
+            body(i);
+
+        samples.clear();
+        auto start = clock::now();
+        double elapsed = 0.0;
+        int iteration = BENCH_WARMUP_ITERATIONS;
+        while ((elapsed < min_seconds || samples.size() < BENCH_MIN_ITERATIONS) &&
+               samples.size() < BENCH_MAX_ITERATIONS)
+        {
+            auto t0 = clock::now();
+            body(iteration++);
+            auto t1 = clock::now();
+            samples.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            elapsed = std::chrono::duration<double>(t1 - start).count();
+        }
+
+        BenchResult result;
+        result.kernel = kernel;
+        result.resolution = resolution.name;
+        result.width = resolution.width;
+        result.height = resolution.height;
+        result.iterations = samples.size();
+        result.bytes_per_frame = bytes_per_frame;
+        result.extra = extra;
+
+        double sum = 0.0;
+        for (uint64_t sample : samples)
+            sum += (double)sample;
+        result.ns_mean = sum / samples.size();
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        result.ns_per_frame = (double)samples[samples.size() / 2];
+        result.ns_min = (double)*std::min_element(samples.begin(), samples.end());
+        result.gb_per_s = result.ns_per_frame > 0.0 ? bytes_per_frame / result.ns_per_frame : 0.0;
+        results.push_back(result);
+    }
+
+    const std::vector<BenchResult> &get_results() const
+    {
+        return results;
+    }
+
+private:
+    double min_seconds;
+    std::string filter;
+    std::vector<uint64_t> samples;
+    std::vector<BenchResult> results;
+};
+
+static void print_results_table(std::ostream &out, const std::vector<BenchResult> &results)
+{
+    std::streamsize precision = out.precision();
+    out << std::left << std::setw(24) << "kernel" << std::setw(8) << "res" << std::right << std::setw(14)
+        << "ns/frame" << std::setw(10) << "GB/s" << std::setw(10) << "iters" << std::endl;
+    for (const BenchResult &result : results)
+    {
+        out << std::left << std::setw(24) << result.kernel << std::setw(8) << result.resolution << std::right
+            << std::fixed << std::setprecision(0) << std::setw(14) << result.ns_per_frame << std::setprecision(2)
+            << std::setw(10) << result.gb_per_s << std::setw(10) << result.iterations;
+        for (const auto &item : result.extra)
+            out << "  " << item.first << " " << item.second;
+        out << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(precision);
+}
+
+static std::string json_string(const std::string &value)
+{
+    std::string quoted = "\"";
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// One object per run, one result per line so two runs diff line by line
+static void write_results_json(std::ostream &out, const std::vector<BenchResult> &results, double min_seconds)
+{
+    std::streamsize precision = out.precision();
+    out << std::fixed << "{\n  \"benchmark\": \"zed_bench\",\n  \"version\": 1,\n  \"simd\": "
+        << json_string(simd_level_name(detect_simd_level())) << ",\n  \"compiler\": " << json_string(__VERSION__)
+        << ",\n  \"min_seconds\": " << std::setprecision(3) << min_seconds << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult &result = results[i];
+        out << (i > 0 ? "," : "") << "\n    {\"kernel\": " << json_string(result.kernel)
+            << ", \"resolution\": " << json_string(result.resolution) << ", \"width\": " << result.width
+            << ", \"height\": " << result.height << ", \"iterations\": " << result.iterations << std::setprecision(1)
+            << ", \"ns_per_frame\": " << result.ns_per_frame << ", \"ns_mean\": " << result.ns_mean
+            << ", \"ns_min\": " << result.ns_min << std::setprecision(0) << ", \"bytes_per_frame\": "
+            << result.bytes_per_frame << std::setprecision(4) << ", \"gb_per_s\": " << result.gb_per_s;
+        for (const auto &item : result.extra)
+            out << ", " << json_string(item.first) << ": " << item.second;
+        out << "}";
+    }
+    out << "\n  ]\n}" << std::endl;
+    out << std::defaultfloat << std::setprecision(precision);
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef __BENCH_KERNELS__
+#define __BENCH_KERNELS__
+
+#include <bench_runner.hpp>
+#include <depth_codec.hpp>
+#include <depth_colormap.hpp>
+#include <depth_percentile.hpp>
+#include <integral_depth.hpp>
+#include <occupancy_map.hpp>
+#include <point_cloud.hpp>
+#include <roi.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// Frames generated per resolution, cycled through so the caches see a stream
+#define BENCH_FRAMES 4
+// Defaults of depth_sensing: 70x70 measurement box, 800x600 window, 0.3 to 10 m
+#define BENCH_BOX_SIDE 70
+#define BENCH_WINDOW_WIDTH 800
+#define BENCH_WINDOW_HEIGHT 600
+#define BENCH_NEAR_MM 300.f
+#define BENCH_FAR_MM 10000.f
+// 5 cm voxels, in the millimeters of the synthetic depth
+#define BENCH_VOXEL_MM 50.f
+
+// Results are folded in here so the compiler cannot drop the work
+static volatile double bench_sink = 0.0;
+
+// The zones of depth_sensing/zones.example.txt
+static std::vector<Roi> bench_zones()
+{
+    std::vector<Roi> zones;
+    zones.push_back(Roi{"center", 0.45f, 0.45f, 0.10f, 0.10f});
+    for (int r = 0; r < 2; ++r)
+        for (int c = 0; c < 6; ++c)
+            zones.push_back(Roi{std::to_string(r) + "_" + std::to_string(c), 0.05f + c * 0.15f, 0.55f + r * 0.15f,
+                                0.15f, 0.15f});
+    return zones;
+}
+
+// compute_distance of depth_sensing on the measurement box and on the whole frame, as
+// the mean (-m mean) and the median (-m median)
+static void bench_distance(BenchRunner &runner, const BenchResolution &resolution, const SyntheticDepth &depth)
+{
+    PercentileEstimator estimator((size_t)resolution.width * resolution.height);
+    int side_x = std::min(BENCH_BOX_SIDE, resolution.width);
+    int side_y = std::min(BENCH_BOX_SIDE, resolution.height);
+    int box_x = resolution.width / 2 - side_x / 2;
+    int box_y = resolution.height / 2 - side_y / 2;
+    double box_bytes = (double)side_x * side_y * sizeof(float);
+    double frame_bytes = (double)resolution.width * resolution.height * sizeof(float);
+
+    runner.run("distance_box_mean", resolution, box_bytes, [&](int i) {
+        TypedView<const float> box = depth.frame(i).sub(box_x, box_y, side_x, side_y);
+        bench_sink = bench_sink + compute_depth_stats(box.data(), box.stride_bytes(), side_x, side_y).mean();
+    });
+    runner.run("distance_box_median", resolution, box_bytes, [&](int i) {
+        TypedView<const float> box = depth.frame(i).sub(box_x, box_y, side_x, side_y);
+        bench_sink = bench_sink + estimator.percentile(box.data(), box.stride_bytes(), side_x, side_y, 0.5f);
+    });
+    runner.run("distance_frame_mean", resolution, frame_bytes, [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        bench_sink = bench_sink +
+                     compute_depth_stats(frame.data(), frame.stride_bytes(), frame.width(), frame.height()).mean();
+    });
+    runner.run("distance_frame_median", resolution, frame_bytes, [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        bench_sink = bench_sink +
+                     estimator.percentile(frame.data(), frame.stride_bytes(), frame.width(), frame.height(), 0.5f);
+    });
+}
+
+// DepthColormap into the depth_sensing window, aspect ratio kept, and at full size
+static void bench_colormap(BenchRunner &runner, const BenchResolution &resolution, const SyntheticDepth &depth)
+{
+    DepthColormap colormap(BENCH_NEAR_MM, BENCH_FAR_MM);
+    double scale = std::min((double)BENCH_WINDOW_WIDTH / resolution.width,
+                            (double)BENCH_WINDOW_HEIGHT / resolution.height);
+    int sizes[2][2] = {{std::max(1, (int)(resolution.width * scale)), std::max(1, (int)(resolution.height * scale))},
+                       {resolution.width, resolution.height}};
+    const char *names[2] = {"colormap_window", "colormap_full"};
+
+    for (int s = 0; s < 2; ++s)
+    {
+        int out_width = sizes[s][0];
+        int out_height = sizes[s][1];
+        std::vector<uint8_t> bgr((size_t)out_width * out_height * 3);
+        runner.run(names[s], resolution, (double)out_width * out_height * sizeof(float), [&](int i) {
+            TypedView<const float> frame = depth.frame(i);
+            colormap.render(frame.data(), frame.stride_bytes(), frame.width(), frame.height(), bgr.data(),
+                            (size_t)out_width * 3, out_width, out_height);
+            bench_sink = bench_sink + bgr[bgr.size() / 2];
+        });
+    }
+}
+
+// Pitched Mat rows to a packed buffer through TypedView, what every export and
+// sl::Mat to cv::Mat deep copy does
+static void bench_mat_copy(BenchRunner &runner, const BenchResolution &resolution, const SyntheticDepth &depth)
+{
+    std::vector<float> packed((size_t)resolution.width * resolution.height);
+    size_t row_bytes = (size_t)resolution.width * sizeof(float);
+    runner.run("mat_copy", resolution, (double)packed.size() * sizeof(float), [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        for (int row = 0; row < frame.height(); ++row)
+            std::memcpy(&packed[(size_t)row * frame.width()], frame.row(row), row_bytes);
+        bench_sink = bench_sink + packed[packed.size() / 2];
+    });
+}
+
+// compute_zones of depth_sensing with the example zones: summed-area tables, then a
+// four lookup query per zone
+static void bench_roi_stats(BenchRunner &runner, const BenchResolution &resolution, const SyntheticDepth &depth)
+{
+    std::vector<Roi> zones = bench_zones();
+    IntegralDepth integral;
+    runner.run("roi_stats", resolution, (double)resolution.width * resolution.height * sizeof(float), [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        integral.build(frame.data(), frame.stride_bytes(), frame.width(), frame.height());
+        double sum = 0.0;
+        for (const Roi &zone : zones)
+            sum += integral.query(zone).mean();
+        bench_sink = bench_sink + sum;
+    });
+}
+
+// MM16 archive codec, lossless at 1 mm. Decoding is also timed without SIMD.
+static void bench_codec(BenchRunner &runner, const BenchResolution &resolution, const SyntheticDepth &depth)
+{
+    double frame_bytes = (double)resolution.width * resolution.height * sizeof(float);
+    std::map<std::string, double> extra;
+    std::vector<std::vector<uint8_t>> records(depth.get_frame_count());
+    DepthEncoder encoder;
+    double encoded = 0.0;
+    for (int i = 0; i < depth.get_frame_count(); ++i)
+    {
+        TypedView<const float> frame = depth.frame(i);
+        records[i] = encoder.encode(frame.data(), frame.stride_bytes(), frame.width(), frame.height(), 1.f);
+        encoded += records[i].size();
+    }
+    extra["ratio"] = frame_bytes * depth.get_frame_count() / encoded;
+
+    runner.run("mm16_encode", resolution, frame_bytes, [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        bench_sink = bench_sink +
+                     encoder.encode(frame.data(), frame.stride_bytes(), frame.width(), frame.height(), 1.f).size();
+    }, extra);
+
+    std::vector<float> decoded((size_t)resolution.width * resolution.height);
+    DepthDecoder decoders[2] = {DepthDecoder(), DepthDecoder(SimdLevel::SCALAR)};
+    const char *names[2] = {"mm16_decode", "mm16_decode_scalar"};
+    for (int d = 0; d < 2; ++d)
+    {
+        DepthDecoder &decoder = decoders[d];
+        runner.run(names[d], resolution, frame_bytes, [&](int i) {
+            const std::vector<uint8_t> &record = records[i % records.size()];
+            if (!decoder.decode(record.data(), record.size(), decoded.data(), (size_t)resolution.width * sizeof(float),
+                                resolution.width, resolution.height))
+                throw std::runtime_error("MM16 record did not decode");
+            bench_sink = bench_sink + decoded[decoded.size() / 2];
+        }, extra);
+    }
+}
+
+// Point cloud export, every point and 5 cm voxels, and the occupancy map of the
+// volume monitor
+static void bench_point_cloud(BenchRunner &runner, const BenchResolution &resolution, const SyntheticDepth &depth)
+{
+    CameraIntrinsics intrinsics;
+    intrinsics.fx = intrinsics.fy = depth.get_focal();
+    intrinsics.cx = 0.5f * resolution.width;
+    intrinsics.cy = 0.5f * resolution.height;
+    intrinsics.width = resolution.width;
+    intrinsics.height = resolution.height;
+    double frame_bytes = (double)resolution.width * resolution.height * sizeof(float);
+
+    PointCloudGenerator generator;
+    runner.run("point_cloud", resolution, frame_bytes, [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        bench_sink = bench_sink + generator.generate(frame.data(), frame.stride_bytes(), frame.width(),
+                                                     frame.height(), intrinsics);
+    });
+
+    generator.set_voxel_size(BENCH_VOXEL_MM);
+    runner.run("point_cloud_voxel_5cm", resolution, frame_bytes, [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        generator.generate(frame.data(), frame.stride_bytes(), frame.width(), frame.height(), intrinsics);
+        bench_sink = bench_sink + generator.get_points().size();
+    });
+
+    OccupancyMap map(BENCH_VOXEL_MM);
+    runner.run("occupancy_integrate", resolution, frame_bytes, [&](int i) {
+        TypedView<const float> frame = depth.frame(i);
+        map.integrate(frame.data(), frame.stride_bytes(), frame.width(), frame.height(), intrinsics);
+        bench_sink = bench_sink + map.get_block_count();
+    });
+}
+
+static void run_kernels(BenchRunner &runner, const BenchResolution &resolution)
+{
+    SyntheticDepth depth(resolution.width, resolution.height, BENCH_FRAMES);
+    bench_distance(runner, resolution, depth);
+    bench_colormap(runner, resolution, depth);
+    bench_mat_copy(runner, resolution, depth);
+    bench_roi_stats(runner, resolution, depth);
+    bench_codec(runner, resolution, depth);
+    bench_point_cloud(runner, resolution, depth);
+}
+
+#endif
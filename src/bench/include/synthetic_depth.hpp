@@ -0,0 +1,101 @@
+#ifndef __BENCH_SYNTHETIC_DEPTH__
+#define __BENCH_SYNTHETIC_DEPTH__
+
+#include <typed_view.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Rows are padded to a 64 byte pitch like the Mats of the SDK
+#define BENCH_ROW_ALIGN 64
+
+struct BenchResolution
+{
+    const char *name;
+    int width;
+    int height;
+};
+
+static const BenchResolution BENCH_RESOLUTIONS[] = {
+    {"wvga", 672, 376},
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"2.2k", 2208, 1242},
+};
+
+// Depth maps in millimeters with the structure of a ZED work cell view: a floor
+// rising towards the top of the frame, a box in front of it, NaN speckles and bands
+// where stereo matching fails, +inf past the range. Every frame moves the box so
+// consecutive frames differ like a live stream does. No SDK needed.
+class SyntheticDepth
+{
+public:
+    SyntheticDepth(int width, int height, int frames)
+        : width(width), height(height)
+    {
+        size_t row_floats = ((size_t)width * sizeof(float) + BENCH_ROW_ALIGN - 1) / BENCH_ROW_ALIGN *
+                            BENCH_ROW_ALIGN / sizeof(float);
+        stride_bytes = row_floats * sizeof(float);
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            maps.emplace_back(row_floats * height);
+            generate(maps.back().data(), row_floats, frame, frames);
+        }
+    }
+
+    TypedView<const float> frame(int index) const
+    {
+        return TypedView<const float>(maps[index % maps.size()].data(), stride_bytes, width, height);
+    }
+
+    int get_frame_count() const
+    {
+        return (int)maps.size();
+    }
+
+    // Focal length in pixels of a synthetic 90 degree horizontal field of view, principal
+    // point centered
+    float get_focal() const
+    {
+        return 0.5f * (float)width;
+    }
+
+private:
+    int width;
+    int height;
+    size_t stride_bytes;
+    std::vector<std::vector<float>> maps;
+
+    void generate(float *data, size_t row_floats, int frame, int frames)
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const float inf = std::numeric_limits<float>::infinity();
+        float phase = 6.2831853f * (float)frame / (float)frames;
+        int box_x = width / 2 + (int)(0.25f * width * std::sin(phase));
+        int box_half = width / 8;
+        float box_depth = 1200.f + 300.f * std::sin(0.5f * phase);
+        uint32_t noise = 0x12345678u + (uint32_t)frame;
+
+        for (int row = 0; row < height; ++row)
+        {
+            float *dst = data + (size_t)row * row_floats;
+            for (int col = 0; col < width; ++col)
+            {
+                noise = noise * 1664525u + 1013904223u;
+                float depth = 4000.f - 2500.f * (float)row / (float)height + (float)(noise >> 28) * 0.5f;
+                if (row < height / 10)
+                    depth = inf;
+                else if (std::abs(col - box_x) < box_half && std::abs(row - height / 2) < box_half)
+                    depth = box_depth + (float)(noise >> 29);
+                else if ((noise >> 24) < 8 || (col > box_x + box_half && col < box_x + box_half + width / 40))
+                    depth = nan;
+                dst[col] = depth;
+            }
+            for (size_t col = width; col < row_floats; ++col)
+                dst[col] = nan;
+        }
+    }
+};
+
+#endif
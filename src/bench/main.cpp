@@ -0,0 +1,70 @@
+#include "arg_bparser.hpp"
+#include "kernels.hpp"
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    ArgParser parser;
+
+    try
+    {
+        parser.parse(argc, argv);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cerr << "Could not parse arguments: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string output_file = parser.get_output_file();
+    std::string resolution_s = parser.get_resolution();
+    std::string kernels_s = parser.get_kernels();
+    double min_seconds = parser.get_min_seconds();
+
+    // The table goes to stderr so stdout stays valid JSON
+    std::cerr << "SIMD level: " << simd_level_name(detect_simd_level()) << std::endl;
+    std::cerr << "Resolution: " << resolution_s << std::endl;
+    std::cerr << "Kernels: " << kernels_s << std::endl;
+    std::cerr << "Minimum time: " << min_seconds << " s" << std::endl;
+    std::cerr << std::endl;
+
+    BenchRunner runner(min_seconds, kernels_s);
+    try
+    {
+        for (const BenchResolution &resolution : BENCH_RESOLUTIONS)
+        {
+            if (resolution_s.compare("all") == 0 || resolution_s.compare(resolution.name) == 0)
+                run_kernels(runner, resolution);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (runner.get_results().empty())
+    {
+        std::cerr << "No kernel matches " << kernels_s << std::endl;
+        return 1;
+    }
+
+    print_results_table(std::cerr, runner.get_results());
+
+    if (output_file.empty())
+    {
+        write_results_json(std::cout, runner.get_results(), min_seconds);
+        return 0;
+    }
+
+    std::ofstream file(output_file);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open " << output_file << std::endl;
+        return 1;
+    }
+    write_results_json(file, runner.get_results(), min_seconds);
+    std::cerr << std::endl << "Results written to " << output_file << std::endl;
+    return 0;
+}
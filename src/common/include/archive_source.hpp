@@ -0,0 +1,126 @@
+#ifndef __COMMON_ARCHIVE_SOURCE__
+#define __COMMON_ARCHIVE_SOURCE__
+
+#include <frame_source.hpp>
+#include <depth_archive.hpp>
+
+// Replays a depth archive, so depth analyses run on stored depth instead of recomputing
+// it with the SDK. Archives hold depth only: every image view renders the depth map and
+// sensors are reported unavailable. MM16 records are decoded on retrieval.
+class ArchiveFrameSource : public FrameSource
+{
+public:
+    ArchiveFrameSource(const std::string &filename)
+        : reader(filename)
+    {
+    }
+
+    sl::ERROR_CODE retrieve_image(sl::Mat &image, sl::VIEW view = sl::VIEW::LEFT) override
+    {
+        auto err = retrieve_measure(scratch_depth, sl::MEASURE::DEPTH);
+        if (err == sl::ERROR_CODE::SUCCESS)
+            render_depth_view(scratch_depth, image, 10.f * meters_to_unit(get_unit()));
+        return err;
+    }
+
+    sl::ERROR_CODE retrieve_measure(sl::Mat &measure, sl::MEASURE type = sl::MEASURE::DEPTH) override
+    {
+        if (position < 0)
+            return sl::ERROR_CODE::FAILURE;
+        if (type != sl::MEASURE::DEPTH)
+            return sl::ERROR_CODE::INVALID_FUNCTION_PARAMETERS;
+
+        ensure_mat(measure, reader.get_width(), reader.get_height(), sl::MAT_TYPE::F32_C1);
+        TypedView<float> out(measure);
+        const DepthArchiveEntry &entry = reader.entry(position);
+        if (entry.codec == DEPTH_CODEC_MM16)
+        {
+            bool decoded = decoder.decode(reader.payload(position), entry.bytes, out.data(), out.stride_bytes(),
+                                          out.width(), out.height());
+            return decoded ? sl::ERROR_CODE::SUCCESS : sl::ERROR_CODE::FAILURE;
+        }
+
+        const float *data = reader.frame(position);
+        if (data == nullptr)
+            return sl::ERROR_CODE::FAILURE;
+
+        TypedView<const float> src(data, reader.get_row_bytes(), out.width(), out.height());
+        if (out.stride_bytes() == src.stride_bytes())
+            std::memcpy(out.data(), src.data(), src.stride_bytes() * src.height());
+        else
+        {
+            for (int row = 0; row < src.height(); ++row)
+                std::memcpy(out.row(row), src.row(row), src.width() * sizeof(float));
+        }
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+    sl::ERROR_CODE get_sensors_data(sl::SensorsData &data, sl::TIME_REFERENCE reference) override
+    {
+        return sl::ERROR_CODE::SENSORS_NOT_AVAILABLE;
+    }
+
+    sl::Timestamp get_timestamp(sl::TIME_REFERENCE reference) override
+    {
+        return sl::Timestamp(position >= 0 ? reader.get_timestamp(position) : 0);
+    }
+
+    int get_position() override
+    {
+        return position;
+    }
+
+    void set_position(int frame_index) override
+    {
+        next = std::max(0, std::min(frame_index, reader.get_frame_count()));
+    }
+
+    int get_frame_count() override
+    {
+        return reader.get_frame_count();
+    }
+
+    float get_fps() override
+    {
+        return reader.get_fps();
+    }
+
+    float get_current_fps() override
+    {
+        return reader.get_fps();
+    }
+
+    sl::UNIT get_unit() override
+    {
+        return reader.get_unit();
+    }
+
+    sl::Resolution get_resolution() override
+    {
+        return sl::Resolution(reader.get_width(), reader.get_height());
+    }
+
+    const DepthArchiveReader &get_reader() const
+    {
+        return reader;
+    }
+
+protected:
+    sl::ERROR_CODE grab_frame(sl::RuntimeParameters &params) override
+    {
+        if (next >= reader.get_frame_count())
+            return sl::ERROR_CODE::END_OF_SVOFILE_REACHED;
+
+        position = next++;
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+private:
+    DepthArchiveReader reader;
+    int position = -1;
+    int next = 0;
+    sl::Mat scratch_depth;
+    DepthDecoder decoder;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef __COMMON_CALIBRATION__
+#define __COMMON_CALIBRATION__
+
+#include <frame_source.hpp>
+#include <fstream>
+#include <map>
+#include <string>
+
+// Name of the calibration file section of each ZED resolution, by image width
+static inline std::string calibration_section(int width)
+{
+    switch (width)
+    {
+    case 2208:
+        return "LEFT_CAM_2K";
+    case 1920:
+        return "LEFT_CAM_FHD";
+    case 1280:
+        return "LEFT_CAM_HD";
+    case 672:
+        return "LEFT_CAM_VGA";
+    default:
+        return "";
+    }
+}
+
+// Reads the left camera intrinsics for a width x height image from a factory
+// calibration file (SN<serial>.conf, as stored in the ZED settings folder). Images of
+// another size, e.g. depth retrieved at a reduced resolution, use the section of the
+// same aspect ratio rescaled. Throws sl::ERROR_CODE::INVALID_CALIBRATION_FILE.
+static CameraIntrinsics load_calibration(const std::string &filename, int width, int height)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+        throw sl::ERROR_CODE::INVALID_CALIBRATION_FILE;
+
+    std::map<std::string, std::map<std::string, float>> sections;
+    std::string line, section;
+    while (std::getline(file, line))
+    {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#' || line[0] == ';')
+            continue;
+        if (line[0] == '[' && line.back() == ']')
+        {
+            section = line.substr(1, line.size() - 2);
+            continue;
+        }
+        size_t equal = line.find('=');
+        if (equal == std::string::npos)
+            continue;
+        try
+        {
+            sections[section][line.substr(0, equal)] = std::stof(line.substr(equal + 1));
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+
+    // The section of the image size first, then any other of the same aspect ratio
+    const int widths[] = {width, 2208, 1920, 1280, 672};
+    const int heights[] = {height, 1242, 1080, 720, 376};
+    for (int i = 0; i < 5; ++i)
+    {
+        std::string name = calibration_section(widths[i]);
+        auto found = sections.find(name);
+        if (name.empty() || found == sections.end())
+            continue;
+        if (i > 0 && std::abs((float)width / height - (float)widths[i] / heights[i]) > 0.02f)
+            continue;
+
+        std::map<std::string, float> &values = found->second;
+        CameraIntrinsics intrinsics;
+        intrinsics.fx = values["fx"];
+        intrinsics.fy = values["fy"];
+        intrinsics.cx = values["cx"];
+        intrinsics.cy = values["cy"];
+        intrinsics.width = widths[i];
+        intrinsics.height = heights[i];
+        if (intrinsics.is_valid())
+            return intrinsics.scaled(width, height);
+    }
+    throw sl::ERROR_CODE::INVALID_CALIBRATION_FILE;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __COMMON_CAMERA_INTRINSICS__
+#define __COMMON_CAMERA_INTRINSICS__
+
+// Pinhole model of the left camera for a width x height image, in pixels
+struct CameraIntrinsics
+{
+    float fx = 0.f;
+    float fy = 0.f;
+    float cx = 0.f;
+    float cy = 0.f;
+    int width = 0;
+    int height = 0;
+
+    bool is_valid() const
+    {
+        return fx > 0.f && fy > 0.f && width > 0 && height > 0;
+    }
+
+    // Same camera for an image resampled to to_width x to_height
+    CameraIntrinsics scaled(int to_width, int to_height) const
+    {
+        CameraIntrinsics result = *this;
+        if (width > 0 && height > 0)
+        {
+            float sx = (float)to_width / (float)width;
+            float sy = (float)to_height / (float)height;
+            result.fx = fx * sx;
+            result.fy = fy * sy;
+            result.cx = cx * sx;
+            result.cy = cy * sy;
+        }
+        result.width = to_width;
+        result.height = to_height;
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef __COMMON_CV_VIEW__
+#define __COMMON_CV_VIEW__
+
+#include <mat_types.hpp>
+#include <depth_archive.hpp>
+#include <opencv2/core.hpp>
+
+// OpenCV type of every view element, at compile time
+template <typename T>
+struct CvTypeOf;
+
+template <>
+struct CvTypeOf<sl::float1>
+{
+    static const int value = CV_32FC1;
+};
+template <>
+struct CvTypeOf<sl::float2>
+{
+    static const int value = CV_32FC2;
+};
+template <>
+struct CvTypeOf<sl::float3>
+{
+    static const int value = CV_32FC3;
+};
+template <>
+struct CvTypeOf<sl::float4>
+{
+    static const int value = CV_32FC4;
+};
+template <>
+struct CvTypeOf<sl::uchar1>
+{
+    static const int value = CV_8UC1;
+};
+template <>
+struct CvTypeOf<sl::uchar2>
+{
+    static const int value = CV_8UC2;
+};
+template <>
+struct CvTypeOf<sl::uchar3>
+{
+    static const int value = CV_8UC3;
+};
+template <>
+struct CvTypeOf<sl::uchar4>
+{
+    static const int value = CV_8UC4;
+};
+template <>
+struct CvTypeOf<sl::ushort1>
+{
+    static const int value = CV_16UC1;
+};
+
+// cv::Mat header over the view, the pixels stay where they are
+template <typename T>
+static cv::Mat to_cv_mat(const TypedView<T> &view)
+{
+    using Element = typename TypedView<T>::Element;
+    return cv::Mat(view.height(), view.width(), CvTypeOf<Element>::value, const_cast<Element *>(view.data()),
+                   view.stride_bytes());
+}
+
+// Read only view of an archived depth frame, sharing the archive mapping like
+// to_cv_mat shares the sl::Mat buffer. Empty for frames stored with another codec.
+static inline cv::Mat archiveFrame2cvMat(const DepthArchiveReader &reader, int frame)
+{
+    const float *data = reader.frame(frame);
+    if (data == nullptr)
+        return cv::Mat();
+    return to_cv_mat(TypedView<const float>(data, reader.get_row_bytes(), reader.get_width(), reader.get_height()));
+}
+
+// Mapping between MAT_TYPE and CV_TYPE, for Mats whose type is only known at run time
+static int getOCVtype(sl::MAT_TYPE type)
+{
+    int cv_type = -1;
+    switch (type)
+    {
+    case sl::MAT_TYPE::F32_C1:
+        cv_type = CV_32FC1;
+        break;
+    case sl::MAT_TYPE::F32_C2:
+        cv_type = CV_32FC2;
+        break;
+    case sl::MAT_TYPE::F32_C3:
+        cv_type = CV_32FC3;
+        break;
+    case sl::MAT_TYPE::F32_C4:
+        cv_type = CV_32FC4;
+        break;
+    case sl::MAT_TYPE::U8_C1:
+        cv_type = CV_8UC1;
+        break;
+    case sl::MAT_TYPE::U8_C2:
+        cv_type = CV_8UC2;
+        break;
+    case sl::MAT_TYPE::U8_C3:
+        cv_type = CV_8UC3;
+        break;
+    case sl::MAT_TYPE::U8_C4:
+        cv_type = CV_8UC4;
+        break;
+    case sl::MAT_TYPE::U16_C1:
+        cv_type = CV_16UC1;
+        break;
+    default:
+        break;
+    }
+    return cv_type;
+}
+
+static inline cv::Mat slMat2cvMat(sl::Mat &input)
+{
+    // Since cv::Mat data requires a uchar* pointer, we get the uchar1 pointer from sl::Mat (getPtr<T>())
+    // cv::Mat and sl::Mat will share a single memory structure
+    return cv::Mat(input.getHeight(), input.getWidth(), getOCVtype(input.getDataType()), input.getPtr<sl::uchar1>(sl::MEM::CPU), input.getStepBytes(sl::MEM::CPU));
+}
+
+#endif
@@ -0,0 +1,356 @@
+#ifndef __COMMON_DEPTH_ARCHIVE__
+#define __COMMON_DEPTH_ARCHIVE__
+
+#include <sl/Camera.hpp>
+#include <frame_source.hpp>
+#include <depth_codec.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Depth archive layout: a DepthArchiveHeader padded to DEPTH_ARCHIVE_ALIGN bytes, one
+// record per frame, then the frame index, an array of DepthArchiveEntry on a
+// DEPTH_ARCHIVE_ALIGN boundary. The index and the final header are written on close, an
+// archive whose index_offset is still 0 was not closed and is rejected. F32 records are
+// page aligned so a reader can map the file and hand out frames in place, encoded
+// records only keep 8 byte alignment.
+#define DEPTH_ARCHIVE_MAGIC "ZEDDEP01"
+#define DEPTH_ARCHIVE_VERSION 1
+#define DEPTH_ARCHIVE_ALIGN 4096
+#define DEPTH_ARCHIVE_EXTENSION ".zdepth"
+// Record payload encodings: F32 rows of row_bytes each, or MM16 (depth_codec.hpp)
+#define DEPTH_CODEC_F32 0
+#define DEPTH_CODEC_MM16 1
+
+struct DepthArchiveHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_bytes;
+    uint32_t width;
+    uint32_t height;
+    uint32_t row_bytes;
+    uint32_t unit;
+    float fps;
+    uint32_t frames;
+    uint64_t index_offset;
+};
+
+struct DepthArchiveEntry
+{
+    uint64_t timestamp_ns;
+    uint64_t offset;
+    uint64_t bytes;
+    uint32_t codec;
+    uint32_t reserved;
+};
+
+static inline uint64_t depth_archive_align(uint64_t offset, uint64_t alignment = DEPTH_ARCHIVE_ALIGN)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+class DepthArchiveReader;
+
+class DepthArchiveWriter
+{
+public:
+    // max_error_mm only applies to DEPTH_CODEC_MM16
+    DepthArchiveWriter(const std::string &filename, float fps, sl::UNIT unit, uint32_t codec = DEPTH_CODEC_F32,
+                       float max_error_mm = 0.f)
+        : filename(filename), codec(codec), encoder(max_error_mm)
+    {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, DEPTH_ARCHIVE_MAGIC, sizeof(header.magic));
+        header.version = DEPTH_ARCHIVE_VERSION;
+        header.entry_bytes = sizeof(DepthArchiveEntry);
+        header.fps = fps;
+        header.unit = (uint32_t)unit;
+    }
+
+    ~DepthArchiveWriter()
+    {
+        close();
+    }
+
+    // The file is created on the first frame, once the depth size is known
+    sl::ERROR_CODE write(uint64_t timestamp_ns, sl::Mat &depth)
+    {
+        if (!file.is_open() && !create((uint32_t)depth.getWidth(), (uint32_t)depth.getHeight()))
+            return sl::ERROR_CODE::SVO_RECORDING_ERROR;
+
+        if (depth.getWidth() != header.width || depth.getHeight() != header.height ||
+            depth.getDataType() != sl::MAT_TYPE::F32_C1)
+            return sl::ERROR_CODE::INVALID_RESOLUTION;
+
+        DepthArchiveEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.timestamp_ns = timestamp_ns;
+        entry.codec = codec;
+
+        TypedView<const float> view(depth);
+        if (codec == DEPTH_CODEC_MM16)
+        {
+            const std::vector<uint8_t> &record =
+                encoder.encode(view.data(), view.stride_bytes(), header.width, header.height,
+                               1000.f / meters_to_unit((sl::UNIT)header.unit));
+            entry.offset = pad_to(depth_archive_align(end, 8));
+            entry.bytes = record.size();
+            file.write(reinterpret_cast<const char *>(record.data()), record.size());
+        }
+        else
+        {
+            entry.offset = pad_to(depth_archive_align(end));
+            entry.bytes = (uint64_t)header.row_bytes * header.height;
+            if (view.stride_bytes() == header.row_bytes)
+                file.write(reinterpret_cast<const char *>(view.data()), entry.bytes);
+            else
+            {
+                for (int row = 0; row < view.height(); ++row)
+                    file.write(reinterpret_cast<const char *>(view.row(row)), header.row_bytes);
+            }
+        }
+        end = entry.offset + entry.bytes;
+        entries.push_back(entry);
+
+        return file.good() ? sl::ERROR_CODE::SUCCESS : sl::ERROR_CODE::SVO_RECORDING_ERROR;
+    }
+
+    // Copies every record of a closed archive of the same size as is, without decoding,
+    // after the frames written so far
+    sl::ERROR_CODE append(const DepthArchiveReader &part);
+
+    // Appends the index and rewrites the header, the archive is readable afterwards
+    void close()
+    {
+        if (!file.is_open())
+            return;
+
+        header.frames = (uint32_t)entries.size();
+        header.index_offset = pad_to(depth_archive_align(end));
+        file.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(DepthArchiveEntry));
+        file.seekp(0);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.close();
+    }
+
+    // Drops the file without an index, so an export failing partway leaves no archive that
+    // reads as complete
+    void discard()
+    {
+        if (!file.is_open())
+            return;
+
+        file.close();
+        std::remove(filename.c_str());
+    }
+
+    uint64_t get_frames_written() const
+    {
+        return entries.size();
+    }
+
+    uint64_t get_bytes_written() const
+    {
+        return end;
+    }
+
+    // Size the frames written so far take as F32
+    uint64_t get_raw_bytes() const
+    {
+        return (uint64_t)entries.size() * header.row_bytes * header.height;
+    }
+
+private:
+    std::string filename;
+    uint32_t codec;
+    DepthEncoder encoder;
+    std::ofstream file;
+    DepthArchiveHeader header;
+    std::vector<DepthArchiveEntry> entries;
+    uint64_t end = 0;
+
+    bool create(uint32_t width, uint32_t height)
+    {
+        header.width = width;
+        header.height = height;
+        header.row_bytes = header.width * sizeof(float);
+
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        end = sizeof(header);
+        return true;
+    }
+
+    uint64_t pad_to(uint64_t offset)
+    {
+        static const char zeros[DEPTH_ARCHIVE_ALIGN] = {};
+        if (offset > end)
+            file.write(zeros, offset - end);
+        end = offset;
+        return offset;
+    }
+};
+
+// Maps a closed archive read only. Opening reads the header alone, frame lookups are
+// O(1) through the index and return pointers into the mapping, valid while the reader
+// lives; writing through them faults. Throws sl::ERROR_CODE::INVALID_SVO_FILE on a
+// foreign or unfinished file.
+class DepthArchiveReader
+{
+public:
+    DepthArchiveReader(const std::string &filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw sl::ERROR_CODE::INVALID_SVO_FILE;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(DepthArchiveHeader))
+        {
+            size = (size_t)info.st_size;
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            base = mapping != MAP_FAILED ? static_cast<const uint8_t *>(mapping) : nullptr;
+        }
+        ::close(fd);
+
+        if (base == nullptr || !validate())
+        {
+            unmap();
+            throw sl::ERROR_CODE::INVALID_SVO_FILE;
+        }
+    }
+
+    ~DepthArchiveReader()
+    {
+        unmap();
+    }
+
+    DepthArchiveReader(const DepthArchiveReader &) = delete;
+    DepthArchiveReader &operator=(const DepthArchiveReader &) = delete;
+
+    int get_frame_count() const
+    {
+        return (int)header->frames;
+    }
+
+    int get_width() const
+    {
+        return (int)header->width;
+    }
+
+    int get_height() const
+    {
+        return (int)header->height;
+    }
+
+    size_t get_row_bytes() const
+    {
+        return header->row_bytes;
+    }
+
+    float get_fps() const
+    {
+        return header->fps;
+    }
+
+    sl::UNIT get_unit() const
+    {
+        return (sl::UNIT)header->unit;
+    }
+
+    const DepthArchiveEntry &entry(int frame_index) const
+    {
+        return index[frame_index];
+    }
+
+    uint64_t get_timestamp(int frame_index) const
+    {
+        return index[frame_index].timestamp_ns;
+    }
+
+    // F32 rows of get_row_bytes() each, nullptr for frames stored with another codec
+    const float *frame(int frame_index) const
+    {
+        const DepthArchiveEntry &record = index[frame_index];
+        if (record.codec != DEPTH_CODEC_F32 || record.bytes < (uint64_t)header->row_bytes * header->height)
+            return nullptr;
+        return reinterpret_cast<const float *>(payload(frame_index));
+    }
+
+    // Encoded record, nullptr when the index points outside the frame area
+    const uint8_t *payload(int frame_index) const
+    {
+        const DepthArchiveEntry &record = index[frame_index];
+        if (record.offset + record.bytes > header->index_offset)
+            return nullptr;
+        return base + record.offset;
+    }
+
+    // Hints the kernel about the access pattern, sequential reads get a larger readahead
+    void advise_sequential(bool sequential) const
+    {
+        madvise(const_cast<uint8_t *>(base), size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    }
+
+private:
+    const uint8_t *base = nullptr;
+    size_t size = 0;
+    const DepthArchiveHeader *header = nullptr;
+    const DepthArchiveEntry *index = nullptr;
+
+    bool validate()
+    {
+        header = reinterpret_cast<const DepthArchiveHeader *>(base);
+        if (std::memcmp(header->magic, DEPTH_ARCHIVE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != DEPTH_ARCHIVE_VERSION || header->entry_bytes != sizeof(DepthArchiveEntry) ||
+            header->index_offset == 0 || header->index_offset % DEPTH_ARCHIVE_ALIGN != 0 ||
+            header->index_offset + (uint64_t)header->frames * sizeof(DepthArchiveEntry) > size)
+            return false;
+
+        index = reinterpret_cast<const DepthArchiveEntry *>(base + header->index_offset);
+        return true;
+    }
+
+    void unmap()
+    {
+        if (base != nullptr)
+            munmap(const_cast<uint8_t *>(base), size);
+        base = nullptr;
+    }
+};
+
+inline sl::ERROR_CODE DepthArchiveWriter::append(const DepthArchiveReader &part)
+{
+    if (part.get_frame_count() == 0)
+        return sl::ERROR_CODE::SUCCESS;
+    if (!file.is_open() && !create((uint32_t)part.get_width(), (uint32_t)part.get_height()))
+        return sl::ERROR_CODE::SVO_RECORDING_ERROR;
+    if ((uint32_t)part.get_width() != header.width || (uint32_t)part.get_height() != header.height)
+        return sl::ERROR_CODE::INVALID_RESOLUTION;
+
+    for (int i = 0; i < part.get_frame_count(); ++i)
+    {
+        const uint8_t *payload = part.payload(i);
+        if (payload == nullptr)
+            return sl::ERROR_CODE::INVALID_SVO_FILE;
+
+        DepthArchiveEntry entry = part.entry(i);
+        entry.offset = pad_to(entry.codec == DEPTH_CODEC_F32 ? depth_archive_align(end) : depth_archive_align(end, 8));
+        file.write(reinterpret_cast<const char *>(payload), entry.bytes);
+        end = entry.offset + entry.bytes;
+        entries.push_back(entry);
+    }
+    return file.good() ? sl::ERROR_CODE::SUCCESS : sl::ERROR_CODE::SVO_RECORDING_ERROR;
+}
+
+#endif
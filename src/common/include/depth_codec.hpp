@@ -0,0 +1,588 @@
+#ifndef __COMMON_DEPTH_CODEC__
+#define __COMMON_DEPTH_CODEC__
+
+#include <depth_stats.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// MM16 depth encoding. Depth is quantized to 16 bit codes of step_mm millimetres, each
+// code is predicted from its left, upper and upper left neighbours (planar predictor)
+// and the residuals are written with an adaptive Golomb-Rice code, zero residuals in
+// runs. NaN and +/-inf pixels are sent apart as runs per row and take their predicted
+// code, so holes neither cost residuals nor disturb the prediction around them. Finite
+// depth comes back within step_mm / 2 up to DEPTH_MM16_MAX_CODE steps (65 m at 1 mm
+// steps), farther depth saturates.
+#define DEPTH_MM16_MAX_CODE 65535
+// Pixel classes of the invalid runs
+#define DEPTH_MM16_VALID 0
+#define DEPTH_MM16_NAN 1
+#define DEPTH_MM16_POS_INF 2
+#define DEPTH_MM16_NEG_INF 3
+// Unary prefix length from which a value is stored verbatim, values fit in 16 bits
+#define DEPTH_MM16_ESCAPE 20
+
+struct DepthCodecHeader
+{
+    uint32_t width;
+    uint32_t height;
+    float step_mm;
+    float mm_to_unit;
+};
+
+// Quantization step keeping the error within max_error_mm, never finer than 1 mm
+static inline float depth_codec_step(float max_error_mm)
+{
+    return std::max(1.f, 2.f * max_error_mm);
+}
+
+// Adaptive Rice parameter, k follows the running mean of the coded values
+struct RiceContext
+{
+    uint32_t sum = 16;
+    uint32_t count = 4;
+
+    int k() const
+    {
+        int k = 0;
+        while ((count << k) < sum && k < 15)
+            ++k;
+        return k;
+    }
+
+    void update(uint32_t value)
+    {
+        sum += value;
+        if (++count == 64)
+        {
+            sum >>= 1;
+            count >>= 1;
+        }
+    }
+};
+
+struct BitWriter
+{
+    uint8_t *out;
+    uint64_t acc = 0;
+    int bits = 0;
+
+    // At most 57 bits per call
+    void put(uint64_t value, int n)
+    {
+        acc = (acc << n) | value;
+        bits += n;
+        while (bits >= 8)
+        {
+            bits -= 8;
+            *out++ = (uint8_t)(acc >> bits);
+        }
+    }
+
+    void finish()
+    {
+        if (bits > 0)
+            *out++ = (uint8_t)(acc << (8 - bits));
+        bits = 0;
+    }
+};
+
+// MSB first reader, reads past the end as zeros and remembers it so a truncated
+// stream is detected at the end of the record
+struct BitReader
+{
+    const uint8_t *ptr;
+    const uint8_t *end;
+    uint64_t acc = 0;
+    int avail = 0;
+    int padded = 0;
+
+    // Leaves at least 57 bits in acc
+    void refill()
+    {
+        if (end - ptr >= 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            acc |= __builtin_bswap64(word) >> avail;
+            ptr += (63 - avail) >> 3;
+            avail |= 56;
+            return;
+        }
+        while (avail <= 56)
+        {
+            uint64_t byte = 0;
+            if (ptr < end)
+                byte = *ptr++;
+            else
+                padded++;
+            acc |= byte << (56 - avail);
+            avail += 8;
+        }
+    }
+
+    uint32_t get(int n)
+    {
+        uint32_t value = (uint32_t)(acc >> (64 - n));
+        acc <<= n;
+        avail -= n;
+        return value;
+    }
+
+    bool overrun() const
+    {
+        return padded * 8 > avail;
+    }
+};
+
+static inline void rice_put(BitWriter &writer, RiceContext &context, uint32_t value)
+{
+    int k = context.k();
+    uint32_t q = value >> k;
+    if (q < DEPTH_MM16_ESCAPE)
+        writer.put((1u << k) | (value & ((1u << k) - 1)), (int)q + 1 + k);
+    else
+        writer.put((1u << 16) | value, DEPTH_MM16_ESCAPE + 1 + 16);
+    context.update(value);
+}
+
+static inline bool rice_get(BitReader &reader, RiceContext &context, uint32_t &value)
+{
+    reader.refill();
+    if (reader.acc == 0)
+        return false;
+    int q = __builtin_clzll(reader.acc);
+    if (q > DEPTH_MM16_ESCAPE)
+        return false;
+    reader.get(q + 1);
+
+    if (q == DEPTH_MM16_ESCAPE)
+        value = reader.get(16);
+    else
+    {
+        int k = context.k();
+        value = (uint32_t)q << k;
+        if (k > 0)
+            value |= reader.get(k);
+    }
+    context.update(value);
+    return true;
+}
+
+static inline uint8_t depth_class(float value)
+{
+    if (std::isnan(value))
+        return DEPTH_MM16_NAN;
+    if (std::isinf(value))
+        return value > 0.f ? DEPTH_MM16_POS_INF : DEPTH_MM16_NEG_INF;
+    return DEPTH_MM16_VALID;
+}
+
+static inline uint16_t depth_quantize(float value, float to_code)
+{
+    float code = value * to_code + 0.5f;
+    if (!(code > 0.f))
+        return 0;
+    return code >= (float)DEPTH_MM16_MAX_CODE ? DEPTH_MM16_MAX_CODE : (uint16_t)code;
+}
+
+struct DepthRun
+{
+    int begin;
+    int end;
+    uint8_t kind;
+};
+
+// Adaptive state shared by encoder and decoder, reset per frame
+struct DepthCodecState
+{
+    RiceContext residual;
+    RiceContext zero_run;
+    RiceContext valid_run;
+    RiceContext invalid_run;
+};
+
+// Encodes float depth into MM16 records, keeping its buffers between frames
+class DepthEncoder
+{
+public:
+    DepthEncoder(float max_error_mm = 0.f)
+        : step_mm(depth_codec_step(max_error_mm))
+    {
+    }
+
+    // Encodes a width x height map with rows stride_bytes apart, stored in units of
+    // unit_to_mm millimetres. The record is valid until the next call.
+    const std::vector<uint8_t> &encode(const float *data, size_t stride_bytes, int width, int height, float unit_to_mm)
+    {
+        DepthCodecHeader header;
+        header.width = (uint32_t)width;
+        header.height = (uint32_t)height;
+        header.step_mm = step_mm;
+        header.mm_to_unit = 1.f / unit_to_mm;
+
+        // Worst case is an escaped value, 37 bits, per pixel plus the run codes of a row
+        out.resize(sizeof(header) + ((size_t)width + 2) * height * (DEPTH_MM16_ESCAPE + 17) / 8 + 8);
+        std::memcpy(out.data(), &header, sizeof(header));
+        previous.assign(width, 0);
+        current.resize(width);
+        kinds.resize(width);
+        zigzag.resize(width);
+
+        float to_code = unit_to_mm / step_mm;
+        BitWriter writer{out.data() + sizeof(header)};
+        DepthCodecState state;
+        for (int row = 0; row < height; ++row)
+        {
+            const float *src = depth_row(data, stride_bytes, row);
+            for (int col = 0; col < width; ++col)
+            {
+                kinds[col] = depth_class(src[col]);
+                current[col] = depth_quantize(src[col], to_code);
+            }
+            put_runs(writer, state, width);
+
+            uint16_t left = 0, up_left = 0;
+            for (int col = 0; col < width; ++col)
+            {
+                uint16_t up = previous[col];
+                uint16_t prediction = (uint16_t)(left + up - up_left);
+                if (kinds[col] != DEPTH_MM16_VALID)
+                    current[col] = prediction;
+                int16_t residual = (int16_t)(uint16_t)(current[col] - prediction);
+                zigzag[col] = (uint16_t)((residual << 1) ^ (residual >> 15));
+                left = current[col];
+                up_left = up;
+            }
+            put_residuals(writer, state, width);
+            std::swap(previous, current);
+        }
+        writer.finish();
+        out.resize(writer.out - out.data());
+        return out;
+    }
+
+    float get_step_mm() const
+    {
+        return step_mm;
+    }
+
+private:
+    float step_mm;
+    std::vector<uint8_t> out;
+    std::vector<uint16_t> previous;
+    std::vector<uint16_t> current;
+    std::vector<uint8_t> kinds;
+    std::vector<uint16_t> zigzag;
+
+    // Alternating valid and invalid run lengths, each invalid run led by its class
+    void put_runs(BitWriter &writer, DepthCodecState &state, int width)
+    {
+        int col = 0;
+        while (col < width)
+        {
+            int begin = col;
+            while (col < width && kinds[col] == DEPTH_MM16_VALID)
+                ++col;
+            rice_put(writer, state.valid_run, col - begin);
+            if (col == width)
+                break;
+
+            uint8_t kind = kinds[col];
+            begin = col;
+            while (col < width && kinds[col] == kind)
+                ++col;
+            writer.put(kind - 1, 2);
+            rice_put(writer, state.invalid_run, col - begin - 1);
+        }
+    }
+
+    // A zero residual with k at 0 switches to run mode: the length of the zero run
+    // follows, then the residual ending it, known to be non zero, minus one
+    void put_residuals(BitWriter &writer, DepthCodecState &state, int width)
+    {
+        bool last_zero = false;
+        int col = 0;
+        while (col < width)
+        {
+            if (last_zero && state.residual.k() == 0)
+            {
+                int begin = col;
+                while (col < width && zigzag[col] == 0)
+                    ++col;
+                rice_put(writer, state.zero_run, col - begin);
+                last_zero = false;
+                if (col < width)
+                    rice_put(writer, state.residual, zigzag[col++] - 1u);
+                continue;
+            }
+            rice_put(writer, state.residual, zigzag[col]);
+            last_zero = zigzag[col++] == 0;
+        }
+    }
+};
+
+// Decoding runs in passes per row: the Rice codes are read serially into runs and
+// zigzag residuals, then the row is rebuilt and converted to float with SIMD and the
+// invalid runs are filled in. Along a row the planar predictor reduces to a prefix sum
+// of the residuals added to the row above.
+static void depth_reconstruct_scalar(const uint16_t *zigzag, const uint16_t *up, uint16_t *out, int begin, int width,
+                                     uint16_t carry)
+{
+    for (int col = begin; col < width; ++col)
+    {
+        uint16_t z = zigzag[col];
+        carry += (uint16_t)((z >> 1) ^ (uint16_t)(0 - (z & 1)));
+        out[col] = (uint16_t)(up[col] + carry);
+    }
+}
+
+static void depth_dequantize_scalar(const uint16_t *codes, float *dst, int begin, int width, float scale)
+{
+    for (int col = begin; col < width; ++col)
+        dst[col] = (float)codes[col] * scale;
+}
+
+#if defined(DEPTH_STATS_X86)
+__attribute__((target("sse4.1"))) static void depth_reconstruct_sse41(const uint16_t *zigzag, const uint16_t *up,
+                                                                      uint16_t *out, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i last_lane = _mm_set1_epi16(0x0f0e);
+    __m128i carry = zero;
+    int col = 0;
+    for (; col + 8 <= width; col += 8)
+    {
+        __m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i *>(zigzag + col));
+        __m128i r = _mm_xor_si128(_mm_srli_epi16(z, 1), _mm_sub_epi16(zero, _mm_and_si128(z, one)));
+        r = _mm_add_epi16(r, _mm_slli_si128(r, 2));
+        r = _mm_add_epi16(r, _mm_slli_si128(r, 4));
+        r = _mm_add_epi16(r, _mm_slli_si128(r, 8));
+        r = _mm_add_epi16(r, carry);
+        carry = _mm_shuffle_epi8(r, last_lane);
+        __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i *>(up + col));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + col), _mm_add_epi16(r, above));
+    }
+    depth_reconstruct_scalar(zigzag, up, out, col, width, (uint16_t)_mm_extract_epi16(carry, 0));
+}
+
+__attribute__((target("sse4.1"))) static void depth_dequantize_sse41(const uint16_t *codes, float *dst, int width,
+                                                                     float scale)
+{
+    const __m128 factor = _mm_set1_ps(scale);
+    int col = 0;
+    for (; col + 8 <= width; col += 8)
+    {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + col));
+        __m128i lo = _mm_cvtepu16_epi32(packed);
+        __m128i hi = _mm_cvtepu16_epi32(_mm_srli_si128(packed, 8));
+        _mm_storeu_ps(dst + col, _mm_mul_ps(_mm_cvtepi32_ps(lo), factor));
+        _mm_storeu_ps(dst + col + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), factor));
+    }
+    depth_dequantize_scalar(codes, dst, col, width, scale);
+}
+
+__attribute__((target("avx2"))) static void depth_dequantize_avx2(const uint16_t *codes, float *dst, int width,
+                                                                  float scale)
+{
+    const __m256 factor = _mm256_set1_ps(scale);
+    int col = 0;
+    for (; col + 16 <= width; col += 16)
+    {
+        __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes + col));
+        __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(packed));
+        __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(packed, 1));
+        _mm256_storeu_ps(dst + col, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), factor));
+        _mm256_storeu_ps(dst + col + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), factor));
+    }
+    depth_dequantize_scalar(codes, dst, col, width, scale);
+}
+#endif
+
+#if defined(DEPTH_STATS_NEON)
+static void depth_reconstruct_neon(const uint16_t *zigzag, const uint16_t *up, uint16_t *out, int width)
+{
+    const uint16x8_t zero = vdupq_n_u16(0);
+    const uint16x8_t one = vdupq_n_u16(1);
+    uint16x8_t carry = zero;
+    int col = 0;
+    for (; col + 8 <= width; col += 8)
+    {
+        uint16x8_t z = vld1q_u16(zigzag + col);
+        uint16x8_t r = veorq_u16(vshrq_n_u16(z, 1), vsubq_u16(zero, vandq_u16(z, one)));
+        r = vaddq_u16(r, vextq_u16(zero, r, 7));
+        r = vaddq_u16(r, vextq_u16(zero, r, 6));
+        r = vaddq_u16(r, vextq_u16(zero, r, 4));
+        r = vaddq_u16(r, carry);
+        carry = vdupq_laneq_u16(r, 7);
+        vst1q_u16(out + col, vaddq_u16(r, vld1q_u16(up + col)));
+    }
+    depth_reconstruct_scalar(zigzag, up, out, col, width, vgetq_lane_u16(carry, 0));
+}
+
+static void depth_dequantize_neon(const uint16_t *codes, float *dst, int width, float scale)
+{
+    int col = 0;
+    for (; col + 8 <= width; col += 8)
+    {
+        uint16x8_t packed = vld1q_u16(codes + col);
+        vst1q_f32(dst + col, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(packed))), scale));
+        vst1q_f32(dst + col + 4, vmulq_n_f32(vcvtq_f32_u32(vmovl_high_u16(packed)), scale));
+    }
+    depth_dequantize_scalar(codes, dst, col, width, scale);
+}
+#endif
+
+// Decodes MM16 records, keeping its row buffers between frames
+class DepthDecoder
+{
+public:
+    DepthDecoder()
+        : level(detect_simd_level())
+    {
+    }
+
+    DepthDecoder(SimdLevel level)
+        : level(level)
+    {
+    }
+
+    // Decodes a record into a width x height map with rows stride_bytes apart, in the
+    // unit the depth was encoded from. False on a size mismatch or a corrupt record.
+    bool decode(const uint8_t *data, size_t bytes, float *dst, size_t stride_bytes, int width, int height)
+    {
+        DepthCodecHeader header;
+        if (data == nullptr || bytes < sizeof(header))
+            return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.width != (uint32_t)width || header.height != (uint32_t)height)
+            return false;
+
+        zigzag.resize(width);
+        previous.assign(width, 0);
+        current.resize(width);
+
+        float scale = header.step_mm * header.mm_to_unit;
+        BitReader reader{data + sizeof(header), data + bytes};
+        DepthCodecState state;
+        for (int row = 0; row < height; ++row)
+        {
+            if (!get_runs(reader, state, width) || !get_residuals(reader, state, width))
+                return false;
+
+            float *out = reinterpret_cast<float *>(reinterpret_cast<unsigned char *>(dst) + row * stride_bytes);
+            reconstruct(out, width, scale);
+            for (const DepthRun &run : runs)
+                std::fill(out + run.begin, out + run.end, invalid_value(run.kind));
+            std::swap(previous, current);
+        }
+        return !reader.overrun();
+    }
+
+    SimdLevel get_level() const
+    {
+        return level;
+    }
+
+private:
+    SimdLevel level;
+    std::vector<uint16_t> zigzag;
+    std::vector<uint16_t> previous;
+    std::vector<uint16_t> current;
+    std::vector<DepthRun> runs;
+
+    static float invalid_value(uint8_t kind)
+    {
+        if (kind == DEPTH_MM16_POS_INF)
+            return std::numeric_limits<float>::infinity();
+        if (kind == DEPTH_MM16_NEG_INF)
+            return -std::numeric_limits<float>::infinity();
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+
+    bool get_runs(BitReader &reader, DepthCodecState &state, int width)
+    {
+        runs.clear();
+        int col = 0;
+        while (col < width)
+        {
+            uint32_t length;
+            if (!rice_get(reader, state.valid_run, length) || length > (uint32_t)(width - col))
+                return false;
+            col += (int)length;
+            if (col == width)
+                return true;
+
+            reader.refill();
+            uint8_t kind = (uint8_t)(reader.get(2) + 1);
+            if (kind > DEPTH_MM16_NEG_INF || !rice_get(reader, state.invalid_run, length) ||
+                length >= (uint32_t)(width - col))
+                return false;
+            runs.push_back(DepthRun{col, col + (int)length + 1, kind});
+            col += (int)length + 1;
+        }
+        return true;
+    }
+
+    bool get_residuals(BitReader &reader, DepthCodecState &state, int width)
+    {
+        bool last_zero = false;
+        int col = 0;
+        uint32_t value;
+        while (col < width)
+        {
+            if (last_zero && state.residual.k() == 0)
+            {
+                if (!rice_get(reader, state.zero_run, value) || value > (uint32_t)(width - col))
+                    return false;
+                std::fill(zigzag.begin() + col, zigzag.begin() + col + value, 0);
+                col += (int)value;
+                last_zero = false;
+                if (col < width)
+                {
+                    if (!rice_get(reader, state.residual, value))
+                        return false;
+                    zigzag[col++] = (uint16_t)(value + 1);
+                }
+                continue;
+            }
+            if (!rice_get(reader, state.residual, value))
+                return false;
+            zigzag[col++] = (uint16_t)value;
+            last_zero = value == 0;
+        }
+        return true;
+    }
+
+    void reconstruct(float *out, int width, float scale)
+    {
+        switch (level)
+        {
+#if defined(DEPTH_STATS_X86)
+        case SimdLevel::AVX2:
+            depth_reconstruct_sse41(zigzag.data(), previous.data(), current.data(), width);
+            depth_dequantize_avx2(current.data(), out, width, scale);
+            return;
+        case SimdLevel::SSE41:
+            depth_reconstruct_sse41(zigzag.data(), previous.data(), current.data(), width);
+            depth_dequantize_sse41(current.data(), out, width, scale);
+            return;
+#endif
+#if defined(DEPTH_STATS_NEON)
+        case SimdLevel::NEON:
+            depth_reconstruct_neon(zigzag.data(), previous.data(), current.data(), width);
+            depth_dequantize_neon(current.data(), out, width, scale);
+            return;
+#endif
+        default:
+            depth_reconstruct_scalar(zigzag.data(), previous.data(), current.data(), 0, width, 0);
+            depth_dequantize_scalar(current.data(), out, 0, width, scale);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef __COMMON_DEPTH_COLORMAP__
+#define __COMMON_DEPTH_COLORMAP__
+
+#include <depth_stats.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+#define DEPTH_COLORMAP_SIZE 4096
+
+// Colorizes F32 depth straight through a jet lookup table, red at near_depth to blue at
+// far_depth, as cvtColor + applyColorMap(COLORMAP_JET) did on sl::VIEW::DEPTH. Depth
+// beyond the range is clamped to its ends, so +inf is blue and -inf red, NaN is black.
+// The depth is sampled at the output size, pixels that are not shown are never read.
+class DepthColormap
+{
+public:
+    DepthColormap(float near_depth, float far_depth)
+    {
+        for (int i = 0; i < DEPTH_COLORMAP_SIZE; ++i)
+        {
+            // Index 0 is the nearest depth, the hot end of jet
+            float t = 1.f - (float)i / (DEPTH_COLORMAP_SIZE - 1);
+            lut[i][0] = jet_channel(t, 1.f);
+            lut[i][1] = jet_channel(t, 2.f);
+            lut[i][2] = jet_channel(t, 3.f);
+        }
+        set_range(near_depth, far_depth);
+    }
+
+    // In the depth unit
+    void set_range(float near_depth, float far_depth)
+    {
+        this->near_depth = near_depth;
+        scale = far_depth > near_depth ? (DEPTH_COLORMAP_SIZE - 1) / (far_depth - near_depth) : 0.f;
+    }
+
+    // BGR rendering of a width x height depth map with rows stride_bytes apart into
+    // out_width x out_height pixels with rows out_stride bytes apart, nearest sampling.
+    void render(const float *depth, size_t stride_bytes, int width, int height, uint8_t *bgr, size_t out_stride,
+                int out_width, int out_height)
+    {
+        if (source_cols.size() != (size_t)out_width || sampled_width != width)
+        {
+            source_cols.resize(out_width);
+            for (int col = 0; col < out_width; ++col)
+                source_cols[col] = (int)(((int64_t)col * width + width / 2) / out_width);
+            sampled_width = width;
+        }
+
+        const float top = DEPTH_COLORMAP_SIZE - 1;
+        for (int row = 0; row < out_height; ++row)
+        {
+            const float *src = depth_row(depth, stride_bytes, (int)(((int64_t)row * height + height / 2) / out_height));
+            uint8_t *dst = bgr + (size_t)row * out_stride;
+            for (int col = 0; col < out_width; ++col, dst += 3)
+            {
+                float d = src[source_cols[col]];
+                if (d != d)
+                {
+                    dst[0] = dst[1] = dst[2] = 0;
+                    continue;
+                }
+                const uint8_t *color = lut[(int)std::min(std::max((d - near_depth) * scale, 0.f), top)];
+                dst[0] = color[0];
+                dst[1] = color[1];
+                dst[2] = color[2];
+            }
+        }
+    }
+
+private:
+    uint8_t lut[DEPTH_COLORMAP_SIZE][3];
+    float near_depth = 0.f;
+    float scale = 0.f;
+    std::vector<int> source_cols;
+    int sampled_width = 0;
+
+    // Piecewise linear jet: blue peaks at t = 0.25, green at 0.5 and red at 0.75
+    static uint8_t jet_channel(float t, float center)
+    {
+        float value = 1.5f - std::fabs(4.f * t - center);
+        return (uint8_t)(255.f * std::min(std::max(value, 0.f), 1.f) + 0.5f);
+    }
+};
+
+#endif
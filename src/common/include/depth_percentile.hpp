@@ -0,0 +1,82 @@
+#ifndef __COMMON_DEPTH_PERCENTILE__
+#define __COMMON_DEPTH_PERCENTILE__
+
+#include <depth_stats.hpp>
+#include <algorithm>
+#include <vector>
+
+#define PERCENTILE_BINS 4096
+
+// Exact percentiles of the valid pixels of a depth region. A fixed-bin histogram over
+// [min, max] locates the bin holding the requested rank, then only the values of that
+// bin are gathered into the scratch buffer and ordered with nth_element. The scratch
+// buffer only grows, so steady state frames do not allocate.
+class PercentileEstimator
+{
+public:
+    PercentileEstimator(size_t reserve = 0)
+        : histogram(PERCENTILE_BINS)
+    {
+        scratch.reserve(reserve);
+    }
+
+    // Nearest rank value at `quantile` in [0, 1], NaN when the region has no valid pixel
+    float percentile(const float *data, size_t stride_bytes, int width, int height, float quantile)
+    {
+        DepthStats stats = compute_depth_stats(data, stride_bytes, width, height);
+        if (stats.valid == 0)
+            return std::numeric_limits<float>::quiet_NaN();
+        if (stats.min == stats.max)
+            return stats.min;
+
+        quantile = std::min(std::max(quantile, 0.f), 1.f);
+        uint64_t rank = (uint64_t)(quantile * (float)(stats.valid - 1) + 0.5f);
+
+        const float min = stats.min;
+        const float scale = (float)PERCENTILE_BINS / (stats.max - stats.min);
+        std::fill(histogram.begin(), histogram.end(), 0);
+
+        for (int row = 0; row < height; ++row)
+        {
+            const float *src = depth_row(data, stride_bytes, row);
+            for (int col = 0; col < width; ++col)
+            {
+                float value = src[col];
+                if (std::isfinite(value))
+                    histogram[bin(value, min, scale)]++;
+            }
+        }
+
+        int target = 0;
+        uint64_t below = 0;
+        while (below + histogram[target] <= rank)
+            below += histogram[target++];
+
+        scratch.clear();
+        for (int row = 0; row < height; ++row)
+        {
+            const float *src = depth_row(data, stride_bytes, row);
+            for (int col = 0; col < width; ++col)
+            {
+                float value = src[col];
+                if (std::isfinite(value) && bin(value, min, scale) == target)
+                    scratch.push_back(value);
+            }
+        }
+
+        auto nth = scratch.begin() + (rank - below);
+        std::nth_element(scratch.begin(), nth, scratch.end());
+        return *nth;
+    }
+
+private:
+    std::vector<uint32_t> histogram;
+    std::vector<float> scratch;
+
+    static int bin(float value, float min, float scale)
+    {
+        return std::min((int)((value - min) * scale), PERCENTILE_BINS - 1);
+    }
+};
+
+#endif
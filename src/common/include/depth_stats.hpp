@@ -0,0 +1,314 @@
+#ifndef __COMMON_DEPTH_STATS__
+#define __COMMON_DEPTH_STATS__
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DEPTH_STATS_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define DEPTH_STATS_NEON
+#endif
+
+// One pass statistics over a float depth region. NaN and +/-inf pixels (occlusions,
+// out of range) are masked out. Sums are accumulated in double so full frame sums of
+// squares in millimeters keep their precision.
+struct DepthStats
+{
+    uint64_t valid = 0;
+    uint64_t total = 0;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+
+    double mean() const
+    {
+        return valid > 0 ? sum / (double)valid : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double variance() const
+    {
+        if (valid == 0)
+            return std::numeric_limits<double>::quiet_NaN();
+        double m = mean();
+        return std::max(sum_sq / (double)valid - m * m, 0.0);
+    }
+
+    double valid_fraction() const
+    {
+        return total > 0 ? (double)valid / (double)total : 0.0;
+    }
+
+    void merge(const DepthStats &other)
+    {
+        valid += other.valid;
+        total += other.total;
+        sum += other.sum;
+        sum_sq += other.sum_sq;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+};
+
+enum class SimdLevel
+{
+    SCALAR,
+    SSE41,
+    AVX2,
+    NEON
+};
+
+static inline const char *simd_level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::SSE41:
+        return "sse4.1";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::NEON:
+        return "neon";
+    default:
+        return "scalar";
+    }
+}
+
+static inline SimdLevel detect_simd_level()
+{
+#if defined(DEPTH_STATS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return SimdLevel::SSE41;
+    return SimdLevel::SCALAR;
+#elif defined(DEPTH_STATS_NEON)
+    return SimdLevel::NEON;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+static inline const float *depth_row(const float *data, size_t stride_bytes, int row)
+{
+    return reinterpret_cast<const float *>(reinterpret_cast<const unsigned char *>(data) + row * stride_bytes);
+}
+
+static inline void depth_stats_tail(const float *row, int begin, int end, DepthStats &stats)
+{
+    for (int col = begin; col < end; ++col)
+    {
+        float value = row[col];
+        if (!std::isfinite(value))
+            continue;
+        stats.valid++;
+        stats.sum += value;
+        stats.sum_sq += (double)value * value;
+        stats.min = std::min(stats.min, value);
+        stats.max = std::max(stats.max, value);
+    }
+}
+
+static DepthStats depth_stats_scalar(const float *data, size_t stride_bytes, int width, int height)
+{
+    DepthStats stats;
+    for (int row = 0; row < height; ++row)
+        depth_stats_tail(depth_row(data, stride_bytes, row), 0, width, stats);
+    stats.total = (uint64_t)width * height;
+    return stats;
+}
+
+#if defined(DEPTH_STATS_X86)
+__attribute__((target("sse4.1"))) static DepthStats depth_stats_sse41(const float *data, size_t stride_bytes, int width, int height)
+{
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 neg_inf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+    __m128d sum = _mm_setzero_pd();
+    __m128d sum_sq = _mm_setzero_pd();
+    __m128 vmin = inf;
+    __m128 vmax = neg_inf;
+    DepthStats stats;
+
+    for (int row = 0; row < height; ++row)
+    {
+        const float *src = depth_row(data, stride_bytes, row);
+        int col = 0;
+        for (; col + 4 <= width; col += 4)
+        {
+            __m128 x = _mm_loadu_ps(src + col);
+            // |x| < inf is false for NaN and both infinities
+            __m128 valid = _mm_cmplt_ps(_mm_and_ps(x, abs_mask), inf);
+            __m128 masked = _mm_and_ps(x, valid);
+
+            stats.valid += (uint64_t)__builtin_popcount(_mm_movemask_ps(valid));
+
+            __m128d lo = _mm_cvtps_pd(masked);
+            __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(masked, masked));
+            sum = _mm_add_pd(sum, _mm_add_pd(lo, hi));
+            sum_sq = _mm_add_pd(sum_sq, _mm_add_pd(_mm_mul_pd(lo, lo), _mm_mul_pd(hi, hi)));
+
+            vmin = _mm_min_ps(vmin, _mm_blendv_ps(inf, x, valid));
+            vmax = _mm_max_ps(vmax, _mm_blendv_ps(neg_inf, x, valid));
+        }
+        depth_stats_tail(src, col, width, stats);
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+    stats.sum += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sum_sq);
+    stats.sum_sq += lanes[0] + lanes[1];
+
+    float extremes[4];
+    _mm_storeu_ps(extremes, vmin);
+    for (float value : extremes)
+        stats.min = std::min(stats.min, value);
+    _mm_storeu_ps(extremes, vmax);
+    for (float value : extremes)
+        stats.max = std::max(stats.max, value);
+
+    stats.total = (uint64_t)width * height;
+    return stats;
+}
+
+__attribute__((target("avx2"))) static DepthStats depth_stats_avx2(const float *data, size_t stride_bytes, int width, int height)
+{
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    const __m256 neg_inf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+
+    __m256d sum = _mm256_setzero_pd();
+    __m256d sum_sq = _mm256_setzero_pd();
+    __m256 vmin = inf;
+    __m256 vmax = neg_inf;
+    DepthStats stats;
+
+    for (int row = 0; row < height; ++row)
+    {
+        const float *src = depth_row(data, stride_bytes, row);
+        int col = 0;
+        for (; col + 8 <= width; col += 8)
+        {
+            __m256 x = _mm256_loadu_ps(src + col);
+            __m256 valid = _mm256_cmp_ps(_mm256_and_ps(x, abs_mask), inf, _CMP_LT_OQ);
+            __m256 masked = _mm256_and_ps(x, valid);
+
+            stats.valid += (uint64_t)__builtin_popcount(_mm256_movemask_ps(valid));
+
+            __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(masked));
+            __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(masked, 1));
+            sum = _mm256_add_pd(sum, _mm256_add_pd(lo, hi));
+            sum_sq = _mm256_add_pd(sum_sq, _mm256_add_pd(_mm256_mul_pd(lo, lo), _mm256_mul_pd(hi, hi)));
+
+            vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(inf, x, valid));
+            vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(neg_inf, x, valid));
+        }
+        depth_stats_tail(src, col, width, stats);
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum);
+    stats.sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_pd(lanes, sum_sq);
+    stats.sum_sq += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    float extremes[8];
+    _mm256_storeu_ps(extremes, vmin);
+    for (float value : extremes)
+        stats.min = std::min(stats.min, value);
+    _mm256_storeu_ps(extremes, vmax);
+    for (float value : extremes)
+        stats.max = std::max(stats.max, value);
+
+    stats.total = (uint64_t)width * height;
+    return stats;
+}
+#endif
+
+#if defined(DEPTH_STATS_NEON)
+static DepthStats depth_stats_neon(const float *data, size_t stride_bytes, int width, int height)
+{
+    const float32x4_t inf = vdupq_n_f32(std::numeric_limits<float>::infinity());
+    const float32x4_t neg_inf = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+
+    float64x2_t sum = vdupq_n_f64(0.0);
+    float64x2_t sum_sq = vdupq_n_f64(0.0);
+    float32x4_t vmin = inf;
+    float32x4_t vmax = neg_inf;
+    uint32x4_t count = vdupq_n_u32(0);
+    DepthStats stats;
+
+    for (int row = 0; row < height; ++row)
+    {
+        const float *src = depth_row(data, stride_bytes, row);
+        int col = 0;
+        for (; col + 4 <= width; col += 4)
+        {
+            float32x4_t x = vld1q_f32(src + col);
+            uint32x4_t valid = vcltq_f32(vabsq_f32(x), inf);
+            float32x4_t masked = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(x), valid));
+
+            // valid lanes are all ones, i.e. -1
+            count = vsubq_u32(count, valid);
+
+            float64x2_t lo = vcvt_f64_f32(vget_low_f32(masked));
+            float64x2_t hi = vcvt_high_f64_f32(masked);
+            sum = vaddq_f64(sum, vaddq_f64(lo, hi));
+            sum_sq = vfmaq_f64(vfmaq_f64(sum_sq, lo, lo), hi, hi);
+
+            vmin = vminq_f32(vmin, vbslq_f32(valid, x, inf));
+            vmax = vmaxq_f32(vmax, vbslq_f32(valid, x, neg_inf));
+        }
+        depth_stats_tail(src, col, width, stats);
+
+        // Flush the 32 bit lane counters before they can overflow
+        stats.valid += vaddlvq_u32(count);
+        count = vdupq_n_u32(0);
+    }
+
+    stats.sum += vaddvq_f64(sum);
+    stats.sum_sq += vaddvq_f64(sum_sq);
+    stats.min = std::min(stats.min, vminvq_f32(vmin));
+    stats.max = std::max(stats.max, vmaxvq_f32(vmax));
+    stats.total = (uint64_t)width * height;
+    return stats;
+}
+#endif
+
+// Statistics over a `width` x `height` region starting at `data`, rows `stride_bytes` apart
+static DepthStats compute_depth_stats(const float *data, size_t stride_bytes, int width, int height,
+                                      SimdLevel level)
+{
+    switch (level)
+    {
+#if defined(DEPTH_STATS_X86)
+    case SimdLevel::AVX2:
+        return depth_stats_avx2(data, stride_bytes, width, height);
+    case SimdLevel::SSE41:
+        return depth_stats_sse41(data, stride_bytes, width, height);
+#endif
+#if defined(DEPTH_STATS_NEON)
+    case SimdLevel::NEON:
+        return depth_stats_neon(data, stride_bytes, width, height);
+#endif
+    default:
+        return depth_stats_scalar(data, stride_bytes, width, height);
+    }
+}
+
+// Same as above with the best kernel the running CPU supports, detected once
+static inline DepthStats compute_depth_stats(const float *data, size_t stride_bytes, int width, int height)
+{
+    static const SimdLevel level = detect_simd_level();
+    return compute_depth_stats(data, stride_bytes, width, height, level);
+}
+
+#endif
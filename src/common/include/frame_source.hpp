@@ -0,0 +1,254 @@
+#ifndef __COMMON_FRAME_SOURCE__
+#define __COMMON_FRAME_SOURCE__
+
+#include <sl/Camera.hpp>
+#include <raw_frame.hpp>
+#include <camera_intrinsics.hpp>
+#include <mat_types.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cmath>
+
+// Frame provider consumed by the grab loops of every tool. Implementations wrap a
+// live ZED or SVO file (ZedFrameSource), a deterministic generator (SyntheticFrameSource)
+// or a raw frame dump (RawFrameSource), so the same loop runs with or without a camera.
+class FrameSource
+{
+public:
+    virtual ~FrameSource()
+    {
+        disable_recording();
+    }
+
+    sl::ERROR_CODE grab(sl::RuntimeParameters &params)
+    {
+        auto err = grab_frame(params);
+        if (err == sl::ERROR_CODE::SUCCESS && raw_writer)
+            err = write_raw_frame(params.enable_depth);
+        return err;
+    }
+
+    // Filenames ending in ".raw" produce a raw frame dump with any source,
+    // everything else is handed to the SDK SVO recorder.
+    sl::ERROR_CODE enable_recording(const std::string &filename,
+                                    sl::SVO_COMPRESSION_MODE mode = sl::SVO_COMPRESSION_MODE::H264)
+    {
+        if (is_raw_filename(filename))
+        {
+            raw_writer = std::make_unique<RawFrameWriter>(filename, (uint32_t)get_fps(), get_unit());
+            return sl::ERROR_CODE::SUCCESS;
+        }
+        return enable_svo_recording(filename, mode);
+    }
+
+    // Creates the raw dump `filename` without recording to it yet, so a caller rolling
+    // over to a new file can open it away from the grab thread. nullptr for SVO names,
+    // the SDK cannot open a recording ahead of time.
+    std::unique_ptr<RawFrameWriter> prepare_recording(const std::string &filename)
+    {
+        if (!is_raw_filename(filename))
+            return nullptr;
+        auto writer = std::make_unique<RawFrameWriter>(filename, (uint32_t)get_fps(), get_unit());
+        if (!writer->create())
+            return nullptr;
+        return writer;
+    }
+
+    // Continues the recording in `filename` from the next grab. `writer` holds the dump
+    // prepared for it, or nullptr to open it here, and returns with the previous raw dump
+    // still open so the caller can close it elsewhere. SVO recordings are switched in place
+    // since the SDK records a single file per camera, `writer` then returns nullptr.
+    sl::ERROR_CODE switch_recording(const std::string &filename, std::unique_ptr<RawFrameWriter> &writer,
+                                    sl::SVO_COMPRESSION_MODE mode = sl::SVO_COMPRESSION_MODE::H264)
+    {
+        if (!is_raw_filename(filename))
+        {
+            disable_recording();
+            writer.reset();
+            return enable_svo_recording(filename, mode);
+        }
+
+        if (!writer)
+            writer = std::make_unique<RawFrameWriter>(filename, (uint32_t)get_fps(), get_unit());
+        std::swap(writer, raw_writer);
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+    void disable_recording()
+    {
+        if (raw_writer)
+        {
+            raw_writer->close();
+            raw_writer.reset();
+        }
+        else
+            disable_svo_recording();
+    }
+
+    virtual sl::ERROR_CODE retrieve_image(sl::Mat &image, sl::VIEW view = sl::VIEW::LEFT) = 0;
+    virtual sl::ERROR_CODE retrieve_measure(sl::Mat &measure, sl::MEASURE type = sl::MEASURE::DEPTH) = 0;
+    virtual sl::ERROR_CODE get_sensors_data(sl::SensorsData &data, sl::TIME_REFERENCE reference) = 0;
+    virtual sl::Timestamp get_timestamp(sl::TIME_REFERENCE reference) = 0;
+
+    // Index of the last grabbed frame, the next grab returns frame `position`
+    // after set_position. get_frame_count is -1 for unbounded sources.
+    virtual int get_position() = 0;
+    virtual void set_position(int position) = 0;
+    virtual int get_frame_count() = 0;
+
+    virtual float get_fps() = 0;
+    virtual float get_current_fps() = 0;
+    virtual sl::UNIT get_unit() = 0;
+    // Size of the left image, known before the first grab
+    virtual sl::Resolution get_resolution() = 0;
+
+    // Timestamp and sensor values of the last grabbed frame as stored in raw dumps
+    void get_raw_header(RawFrameHeader &frame)
+    {
+        std::memset(&frame, 0, sizeof(frame));
+        frame.timestamp_ns = get_timestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+
+        sl::SensorsData data;
+        if (get_sensors_data(data, sl::TIME_REFERENCE::IMAGE) == sl::ERROR_CODE::SUCCESS)
+            sensors_to_raw(data, frame);
+    }
+
+    // Left camera intrinsics, INVALID_CALIBRATION_FILE when the source does not carry them
+    // (raw dumps and depth archives) and a stored calibration is needed instead
+    virtual sl::ERROR_CODE get_intrinsics(CameraIntrinsics &intrinsics)
+    {
+        return sl::ERROR_CODE::INVALID_CALIBRATION_FILE;
+    }
+
+    // Underlying SDK handle, nullptr when the frames do not come from the SDK
+    virtual sl::Camera *get_camera()
+    {
+        return nullptr;
+    }
+
+protected:
+    virtual sl::ERROR_CODE grab_frame(sl::RuntimeParameters &params) = 0;
+
+    virtual sl::ERROR_CODE enable_svo_recording(const std::string &filename, sl::SVO_COMPRESSION_MODE mode)
+    {
+        return sl::ERROR_CODE::INVALID_FUNCTION_PARAMETERS;
+    }
+
+    virtual void disable_svo_recording()
+    {
+    }
+
+    static bool is_raw_filename(const std::string &filename)
+    {
+        const std::string ext(".raw");
+        return filename.size() >= ext.size() &&
+               filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+    }
+
+    static void ensure_mat(sl::Mat &mat, size_t width, size_t height, sl::MAT_TYPE type)
+    {
+        if (!mat.isInit() || mat.getWidth() != width || mat.getHeight() != height || mat.getDataType() != type)
+            mat.alloc(width, height, type, sl::MEM::CPU);
+    }
+
+    // Grayscale BGRA rendering of a depth map, near is bright as in sl::VIEW::DEPTH
+    static void render_depth_view(sl::Mat &depth, sl::Mat &view, float max_depth)
+    {
+        ensure_mat(view, depth.getWidth(), depth.getHeight(), sl::MAT_TYPE::U8_C4);
+        TypedView<const float> src_view(depth);
+        TypedView<sl::uchar4> dst_view(view);
+
+        for (int row = 0; row < src_view.height(); ++row)
+        {
+            const float *src = src_view.row(row);
+            sl::uchar4 *dst = dst_view.row(row);
+            for (int col = 0; col < src_view.width(); ++col)
+            {
+                float d = src[col];
+                unsigned char gray = 0;
+                if (std::isfinite(d) && d > 0.f)
+                    gray = (unsigned char)(255.f * (1.f - std::min(d / max_depth, 1.f)));
+                dst[col].x = gray;
+                dst[col].y = gray;
+                dst[col].z = gray;
+                dst[col].w = 255;
+            }
+        }
+    }
+
+    static void compose_side_by_side(sl::Mat &left, sl::Mat &right, sl::Mat &image)
+    {
+        ensure_mat(image, 2 * left.getWidth(), left.getHeight(), sl::MAT_TYPE::U8_C4);
+        TypedView<const sl::uchar4> l(left), r(right);
+        TypedView<sl::uchar4> dst(image);
+
+        int width = l.width();
+        for (int row = 0; row < l.height(); ++row)
+        {
+            std::copy(l.row(row), l.row(row) + width, dst.row(row));
+            std::copy(r.row(row), r.row(row) + width, dst.row(row) + width);
+        }
+    }
+
+private:
+    std::unique_ptr<RawFrameWriter> raw_writer;
+    sl::Mat raw_left, raw_right, raw_depth;
+
+    sl::ERROR_CODE write_raw_frame(bool with_depth)
+    {
+        RawFrameHeader frame;
+        get_raw_header(frame);
+
+        auto err = retrieve_image(raw_left, sl::VIEW::LEFT);
+        if (err == sl::ERROR_CODE::SUCCESS)
+            err = retrieve_image(raw_right, sl::VIEW::RIGHT);
+        if (err != sl::ERROR_CODE::SUCCESS)
+            return err;
+        bool depth_ok = with_depth && retrieve_measure(raw_depth, sl::MEASURE::DEPTH) == sl::ERROR_CODE::SUCCESS;
+
+        return raw_writer->write(frame, raw_left, raw_right, depth_ok ? &raw_depth : nullptr, with_depth);
+    }
+};
+
+// Coordinate unit named on the command line, millimeters for anything unknown
+static inline sl::UNIT string2unit(const std::string &s_unit)
+{
+    if (s_unit.compare("milli") == 0)
+        return sl::UNIT::MILLIMETER;
+
+    else if (s_unit.compare("centi") == 0)
+        return sl::UNIT::CENTIMETER;
+
+    else if (s_unit.compare("meter") == 0)
+        return sl::UNIT::METER;
+
+    else if (s_unit.compare("inch") == 0)
+        return sl::UNIT::INCH;
+
+    else if (s_unit.compare("foot") == 0)
+        return sl::UNIT::FOOT;
+
+    return sl::UNIT::MILLIMETER;
+}
+
+// Conversion factor from meters to the requested coordinate unit
+static inline float meters_to_unit(sl::UNIT unit)
+{
+    switch (unit)
+    {
+    case sl::UNIT::MILLIMETER:
+        return 1000.f;
+    case sl::UNIT::CENTIMETER:
+        return 100.f;
+    case sl::UNIT::INCH:
+        return 39.3701f;
+    case sl::UNIT::FOOT:
+        return 3.28084f;
+    default:
+        return 1.f;
+    }
+}
+
+#endif
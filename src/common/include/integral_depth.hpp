@@ -0,0 +1,111 @@
+#ifndef __COMMON_INTEGRAL_DEPTH__
+#define __COMMON_INTEGRAL_DEPTH__
+
+#include <roi.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct RoiStats
+{
+    uint64_t valid = 0;
+    uint64_t total = 0;
+    double sum = 0.0;
+    double percentile = std::numeric_limits<double>::quiet_NaN();
+
+    double mean() const
+    {
+        return valid > 0 ? sum / (double)valid : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double valid_fraction() const
+    {
+        return total > 0 ? (double)valid / (double)total : 0.0;
+    }
+};
+
+// Summed-area tables of the valid depth and of the valid pixel mask. Built once per
+// frame in a single pass, after which the mean and valid fraction of any rectangle
+// cost four lookups per table. Buffers are kept between frames.
+class IntegralDepth
+{
+public:
+    void build(const float *data, size_t stride_bytes, int width, int height)
+    {
+        cols = width;
+        rows = height;
+        size_t cells = (size_t)(width + 1) * (height + 1);
+        if (sum.size() != cells)
+        {
+            sum.assign(cells, 0.0);
+            count.assign(cells, 0);
+        }
+
+        const size_t pitch = (size_t)width + 1;
+        for (int row = 0; row < height; ++row)
+        {
+            const float *src = reinterpret_cast<const float *>(
+                reinterpret_cast<const unsigned char *>(data) + row * stride_bytes);
+            const double *sum_above = &sum[row * pitch];
+            const uint32_t *count_above = &count[row * pitch];
+            double *sum_out = &sum[(row + 1) * pitch];
+            uint32_t *count_out = &count[(row + 1) * pitch];
+
+            double row_sum = 0.0;
+            uint32_t row_count = 0;
+            for (int col = 0; col < width; ++col)
+            {
+                float value = src[col];
+                if (std::isfinite(value))
+                {
+                    row_sum += value;
+                    row_count++;
+                }
+                sum_out[col + 1] = sum_above[col + 1] + row_sum;
+                count_out[col + 1] = count_above[col + 1] + row_count;
+            }
+        }
+    }
+
+    RoiStats query(const PixelRect &rect) const
+    {
+        RoiStats stats;
+        if (rect.width <= 0 || rect.height <= 0)
+            return stats;
+
+        const size_t pitch = (size_t)cols + 1;
+        size_t a = (size_t)rect.y * pitch + rect.x;
+        size_t b = a + rect.width;
+        size_t c = a + (size_t)rect.height * pitch;
+        size_t d = c + rect.width;
+
+        stats.sum = sum[d] - sum[b] - sum[c] + sum[a];
+        stats.valid = count[d] - count[b] - count[c] + count[a];
+        stats.total = (uint64_t)rect.width * rect.height;
+        return stats;
+    }
+
+    RoiStats query(const Roi &roi) const
+    {
+        return query(roi_to_pixels(roi, cols, rows));
+    }
+
+    int get_width() const
+    {
+        return cols;
+    }
+
+    int get_height() const
+    {
+        return rows;
+    }
+
+private:
+    int cols = 0;
+    int rows = 0;
+    std::vector<double> sum;
+    std::vector<uint32_t> count;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef __COMMON_LATENCY_HISTOGRAM__
+#define __COMMON_LATENCY_HISTOGRAM__
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#define HISTOGRAM_SUB_BITS 5
+
+// Log-linear histogram in the spirit of HdrHistogram: every power of two range is split
+// into 2^HISTOGRAM_SUB_BITS linear buckets, so any recorded value is reported within
+// ~3% over the full uint64 range with a fixed 15 KB table and no allocation on record.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+        : buckets((64 - HISTOGRAM_SUB_BITS + 1) * SUB_BUCKETS, 0)
+    {
+    }
+
+    void record(uint64_t value)
+    {
+        buckets[index(value)]++;
+        count++;
+        sum += (double)value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (size_t i = 0; i < buckets.size(); ++i)
+            buckets[i] += other.buckets[i];
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    void reset()
+    {
+        std::fill(buckets.begin(), buckets.end(), 0);
+        count = 0;
+        sum = 0.0;
+        min = std::numeric_limits<uint64_t>::max();
+        max = 0;
+    }
+
+    // Upper bound of the bucket holding the value at `quantile` in [0, 1]
+    uint64_t percentile(double quantile) const
+    {
+        if (count == 0)
+            return 0;
+
+        quantile = std::min(std::max(quantile, 0.0), 1.0);
+        uint64_t rank = (uint64_t)(quantile * (double)(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+                return std::min(std::max(bucket_upper(i), min), max);
+        }
+        return max;
+    }
+
+    // Samples recorded in buckets lying entirely below `value`
+    uint64_t count_below(uint64_t value) const
+    {
+        uint64_t below = 0;
+        for (size_t i = 0; i < buckets.size() && bucket_upper(i) < value; ++i)
+            below += buckets[i];
+        return below;
+    }
+
+    uint64_t get_count() const
+    {
+        return count;
+    }
+
+    uint64_t get_min() const
+    {
+        return count > 0 ? min : 0;
+    }
+
+    uint64_t get_max() const
+    {
+        return max;
+    }
+
+    double mean() const
+    {
+        return count > 0 ? sum / (double)count : 0.0;
+    }
+
+private:
+    static const uint64_t SUB_BUCKETS = 1ull << HISTOGRAM_SUB_BITS;
+
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    double sum = 0.0;
+    uint64_t min = std::numeric_limits<uint64_t>::max();
+    uint64_t max = 0;
+
+    static size_t index(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return (size_t)value;
+
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - HISTOGRAM_SUB_BITS;
+        return (size_t)shift * SUB_BUCKETS + (size_t)(value >> shift);
+    }
+
+    static uint64_t bucket_upper(size_t i)
+    {
+        if (i < 2 * SUB_BUCKETS)
+            return i;
+
+        int shift = (int)(i / SUB_BUCKETS) - 1;
+        uint64_t lower = (uint64_t)(i - (size_t)shift * SUB_BUCKETS) << shift;
+        return lower + ((1ull << shift) - 1);
+    }
+};
+
+#endif
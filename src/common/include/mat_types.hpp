@@ -0,0 +1,31 @@
+#ifndef __COMMON_MAT_TYPES__
+#define __COMMON_MAT_TYPES__
+
+#include <sl/Camera.hpp>
+#include <typed_view.hpp>
+
+// Element type of every sl::MAT_TYPE, resolved at compile time. A view of an sl::Mat
+// with an unlisted element type does not compile.
+#define TYPED_VIEW_MAT_TYPE(element, mat_type)                                                                         \
+    template <>                                                                                                        \
+    struct MatTypeOf<element>                                                                                          \
+    {                                                                                                                  \
+        static constexpr sl::MAT_TYPE value()                                                                          \
+        {                                                                                                              \
+            return mat_type;                                                                                           \
+        }                                                                                                              \
+    };
+
+TYPED_VIEW_MAT_TYPE(sl::float1, sl::MAT_TYPE::F32_C1)
+TYPED_VIEW_MAT_TYPE(sl::float2, sl::MAT_TYPE::F32_C2)
+TYPED_VIEW_MAT_TYPE(sl::float3, sl::MAT_TYPE::F32_C3)
+TYPED_VIEW_MAT_TYPE(sl::float4, sl::MAT_TYPE::F32_C4)
+TYPED_VIEW_MAT_TYPE(sl::uchar1, sl::MAT_TYPE::U8_C1)
+TYPED_VIEW_MAT_TYPE(sl::uchar2, sl::MAT_TYPE::U8_C2)
+TYPED_VIEW_MAT_TYPE(sl::uchar3, sl::MAT_TYPE::U8_C3)
+TYPED_VIEW_MAT_TYPE(sl::uchar4, sl::MAT_TYPE::U8_C4)
+TYPED_VIEW_MAT_TYPE(sl::ushort1, sl::MAT_TYPE::U16_C1)
+
+#undef TYPED_VIEW_MAT_TYPE
+
+#endif
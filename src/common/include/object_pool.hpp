@@ -0,0 +1,60 @@
+#ifndef __COMMON_OBJECT_POOL__
+#define __COMMON_OBJECT_POOL__
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Fixed set of preallocated objects handed out by pointer. acquire and release are
+// lock-free and may be called from different threads; acquire returns nullptr when
+// every object is in flight, which callers treat as a dropped frame.
+template <typename T>
+class ObjectPool
+{
+public:
+    ObjectPool(size_t size)
+        : objects(size), in_use(new std::atomic<bool>[size])
+    {
+        for (size_t i = 0; i < size; ++i)
+            in_use[i].store(false);
+    }
+
+    T *acquire()
+    {
+        size_t start = hint.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            size_t index = (start + i) % objects.size();
+            bool expected = false;
+            if (in_use[index].compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                hint.store(index + 1, std::memory_order_relaxed);
+                return &objects[index];
+            }
+        }
+        return nullptr;
+    }
+
+    void release(T *object)
+    {
+        in_use[object - objects.data()].store(false, std::memory_order_release);
+    }
+
+    size_t size()
+    {
+        return objects.size();
+    }
+
+    // Direct access for one-time setup before the pool is shared between threads
+    T &at(size_t index)
+    {
+        return objects.at(index);
+    }
+
+private:
+    std::vector<T> objects;
+    std::unique_ptr<std::atomic<bool>[]> in_use;
+    std::atomic<size_t> hint{0};
+};
+
+#endif
@@ -0,0 +1,471 @@
+#ifndef __COMMON_OCCUPANCY_MAP__
+#define __COMMON_OCCUPANCY_MAP__
+
+#include <camera_intrinsics.hpp>
+#include <depth_stats.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define OCCUPANCY_BLOCK_SHIFT 3
+#define OCCUPANCY_BLOCK_SIDE (1 << OCCUPANCY_BLOCK_SHIFT)
+#define OCCUPANCY_BLOCK_VOXELS (OCCUPANCY_BLOCK_SIDE * OCCUPANCY_BLOCK_SIDE * OCCUPANCY_BLOCK_SIDE)
+#define OCCUPANCY_MAX_BLOCKS 16384
+
+// Log-odds steps of a voxel: two hits from unknown make it occupied, five misses clear
+// a saturated one, and a voxel seen free needs three hits.
+#define OCCUPANCY_HIT 4
+#define OCCUPANCY_MISS -2
+#define OCCUPANCY_MIN -4
+#define OCCUPANCY_MAX 16
+#define OCCUPANCY_THRESHOLD 8
+
+// Axis aligned box in the depth unit, in the left camera image frame (x right, y down,
+// z forward). Bounds are inclusive.
+struct OccupancyBox
+{
+    float min[3];
+    float max[3];
+};
+
+// Voxel occupancy of a static camera's view, fused frame after frame from the depth
+// maps. Voxels are grouped in blocks of 8^3 allocated where depth points fall and kept
+// in a hash table, at most max_blocks of them: the least recently updated block is
+// recycled when the pool is full, so memory stays bounded however long it runs.
+//
+// Each frame the points (every pixel_step-th pixel and row) flag the voxels they hit,
+// then the voxels of the allocated blocks in view are projected back into the depth
+// map: flagged voxels gain OCCUPANCY_HIT, voxels in front of the measured surface by
+// more than a voxel lose OCCUPANCY_MISS and voxels behind it are left alone. This is
+// how an object leaving a volume clears it. Blocks outside the view are not touched.
+class OccupancyMap
+{
+public:
+    OccupancyMap(float voxel_size, size_t max_blocks = OCCUPANCY_MAX_BLOCKS, int pixel_step = 2)
+        : voxel(voxel_size), inverse_voxel(1.f / voxel_size), max_blocks(std::max<size_t>(max_blocks, 1)),
+          pixel_step(std::max(pixel_step, 1))
+    {
+        blocks.reserve(this->max_blocks);
+        index.reserve(this->max_blocks);
+    }
+
+    // Fuses a width x height depth map with rows stride_bytes apart. Intrinsics of
+    // another resolution are rescaled.
+    void integrate(const float *depth, size_t stride_bytes, int width, int height, const CameraIntrinsics &intrinsics)
+    {
+        CameraIntrinsics camera = intrinsics.scaled(width, height);
+        if (++stamp == 0)
+            stamp = 1;
+        frames++;
+        updated = 0;
+
+        flag_hits(depth, stride_bytes, width, height, camera);
+
+        // Walking from the most recent block, the ones updated here move to the front
+        uint32_t block = lru_head;
+        while (block != NONE)
+        {
+            uint32_t next = blocks[block].next;
+            if (update_block(blocks[block], depth, stride_bytes, width, height, camera))
+            {
+                touch(block);
+                updated++;
+            }
+            block = next;
+        }
+    }
+
+    // Number of occupied voxels overlapping `box`. Only the blocks spanned by the box are
+    // looked up and those without any occupied voxel are skipped, so a query costs a few
+    // microseconds for boxes of a few hundred blocks.
+    uint32_t count_occupied(const OccupancyBox &box) const
+    {
+        int lo[3], hi[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo[axis] = voxel_index(box.min[axis]);
+            hi[axis] = voxel_index(box.max[axis]);
+            if (hi[axis] < lo[axis])
+                return 0;
+        }
+
+        uint32_t count = 0;
+        for (int bz = lo[2] >> OCCUPANCY_BLOCK_SHIFT; bz <= hi[2] >> OCCUPANCY_BLOCK_SHIFT; ++bz)
+        {
+            for (int by = lo[1] >> OCCUPANCY_BLOCK_SHIFT; by <= hi[1] >> OCCUPANCY_BLOCK_SHIFT; ++by)
+            {
+                for (int bx = lo[0] >> OCCUPANCY_BLOCK_SHIFT; bx <= hi[0] >> OCCUPANCY_BLOCK_SHIFT; ++bx)
+                {
+                    auto found = index.find(block_key(bx, by, bz));
+                    if (found == index.end() || blocks[found->second].occupied == 0)
+                        continue;
+                    count += count_in_block(blocks[found->second], lo, hi);
+                }
+            }
+        }
+        return count;
+    }
+
+    float get_voxel_size() const
+    {
+        return voxel;
+    }
+
+    size_t get_block_count() const
+    {
+        return index.size();
+    }
+
+    size_t get_max_blocks() const
+    {
+        return max_blocks;
+    }
+
+    // Blocks recycled to make room since the start
+    uint64_t get_evicted() const
+    {
+        return evicted;
+    }
+
+    // Points dropped because every block was already in use by the current frame
+    uint64_t get_dropped_points() const
+    {
+        return dropped_points;
+    }
+
+    // Blocks updated by the last frame
+    size_t get_updated_blocks() const
+    {
+        return updated;
+    }
+
+private:
+    static const uint32_t NONE = 0xffffffffu;
+
+    struct Block
+    {
+        uint64_t key;
+        int origin[3];
+        uint32_t prev;
+        uint32_t next;
+        uint32_t stamp;
+        uint32_t occupied;
+        uint64_t hits[OCCUPANCY_BLOCK_VOXELS / 64];
+        int8_t log_odds[OCCUPANCY_BLOCK_VOXELS];
+    };
+
+    float voxel;
+    float inverse_voxel;
+    size_t max_blocks;
+    int pixel_step;
+    std::vector<Block> blocks;
+    std::unordered_map<uint64_t, uint32_t> index;
+    uint32_t lru_head = NONE;
+    uint32_t lru_tail = NONE;
+    uint32_t stamp = 0;
+    uint64_t frames = 0;
+    uint64_t evicted = 0;
+    uint64_t dropped_points = 0;
+    size_t updated = 0;
+
+    // The offset keeps the scaled coordinate positive so truncation rounds down like
+    // floor, over +/-2^20 voxels around the camera
+    int voxel_index(float value) const
+    {
+        const float offset = (float)(1 << 20);
+        return (int)(value * inverse_voxel + offset) - (1 << 20);
+    }
+
+    static uint64_t block_key(int bx, int by, int bz)
+    {
+        const int offset = 1 << 20;
+        return ((uint64_t)((bx + offset) & 0x1fffff) << 42) | ((uint64_t)((by + offset) & 0x1fffff) << 21) |
+               (uint64_t)((bz + offset) & 0x1fffff);
+    }
+
+    static int voxel_offset(int x, int y, int z)
+    {
+        return (((z << OCCUPANCY_BLOCK_SHIFT) + y) << OCCUPANCY_BLOCK_SHIFT) + x;
+    }
+
+    void flag_hits(const float *depth, size_t stride_bytes, int width, int height, const CameraIntrinsics &camera)
+    {
+        const int mask = OCCUPANCY_BLOCK_SIDE - 1;
+        uint64_t last_key = ~0ull;
+        Block *last = nullptr;
+        float inverse_fx = 1.f / camera.fx;
+
+        for (int row = 0; row < height; row += pixel_step)
+        {
+            const float *z = depth_row(depth, stride_bytes, row);
+            float ray_y = ((float)row - camera.cy) / camera.fy;
+            for (int col = 0; col < width; col += pixel_step)
+            {
+                // Rejects NaN, both infinities and non positive depth
+                if (!(z[col] > 0.f && z[col] < std::numeric_limits<float>::infinity()))
+                    continue;
+
+                int vx = voxel_index(z[col] * ((float)col - camera.cx) * inverse_fx);
+                int vy = voxel_index(z[col] * ray_y);
+                int vz = voxel_index(z[col]);
+                uint64_t key = block_key(vx >> OCCUPANCY_BLOCK_SHIFT, vy >> OCCUPANCY_BLOCK_SHIFT,
+                                         vz >> OCCUPANCY_BLOCK_SHIFT);
+                // Neighbouring pixels mostly share a block, the last one is checked before hashing
+                if (key != last_key)
+                {
+                    last = find_or_allocate(key, vx & ~mask, vy & ~mask, vz & ~mask);
+                    last_key = key;
+                }
+                if (last == nullptr)
+                {
+                    dropped_points++;
+                    continue;
+                }
+                int offset = voxel_offset(vx & mask, vy & mask, vz & mask);
+                last->hits[offset >> 6] |= 1ull << (offset & 63);
+            }
+        }
+    }
+
+    Block *find_or_allocate(uint64_t key, int x, int y, int z)
+    {
+        // Stamped on lookup too, so a block hit by this frame is never the one recycled
+        auto found = index.find(key);
+        if (found != index.end())
+        {
+            blocks[found->second].stamp = stamp;
+            return &blocks[found->second];
+        }
+
+        uint32_t slot;
+        if (blocks.size() < max_blocks)
+        {
+            slot = (uint32_t)blocks.size();
+            blocks.emplace_back();
+        }
+        else
+        {
+            // Never recycle a block already holding hits of this frame
+            slot = lru_tail;
+            if (blocks[slot].stamp == stamp)
+                return nullptr;
+            unlink(slot);
+            index.erase(blocks[slot].key);
+            evicted++;
+        }
+
+        Block &block = blocks[slot];
+        block.key = key;
+        block.origin[0] = x;
+        block.origin[1] = y;
+        block.origin[2] = z;
+        block.occupied = 0;
+        std::memset(block.hits, 0, sizeof(block.hits));
+        std::memset(block.log_odds, 0, sizeof(block.log_odds));
+        index.emplace(key, slot);
+        link_front(slot);
+        block.stamp = stamp;
+        return &block;
+    }
+
+    // Returns true when any voxel of the block was updated
+    bool update_block(Block &block, const float *depth, size_t stride_bytes, int width, int height,
+                      const CameraIntrinsics &camera)
+    {
+        bool flagged = false;
+        for (uint64_t word : block.hits)
+            flagged |= word != 0;
+
+        // Cheap rejection of the blocks entirely behind the camera or outside the image
+        float side = voxel * OCCUPANCY_BLOCK_SIDE;
+        float cx = (block.origin[0] + 0.5f * OCCUPANCY_BLOCK_SIDE) * voxel;
+        float cy = (block.origin[1] + 0.5f * OCCUPANCY_BLOCK_SIDE) * voxel;
+        float cz = (block.origin[2] + 0.5f * OCCUPANCY_BLOCK_SIDE) * voxel;
+        if (!flagged)
+        {
+            if (cz + side < 0.f)
+                return false;
+            if (cz > side)
+            {
+                float radius = side * (camera.fx + camera.fy) / cz;
+                float u = camera.fx * cx / cz + camera.cx;
+                float v = camera.fy * cy / cz + camera.cy;
+                if (u + radius < 0.f || v + radius < 0.f || u - radius >= width || v - radius >= height)
+                    return false;
+            }
+        }
+
+        bool touched = flagged;
+        for (int z = 0; z < OCCUPANCY_BLOCK_SIDE; ++z)
+        {
+            float pz = (block.origin[2] + z + 0.5f) * voxel;
+            if (pz <= 0.f)
+                continue;
+            float inverse_z = 1.f / pz;
+            for (int y = 0; y < OCCUPANCY_BLOCK_SIDE; ++y)
+            {
+                float py = (block.origin[1] + y + 0.5f) * voxel;
+                int v = (int)(camera.fy * py * inverse_z + camera.cy + 0.5f);
+                for (int x = 0; x < OCCUPANCY_BLOCK_SIDE; ++x)
+                {
+                    int offset = voxel_offset(x, y, z);
+                    int change;
+                    if (block.hits[offset >> 6] & (1ull << (offset & 63)))
+                        change = OCCUPANCY_HIT;
+                    else
+                    {
+                        float px = (block.origin[0] + x + 0.5f) * voxel;
+                        int u = (int)(camera.fx * px * inverse_z + camera.cx + 0.5f);
+                        if (u < 0 || v < 0 || u >= width || v >= height)
+                            continue;
+                        // Too far (+inf) is free space, NaN and too close (-inf) say nothing
+                        float measured = depth_row(depth, stride_bytes, v)[u];
+                        if (!(measured > 0.f) || pz + voxel >= measured)
+                            continue;
+                        change = OCCUPANCY_MISS;
+                    }
+                    touched = true;
+                    apply(block, offset, change);
+                }
+            }
+        }
+
+        std::memset(block.hits, 0, sizeof(block.hits));
+        return touched;
+    }
+
+    static void apply(Block &block, int offset, int change)
+    {
+        int before = block.log_odds[offset];
+        int after = std::max(OCCUPANCY_MIN, std::min(OCCUPANCY_MAX, before + change));
+        block.log_odds[offset] = (int8_t)after;
+        if (before < OCCUPANCY_THRESHOLD && after >= OCCUPANCY_THRESHOLD)
+            block.occupied++;
+        else if (before >= OCCUPANCY_THRESHOLD && after < OCCUPANCY_THRESHOLD)
+            block.occupied--;
+    }
+
+    static uint32_t count_in_block(const Block &block, const int *lo, const int *hi)
+    {
+        int from[3], to[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            from[axis] = std::max(lo[axis] - block.origin[axis], 0);
+            to[axis] = std::min(hi[axis] - block.origin[axis], OCCUPANCY_BLOCK_SIDE - 1);
+        }
+
+        uint32_t count = 0;
+        for (int z = from[2]; z <= to[2]; ++z)
+            for (int y = from[1]; y <= to[1]; ++y)
+                for (int x = from[0]; x <= to[0]; ++x)
+                    count += block.log_odds[voxel_offset(x, y, z)] >= OCCUPANCY_THRESHOLD;
+        return count;
+    }
+
+    void touch(uint32_t slot)
+    {
+        blocks[slot].stamp = stamp;
+        if (lru_head == slot)
+            return;
+        unlink(slot);
+        link_front(slot);
+    }
+
+    void link_front(uint32_t slot)
+    {
+        blocks[slot].prev = NONE;
+        blocks[slot].next = lru_head;
+        if (lru_head != NONE)
+            blocks[lru_head].prev = slot;
+        lru_head = slot;
+        if (lru_tail == NONE)
+            lru_tail = slot;
+    }
+
+    void unlink(uint32_t slot)
+    {
+        Block &block = blocks[slot];
+        if (block.prev != NONE)
+            blocks[block.prev].next = block.next;
+        else
+            lru_head = block.next;
+        if (block.next != NONE)
+            blocks[block.next].prev = block.prev;
+        else
+            lru_tail = block.prev;
+    }
+};
+
+// Named box watched for occupancy, in meters in the left camera image frame
+struct Volume
+{
+    std::string name;
+    float x, y, z, width, height, depth;
+    // Occupied voxels needed before the volume counts as occupied
+    uint32_t min_voxels;
+
+    OccupancyBox to_box(float unit_scale) const
+    {
+        return OccupancyBox{{x * unit_scale, y * unit_scale, z * unit_scale},
+                            {(x + width) * unit_scale, (y + height) * unit_scale, (z + depth) * unit_scale}};
+    }
+};
+
+static inline bool parse_min_voxels(const std::string &value, int &min_voxels)
+{
+    try
+    {
+        size_t used = 0;
+        min_voxels = std::stoi(value, &used);
+        return used == value.size() && min_voxels >= 1;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+// Volume file, one entry per line, '#' starts a comment:
+//   <name> <x> <y> <z> <width> <height> <depth> [min_voxels]
+// x, y, z is the corner nearest to the origin, in meters with x right, y down and z
+// forward from the left camera. min_voxels defaults to 1.
+static inline std::vector<Volume> load_volume_file(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+        throw std::invalid_argument("Could not open volume file " + filename);
+
+    std::vector<Volume> volumes;
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(file, line))
+    {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream stream(line);
+        Volume volume;
+        if (!(stream >> volume.name))
+            continue;
+
+        int min_voxels = 1;
+        std::string extra;
+        if (!(stream >> volume.x >> volume.y >> volume.z >> volume.width >> volume.height >> volume.depth) ||
+            volume.width <= 0.f || volume.height <= 0.f || volume.depth <= 0.f ||
+            ((stream >> extra) && !parse_min_voxels(extra, min_voxels)))
+            throw std::invalid_argument("Malformed volume at " + filename + ":" + std::to_string(line_number));
+        volume.min_voxels = (uint32_t)min_voxels;
+        volumes.push_back(volume);
+    }
+    return volumes;
+}
+
+#endif
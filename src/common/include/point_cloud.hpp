@@ -0,0 +1,329 @@
+#ifndef __COMMON_POINT_CLOUD__
+#define __COMMON_POINT_CLOUD__
+
+#include <camera_intrinsics.hpp>
+#include <depth_stats.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Points are in the depth unit, in the image frame of the left camera: x right, y down,
+// z forward (sl::COORDINATE_SYSTEM::IMAGE).
+struct Point3
+{
+    float x;
+    float y;
+    float z;
+};
+
+// Back-projection turns into two multiplies per pixel with the ray of every column and
+// row precomputed: x = z * (col - cx) / fx, y = z * (row - cy) / fy.
+static void back_project_row_scalar(const float *depth, const float *ray_x, float ray_y, float *x, float *y, int begin,
+                                    int width)
+{
+    for (int col = begin; col < width; ++col)
+    {
+        x[col] = depth[col] * ray_x[col];
+        y[col] = depth[col] * ray_y;
+    }
+}
+
+#if defined(DEPTH_STATS_X86)
+__attribute__((target("sse4.1"))) static void back_project_row_sse41(const float *depth, const float *ray_x,
+                                                                     float ray_y, float *x, float *y, int width)
+{
+    const __m128 ry = _mm_set1_ps(ray_y);
+    int col = 0;
+    for (; col + 4 <= width; col += 4)
+    {
+        __m128 z = _mm_loadu_ps(depth + col);
+        _mm_storeu_ps(x + col, _mm_mul_ps(z, _mm_loadu_ps(ray_x + col)));
+        _mm_storeu_ps(y + col, _mm_mul_ps(z, ry));
+    }
+    back_project_row_scalar(depth, ray_x, ray_y, x, y, col, width);
+}
+
+__attribute__((target("avx2"))) static void back_project_row_avx2(const float *depth, const float *ray_x, float ray_y,
+                                                                  float *x, float *y, int width)
+{
+    const __m256 ry = _mm256_set1_ps(ray_y);
+    int col = 0;
+    for (; col + 8 <= width; col += 8)
+    {
+        __m256 z = _mm256_loadu_ps(depth + col);
+        _mm256_storeu_ps(x + col, _mm256_mul_ps(z, _mm256_loadu_ps(ray_x + col)));
+        _mm256_storeu_ps(y + col, _mm256_mul_ps(z, ry));
+    }
+    back_project_row_scalar(depth, ray_x, ray_y, x, y, col, width);
+}
+#endif
+
+#if defined(DEPTH_STATS_NEON)
+static void back_project_row_neon(const float *depth, const float *ray_x, float ray_y, float *x, float *y, int width)
+{
+    int col = 0;
+    for (; col + 4 <= width; col += 4)
+    {
+        float32x4_t z = vld1q_f32(depth + col);
+        vst1q_f32(x + col, vmulq_f32(z, vld1q_f32(ray_x + col)));
+        vst1q_f32(y + col, vmulq_n_f32(z, ray_y));
+    }
+    back_project_row_scalar(depth, ray_x, ray_y, x, y, col, width);
+}
+#endif
+
+// Voxel grid filter keeping the centroid of the points falling in each cubic cell of
+// `leaf` units. Cells live in an open addressing hash table that is reused across
+// frames: a cell belongs to the current frame when its stamp matches, so starting a
+// frame costs nothing and the table only grows.
+class VoxelGrid
+{
+public:
+    VoxelGrid(float leaf = 0.f)
+    {
+        set_leaf(leaf);
+    }
+
+    void set_leaf(float leaf)
+    {
+        this->leaf = leaf;
+        inverse_leaf = leaf > 0.f ? 1.f / leaf : 0.f;
+    }
+
+    float get_leaf() const
+    {
+        return leaf;
+    }
+
+    void begin()
+    {
+        if (cells.empty())
+            resize(1 << 16);
+        occupied.clear();
+        last_key = ~0ull;
+        if (++stamp == 0)
+        {
+            for (Cell &cell : cells)
+                cell.stamp = 0;
+            stamp = 1;
+        }
+    }
+
+    void add(float x, float y, float z)
+    {
+        uint64_t key = cell_key(x, y, z);
+        // Neighbouring pixels mostly share a cell, the last one is checked before hashing
+        Cell &cell = key == last_key ? cells[last_slot] : find(key);
+        if (cell.stamp != stamp)
+        {
+            cell = Cell{key, x, y, z, 1, stamp};
+            occupied.push_back((uint32_t)(&cell - cells.data()));
+            last_key = key;
+            last_slot = occupied.back();
+            if (occupied.size() * 2 > cells.size())
+                resize(cells.size() * 2);
+            return;
+        }
+        last_key = key;
+        last_slot = (uint32_t)(&cell - cells.data());
+        cell.sum_x += x;
+        cell.sum_y += y;
+        cell.sum_z += z;
+        cell.count++;
+    }
+
+    // Centroids in the order the cells were first hit
+    void finish(std::vector<Point3> &points) const
+    {
+        points.clear();
+        points.reserve(occupied.size());
+        for (uint32_t slot : occupied)
+        {
+            const Cell &cell = cells[slot];
+            float scale = 1.f / (float)cell.count;
+            points.push_back(Point3{cell.sum_x * scale, cell.sum_y * scale, cell.sum_z * scale});
+        }
+    }
+
+private:
+    struct Cell
+    {
+        uint64_t key;
+        float sum_x;
+        float sum_y;
+        float sum_z;
+        uint32_t count;
+        uint32_t stamp;
+    };
+
+    float leaf;
+    float inverse_leaf;
+    std::vector<Cell> cells;
+    std::vector<uint32_t> occupied;
+    uint32_t stamp = 0;
+    int shift = 64;
+    uint64_t last_key = ~0ull;
+    uint32_t last_slot = 0;
+
+    // 21 bits per axis, +/-2^20 cells around the camera. The offset keeps the scaled
+    // coordinates positive so truncation rounds down like floor.
+    uint64_t cell_key(float x, float y, float z) const
+    {
+        const float offset = (float)(1 << 20);
+        uint64_t ix = (uint64_t)(int64_t)(x * inverse_leaf + offset) & 0x1fffff;
+        uint64_t iy = (uint64_t)(int64_t)(y * inverse_leaf + offset) & 0x1fffff;
+        uint64_t iz = (uint64_t)(int64_t)(z * inverse_leaf + offset) & 0x1fffff;
+        return (ix << 42) | (iy << 21) | iz;
+    }
+
+    Cell &find(uint64_t key)
+    {
+        size_t mask = cells.size() - 1;
+        size_t slot = (size_t)((key * 0x9e3779b97f4a7c15ull) >> shift);
+        while (cells[slot].stamp == stamp && cells[slot].key != key)
+            slot = (slot + 1) & mask;
+        return cells[slot];
+    }
+
+    void resize(size_t size)
+    {
+        std::vector<Cell> old;
+        old.swap(cells);
+        cells.assign(size, Cell{0, 0.f, 0.f, 0.f, 0, 0});
+        shift = 64 - __builtin_ctzll(size);
+
+        last_key = ~0ull;
+        std::vector<uint32_t> slots;
+        slots.swap(occupied);
+        for (uint32_t slot : slots)
+        {
+            Cell &cell = find(old[slot].key);
+            cell = old[slot];
+            occupied.push_back((uint32_t)(&cell - cells.data()));
+        }
+    }
+};
+
+// Turns depth maps into point clouds: a SIMD back-projection of every row against
+// precomputed rays, then the valid points are either collected or fed to a VoxelGrid.
+// get_points() is the in memory output, valid until the next frame.
+class PointCloudGenerator
+{
+public:
+    PointCloudGenerator()
+        : level(detect_simd_level())
+    {
+    }
+
+    PointCloudGenerator(SimdLevel level)
+        : level(level)
+    {
+    }
+
+    // Voxel size in the depth unit, 0 keeps every valid point
+    void set_voxel_size(float leaf)
+    {
+        voxels.set_leaf(leaf);
+    }
+
+    // Points of a width x height depth map with rows stride_bytes apart. Intrinsics of
+    // another resolution are rescaled. Returns the number of valid depth pixels.
+    size_t generate(const float *depth, size_t stride_bytes, int width, int height, const CameraIntrinsics &intrinsics)
+    {
+        update_rays(intrinsics.scaled(width, height));
+        row_x.resize(width);
+        row_y.resize(width);
+
+        bool voxelize = voxels.get_leaf() > 0.f;
+        if (voxelize)
+            voxels.begin();
+        else
+        {
+            points.clear();
+            points.reserve((size_t)width * height);
+        }
+
+        size_t valid = 0;
+        for (int row = 0; row < height; ++row)
+        {
+            const float *z = depth_row(depth, stride_bytes, row);
+            back_project_row(z, ray_y[row], width);
+            for (int col = 0; col < width; ++col)
+            {
+                // Rejects NaN, both infinities and non positive depth
+                if (!(z[col] > 0.f && z[col] < std::numeric_limits<float>::infinity()))
+                    continue;
+                valid++;
+                if (voxelize)
+                    voxels.add(row_x[col], row_y[col], z[col]);
+                else
+                    points.push_back(Point3{row_x[col], row_y[col], z[col]});
+            }
+        }
+
+        if (voxelize)
+            voxels.finish(points);
+        return valid;
+    }
+
+    const std::vector<Point3> &get_points() const
+    {
+        return points;
+    }
+
+    SimdLevel get_level() const
+    {
+        return level;
+    }
+
+private:
+    SimdLevel level;
+    CameraIntrinsics rays_for;
+    std::vector<float> ray_x;
+    std::vector<float> ray_y;
+    std::vector<float> row_x;
+    std::vector<float> row_y;
+    std::vector<Point3> points;
+    VoxelGrid voxels;
+
+    void update_rays(const CameraIntrinsics &intrinsics)
+    {
+        if ((int)ray_x.size() == intrinsics.width && (int)ray_y.size() == intrinsics.height &&
+            rays_for.fx == intrinsics.fx && rays_for.fy == intrinsics.fy && rays_for.cx == intrinsics.cx &&
+            rays_for.cy == intrinsics.cy)
+            return;
+
+        rays_for = intrinsics;
+        ray_x.resize(intrinsics.width);
+        ray_y.resize(intrinsics.height);
+        for (int col = 0; col < intrinsics.width; ++col)
+            ray_x[col] = ((float)col - intrinsics.cx) / intrinsics.fx;
+        for (int row = 0; row < intrinsics.height; ++row)
+            ray_y[row] = ((float)row - intrinsics.cy) / intrinsics.fy;
+    }
+
+    void back_project_row(const float *z, float ray, int width)
+    {
+        switch (level)
+        {
+#if defined(DEPTH_STATS_X86)
+        case SimdLevel::AVX2:
+            back_project_row_avx2(z, ray_x.data(), ray, row_x.data(), row_y.data(), width);
+            return;
+        case SimdLevel::SSE41:
+            back_project_row_sse41(z, ray_x.data(), ray, row_x.data(), row_y.data(), width);
+            return;
+#endif
+#if defined(DEPTH_STATS_NEON)
+        case SimdLevel::NEON:
+            back_project_row_neon(z, ray_x.data(), ray, row_x.data(), row_y.data(), width);
+            return;
+#endif
+        default:
+            back_project_row_scalar(z, ray_x.data(), ray, row_x.data(), row_y.data(), 0, width);
+        }
+    }
+};
+
+#endif
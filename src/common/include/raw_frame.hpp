@@ -0,0 +1,199 @@
+#ifndef __COMMON_RAW_FRAME__
+#define __COMMON_RAW_FRAME__
+
+#include <sl/Camera.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Raw frame dump layout: a RawFileHeader followed by fixed size records, each one
+// a RawFrameHeader, the left and right BGRA images and (optionally) the F32 depth map.
+// Records have a constant size so any frame can be reached with a single seek.
+#define RAW_MAGIC "ZEDRAW01"
+#define RAW_VERSION 1
+#define RAW_HAS_DEPTH 0x1
+
+struct RawFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t fps;
+    uint32_t flags;
+    uint32_t unit;
+};
+
+struct RawFrameHeader
+{
+    uint64_t timestamp_ns;
+    uint64_t imu_timestamp_ns;
+    float linear_acceleration[3];
+    float angular_velocity[3];
+    float translation[3];
+    float magnetic_field[3];
+    float pressure;
+    float reserved;
+};
+
+static inline size_t raw_image_bytes(const RawFileHeader &header)
+{
+    return (size_t)header.width * header.height * 4;
+}
+
+static inline size_t raw_depth_bytes(const RawFileHeader &header)
+{
+    if (header.flags & RAW_HAS_DEPTH)
+        return (size_t)header.width * header.height * sizeof(float);
+    return 0;
+}
+
+static inline size_t raw_record_bytes(const RawFileHeader &header)
+{
+    return sizeof(RawFrameHeader) + 2 * raw_image_bytes(header) + raw_depth_bytes(header);
+}
+
+static inline void sensors_to_raw(const sl::SensorsData &data, RawFrameHeader &frame)
+{
+    sl::Translation t = data.imu.pose.getTranslation();
+    frame.imu_timestamp_ns = data.imu.timestamp.getNanoseconds();
+    frame.linear_acceleration[0] = data.imu.linear_acceleration.x;
+    frame.linear_acceleration[1] = data.imu.linear_acceleration.y;
+    frame.linear_acceleration[2] = data.imu.linear_acceleration.z;
+    frame.angular_velocity[0] = data.imu.angular_velocity.x;
+    frame.angular_velocity[1] = data.imu.angular_velocity.y;
+    frame.angular_velocity[2] = data.imu.angular_velocity.z;
+    frame.translation[0] = t.x;
+    frame.translation[1] = t.y;
+    frame.translation[2] = t.z;
+    frame.magnetic_field[0] = data.magnetometer.magnetic_field_calibrated.x;
+    frame.magnetic_field[1] = data.magnetometer.magnetic_field_calibrated.y;
+    frame.magnetic_field[2] = data.magnetometer.magnetic_field_calibrated.z;
+    frame.pressure = data.barometer.pressure;
+}
+
+static inline void raw_to_sensors(const RawFrameHeader &frame, sl::SensorsData &data)
+{
+    data.imu.is_available = true;
+    data.imu.timestamp = sl::Timestamp(frame.imu_timestamp_ns);
+    data.imu.linear_acceleration = sl::float3(frame.linear_acceleration[0], frame.linear_acceleration[1], frame.linear_acceleration[2]);
+    data.imu.angular_velocity = sl::float3(frame.angular_velocity[0], frame.angular_velocity[1], frame.angular_velocity[2]);
+    data.imu.pose.setTranslation(sl::Translation(frame.translation[0], frame.translation[1], frame.translation[2]));
+    data.barometer.is_available = true;
+    data.barometer.timestamp = sl::Timestamp(frame.imu_timestamp_ns);
+    data.barometer.pressure = frame.pressure;
+    data.magnetometer.is_available = true;
+    data.magnetometer.timestamp = sl::Timestamp(frame.imu_timestamp_ns);
+    data.magnetometer.magnetic_field_calibrated = sl::float3(frame.magnetic_field[0], frame.magnetic_field[1], frame.magnetic_field[2]);
+}
+
+class RawFrameWriter
+{
+public:
+    RawFrameWriter(const std::string &filename, uint32_t fps, sl::UNIT unit)
+        : filename(filename)
+    {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, RAW_MAGIC, sizeof(header.magic));
+        header.version = RAW_VERSION;
+        header.fps = fps;
+        header.unit = (uint32_t)unit;
+    }
+
+    // The file is created on the first frame, once the image size is known. `with_depth`
+    // fixes the record layout at that point; later frames whose depth could not be
+    // retrieved pass a null `depth` and get a NaN depth map so every record keeps its size.
+    sl::ERROR_CODE write(const RawFrameHeader &frame, sl::Mat &left, sl::Mat &right, sl::Mat *depth, bool with_depth)
+    {
+        if (!started)
+        {
+            header.width = (uint32_t)left.getWidth();
+            header.height = (uint32_t)left.getHeight();
+            header.flags = with_depth ? RAW_HAS_DEPTH : 0;
+
+            if (!file.is_open() && !create())
+                return sl::ERROR_CODE::SVO_RECORDING_ERROR;
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            started = true;
+        }
+
+        if (left.getWidth() != header.width || left.getHeight() != header.height ||
+            right.getWidth() != header.width || right.getHeight() != header.height)
+            return sl::ERROR_CODE::INVALID_RESOLUTION;
+
+        file.write(reinterpret_cast<const char *>(&frame), sizeof(frame));
+        write_rows(left, header.width * 4);
+        write_rows(right, header.width * 4);
+        if (header.flags & RAW_HAS_DEPTH)
+        {
+            if (depth != nullptr && depth->getWidth() == header.width && depth->getHeight() == header.height)
+                write_rows(*depth, header.width * sizeof(float));
+            else
+                write_missing_depth();
+        }
+
+        frames_written++;
+        return file.good() ? sl::ERROR_CODE::SUCCESS : sl::ERROR_CODE::SVO_RECORDING_ERROR;
+    }
+
+    // Opens the file ahead of the first frame, which otherwise creates it
+    bool create()
+    {
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        return file.is_open();
+    }
+
+    void close()
+    {
+        if (file.is_open())
+            file.close();
+    }
+
+    uint64_t get_frames_written()
+    {
+        return frames_written;
+    }
+
+    // Frames recorded with a NaN depth map in place of a missing one
+    uint64_t get_depth_missing()
+    {
+        return depth_missing;
+    }
+
+private:
+    std::string filename;
+    std::ofstream file;
+    RawFileHeader header;
+    bool started = false;
+    uint64_t frames_written = 0;
+    uint64_t depth_missing = 0;
+    std::vector<float> nan_row;
+
+    void write_rows(sl::Mat &mat, size_t row_bytes)
+    {
+        const char *data = reinterpret_cast<const char *>(mat.getPtr<sl::uchar1>(sl::MEM::CPU));
+        size_t step = mat.getStepBytes(sl::MEM::CPU);
+
+        if (step == row_bytes)
+        {
+            file.write(data, row_bytes * header.height);
+            return;
+        }
+
+        for (size_t row = 0; row < header.height; ++row)
+            file.write(data + row * step, row_bytes);
+    }
+
+    void write_missing_depth()
+    {
+        nan_row.assign(header.width, std::numeric_limits<float>::quiet_NaN());
+        for (size_t row = 0; row < header.height; ++row)
+            file.write(reinterpret_cast<const char *>(nan_row.data()), nan_row.size() * sizeof(float));
+        depth_missing++;
+    }
+};
+
+#endif
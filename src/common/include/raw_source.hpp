@@ -0,0 +1,162 @@
+#ifndef __COMMON_RAW_SOURCE__
+#define __COMMON_RAW_SOURCE__
+
+#include <frame_source.hpp>
+#include <fstream>
+
+// Replays a raw frame dump written by RawFrameWriter. Only the record header is read
+// on grab, image and depth payloads are read on demand so timestamp or sensor only
+// passes stay cheap.
+class RawFrameSource : public FrameSource
+{
+public:
+    RawFrameSource(const std::string &filename)
+    {
+        file.open(filename, std::ios::binary);
+        if (!file.is_open())
+            throw sl::ERROR_CODE::INVALID_SVO_FILE;
+
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!file.good() || std::memcmp(header.magic, RAW_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != RAW_VERSION)
+            throw sl::ERROR_CODE::INVALID_SVO_FILE;
+
+        file.seekg(0, std::ios::end);
+        std::streamoff payload = (std::streamoff)file.tellg() - (std::streamoff)sizeof(header);
+        frames = (int)(payload / (std::streamoff)raw_record_bytes(header));
+    }
+
+    sl::ERROR_CODE retrieve_image(sl::Mat &image, sl::VIEW view = sl::VIEW::LEFT) override
+    {
+        if (position < 0)
+            return sl::ERROR_CODE::FAILURE;
+
+        switch (view)
+        {
+        case sl::VIEW::LEFT:
+            return read_payload(image, 0, sl::MAT_TYPE::U8_C4, 4);
+        case sl::VIEW::RIGHT:
+            return read_payload(image, raw_image_bytes(header), sl::MAT_TYPE::U8_C4, 4);
+        case sl::VIEW::SIDE_BY_SIDE:
+            read_payload(scratch_left, 0, sl::MAT_TYPE::U8_C4, 4);
+            read_payload(scratch_right, raw_image_bytes(header), sl::MAT_TYPE::U8_C4, 4);
+            compose_side_by_side(scratch_left, scratch_right, image);
+            return file.good() ? sl::ERROR_CODE::SUCCESS : sl::ERROR_CODE::FAILURE;
+        case sl::VIEW::DEPTH:
+        {
+            auto err = retrieve_measure(scratch_depth, sl::MEASURE::DEPTH);
+            if (err == sl::ERROR_CODE::SUCCESS)
+                render_depth_view(scratch_depth, image, 10.f * meters_to_unit(get_unit()));
+            return err;
+        }
+        default:
+            return sl::ERROR_CODE::INVALID_FUNCTION_PARAMETERS;
+        }
+    }
+
+    sl::ERROR_CODE retrieve_measure(sl::Mat &measure, sl::MEASURE type = sl::MEASURE::DEPTH) override
+    {
+        if (position < 0)
+            return sl::ERROR_CODE::FAILURE;
+        if (type != sl::MEASURE::DEPTH || !(header.flags & RAW_HAS_DEPTH))
+            return sl::ERROR_CODE::INVALID_FUNCTION_PARAMETERS;
+
+        return read_payload(measure, 2 * raw_image_bytes(header), sl::MAT_TYPE::F32_C1, sizeof(float));
+    }
+
+    sl::ERROR_CODE get_sensors_data(sl::SensorsData &data, sl::TIME_REFERENCE reference) override
+    {
+        if (position < 0)
+            return sl::ERROR_CODE::FAILURE;
+
+        raw_to_sensors(frame, data);
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+    sl::Timestamp get_timestamp(sl::TIME_REFERENCE reference) override
+    {
+        return sl::Timestamp(frame.timestamp_ns);
+    }
+
+    int get_position() override
+    {
+        return position;
+    }
+
+    void set_position(int frame_index) override
+    {
+        next = std::max(0, std::min(frame_index, frames));
+    }
+
+    int get_frame_count() override
+    {
+        return frames;
+    }
+
+    float get_fps() override
+    {
+        return (float)header.fps;
+    }
+
+    float get_current_fps() override
+    {
+        return (float)header.fps;
+    }
+
+    sl::UNIT get_unit() override
+    {
+        return (sl::UNIT)header.unit;
+    }
+
+    sl::Resolution get_resolution() override
+    {
+        return sl::Resolution(header.width, header.height);
+    }
+
+protected:
+    sl::ERROR_CODE grab_frame(sl::RuntimeParameters &params) override
+    {
+        if (next >= frames)
+            return sl::ERROR_CODE::END_OF_SVOFILE_REACHED;
+
+        position = next++;
+        record_offset = (std::streamoff)sizeof(header) + (std::streamoff)position * (std::streamoff)raw_record_bytes(header);
+
+        file.clear();
+        file.seekg(record_offset);
+        file.read(reinterpret_cast<char *>(&frame), sizeof(frame));
+        return file.good() ? sl::ERROR_CODE::SUCCESS : sl::ERROR_CODE::FAILURE;
+    }
+
+private:
+    std::ifstream file;
+    RawFileHeader header;
+    RawFrameHeader frame;
+    std::streamoff record_offset = 0;
+    int frames = 0;
+    int position = -1;
+    int next = 0;
+    sl::Mat scratch_left, scratch_right, scratch_depth;
+
+    sl::ERROR_CODE read_payload(sl::Mat &mat, size_t offset, sl::MAT_TYPE type, size_t pixel_bytes)
+    {
+        ensure_mat(mat, header.width, header.height, type);
+
+        size_t row_bytes = header.width * pixel_bytes;
+        size_t step = mat.getStepBytes(sl::MEM::CPU);
+        char *data = reinterpret_cast<char *>(mat.getPtr<sl::uchar1>(sl::MEM::CPU));
+
+        file.clear();
+        file.seekg(record_offset + (std::streamoff)(sizeof(RawFrameHeader) + offset));
+        if (step == row_bytes)
+            file.read(data, row_bytes * header.height);
+        else
+        {
+            for (size_t row = 0; row < header.height; ++row)
+                file.read(data + row * step, row_bytes);
+        }
+        return file.good() ? sl::ERROR_CODE::SUCCESS : sl::ERROR_CODE::FAILURE;
+    }
+};
+
+#endif
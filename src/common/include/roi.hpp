@@ -0,0 +1,90 @@
+#ifndef __COMMON_ROI__
+#define __COMMON_ROI__
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Region of interest in fractions of the frame so one config works at every resolution
+struct Roi
+{
+    std::string name;
+    float x, y, width, height;
+};
+
+struct PixelRect
+{
+    int x, y, width, height;
+};
+
+static inline PixelRect roi_to_pixels(const Roi &roi, int cols, int rows)
+{
+    int x0 = std::max(0, std::min(cols, (int)(roi.x * cols)));
+    int y0 = std::max(0, std::min(rows, (int)(roi.y * rows)));
+    int x1 = std::max(x0, std::min(cols, (int)((roi.x + roi.width) * cols)));
+    int y1 = std::max(y0, std::min(rows, (int)((roi.y + roi.height) * rows)));
+    return PixelRect{x0, y0, x1 - x0, y1 - y0};
+}
+
+// ROI file, one entry per line, '#' starts a comment:
+//   <name> <x> <y> <width> <height>
+//   grid <rows> <cols> <x> <y> <width> <height>
+// A grid line splits its area into rows x cols zones named <row>_<col>.
+static inline std::vector<Roi> load_roi_file(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+        throw std::invalid_argument("Could not open ROI file " + filename);
+
+    std::vector<Roi> rois;
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(file, line))
+    {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream stream(line);
+        std::string name;
+        if (!(stream >> name))
+            continue;
+
+        int rows = 1, cols = 1;
+        bool grid = name.compare("grid") == 0;
+        if (grid && !(stream >> rows >> cols))
+            rows = 0;
+
+        Roi area;
+        if (!(stream >> area.x >> area.y >> area.width >> area.height) || rows <= 0 || cols <= 0 ||
+            area.width <= 0.f || area.height <= 0.f)
+            throw std::invalid_argument("Malformed ROI at " + filename + ":" + std::to_string(line_number));
+
+        if (!grid)
+        {
+            area.name = name;
+            rois.push_back(area);
+            continue;
+        }
+
+        for (int r = 0; r < rows; ++r)
+        {
+            for (int c = 0; c < cols; ++c)
+            {
+                Roi zone;
+                zone.name = std::to_string(r) + "_" + std::to_string(c);
+                zone.width = area.width / cols;
+                zone.height = area.height / rows;
+                zone.x = area.x + c * zone.width;
+                zone.y = area.y + r * zone.height;
+                rois.push_back(zone);
+            }
+        }
+    }
+    return rois;
+}
+
+#endif
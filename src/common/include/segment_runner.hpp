@@ -0,0 +1,202 @@
+#ifndef __COMMON_SEGMENT_RUNNER__
+#define __COMMON_SEGMENT_RUNNER__
+
+#include <sl/Camera.hpp>
+#include <frame_source.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+struct FrameRange
+{
+    int begin;
+    int end;
+};
+
+// Splits [begin, end) into at most `segments` contiguous ranges of whole strides
+static std::vector<FrameRange> split_frames(int begin, int end, int segments, int stride = 1)
+{
+    std::vector<FrameRange> ranges;
+    int steps = std::max(0, (end - begin + stride - 1) / stride);
+    segments = std::max(1, std::min(segments, steps));
+    for (int i = 0; i < segments && steps > 0; ++i)
+    {
+        int first = begin + (int)((long long)steps * i / segments) * stride;
+        int last = begin + (int)((long long)steps * (i + 1) / segments) * stride;
+        ranges.push_back(FrameRange{first, std::min(last, end)});
+    }
+    return ranges;
+}
+
+// Runs one recording as `segments` frame ranges in parallel, each on its own source
+// opened by `open` and seeked to the start of its range. Every segment owns a copy of
+// the prototype Worker, whose
+//     bool process(FrameSource &source, int frame, sl::ERROR_CODE err, Result &result)
+// is called after each grab except the end of file one and keeps `result` when it
+// returns true. Results come back in frame order and workers in segment order, so
+// per segment state (accumulators, the previous frame) can be merged afterwards.
+template <typename Worker, typename Result>
+class SegmentRunner
+{
+public:
+    using Opener = std::function<std::unique_ptr<FrameSource>()>;
+
+    SegmentRunner(Opener open, int segments, const Worker &prototype, const sl::RuntimeParameters &params,
+                  int stride = 1)
+        : open(open), segments(std::max(1, segments)), prototype(prototype), params(params),
+          stride(std::max(1, stride))
+    {
+    }
+
+    // Processes frames [begin, end), rethrows what the first failed segment threw, an
+    // sl::ERROR_CODE or any exception of its source or worker. `progress` receives a
+    // status line twice per second.
+    void run(int begin, int end, std::ostream *progress = nullptr)
+    {
+        ranges = split_frames(begin, end, segments, stride);
+        workers.assign(ranges.size(), prototype);
+        segment_results.assign(ranges.size(), std::vector<Result>());
+        segment_frames.assign(ranges.size(), std::vector<int>());
+        errors.assign(ranges.size(), nullptr);
+        done = 0;
+        remaining = (int)ranges.size();
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < ranges.size(); ++i)
+            threads.emplace_back(&SegmentRunner::segment_loop, this, i);
+
+        bool progress_shown = false;
+        int total = std::max(0, (end - begin + stride - 1) / stride);
+        auto last_progress = start;
+        while (progress != nullptr && remaining.load() > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_progress < std::chrono::milliseconds(500))
+                continue;
+            last_progress = now;
+
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            double fraction = total > 0 ? (double)done.load() / total : 0.0;
+            std::streamsize precision = progress->precision();
+            *progress << '\r' << std::fixed << std::setprecision(1) << "  " << done.load() << "/" << total
+                      << " frames on " << ranges.size() << " segments (" << 100.0 * fraction << "%), ETA "
+                      << (fraction > 0.0 ? elapsed * (1.0 - fraction) / fraction : 0.0) << " s, "
+                      << done.load() / std::max(elapsed, 1e-9) << " frames/s   " << std::defaultfloat
+                      << std::setprecision(precision) << std::flush;
+            progress_shown = true;
+        }
+        for (auto &thread : threads)
+            thread.join();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (progress_shown)
+            *progress << std::endl;
+
+        results.clear();
+        frames.clear();
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            results.insert(results.end(), segment_results[i].begin(), segment_results[i].end());
+            frames.insert(frames.end(), segment_frames[i].begin(), segment_frames[i].end());
+            segment_results[i].clear();
+            segment_frames[i].clear();
+        }
+
+        for (const std::exception_ptr &error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
+
+    const std::vector<Result> &get_results() const
+    {
+        return results;
+    }
+
+    // Frame index of each result
+    const std::vector<int> &get_frames() const
+    {
+        return frames;
+    }
+
+    std::vector<Worker> &get_workers()
+    {
+        return workers;
+    }
+
+    const std::vector<FrameRange> &get_ranges() const
+    {
+        return ranges;
+    }
+
+    double get_seconds() const
+    {
+        return seconds;
+    }
+
+private:
+    Opener open;
+    int segments;
+    Worker prototype;
+    sl::RuntimeParameters params;
+    int stride;
+    std::vector<FrameRange> ranges;
+    std::vector<Worker> workers;
+    std::vector<std::vector<Result>> segment_results;
+    std::vector<std::vector<int>> segment_frames;
+    std::vector<std::exception_ptr> errors;
+    std::vector<Result> results;
+    std::vector<int> frames;
+    std::atomic<long long> done{0};
+    std::atomic<int> remaining{0};
+    double seconds = 0.0;
+
+    void segment_loop(size_t segment)
+    {
+        const FrameRange &range = ranges[segment];
+        Worker &worker = workers[segment];
+        std::vector<Result> &out = segment_results[segment];
+        std::vector<int> &out_frames = segment_frames[segment];
+        sl::RuntimeParameters rt_params = params;
+
+        try
+        {
+            std::unique_ptr<FrameSource> source = open();
+            out.reserve((range.end - range.begin + stride - 1) / stride);
+            source->set_position(range.begin);
+
+            Result result;
+            for (int frame = range.begin; frame < range.end; frame += stride)
+            {
+                auto err = source->grab(rt_params);
+                if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+                    break;
+
+                if (worker.process(*source, frame, err, result))
+                {
+                    out.push_back(result);
+                    out_frames.push_back(frame);
+                }
+                done++;
+
+                if (stride > 1 && frame + stride < range.end)
+                    source->set_position(frame + stride);
+            }
+        }
+        catch (...)
+        {
+            // Leaving the thread would terminate the process, run() rethrows it instead
+            errors[segment] = std::current_exception();
+        }
+        remaining--;
+    }
+};
+
+#endif
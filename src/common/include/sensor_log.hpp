@@ -0,0 +1,94 @@
+#ifndef __COMMON_SENSOR_LOG__
+#define __COMMON_SENSOR_LOG__
+
+#include <sl/Camera.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+// Sensor log layout: a SensorLogHeader followed by one SensorRecord per IMU sample.
+// Magnetometer and barometer run slower than the IMU, their fields repeat the last
+// reading and the SENSOR_NEW_* flags mark the records where a new one arrived.
+#define SENSOR_LOG_MAGIC "ZEDIMU01"
+#define SENSOR_LOG_VERSION 1
+#define SENSOR_NEW_MAGNETOMETER 0x1
+#define SENSOR_NEW_BAROMETER 0x2
+
+struct SensorLogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_bytes;
+    uint32_t poll_hz;
+    uint32_t reserved;
+};
+
+struct SensorRecord
+{
+    uint64_t imu_timestamp_ns;
+    uint64_t magnetometer_timestamp_ns;
+    uint64_t barometer_timestamp_ns;
+    float linear_acceleration[3];
+    float angular_velocity[3];
+    float orientation[4];
+    float magnetic_field[3];
+    float pressure;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static inline void sensors_to_record(const sl::SensorsData &data, SensorRecord &record)
+{
+    sl::Orientation q = data.imu.pose.getOrientation();
+    record.imu_timestamp_ns = data.imu.timestamp.getNanoseconds();
+    record.magnetometer_timestamp_ns = data.magnetometer.timestamp.getNanoseconds();
+    record.barometer_timestamp_ns = data.barometer.timestamp.getNanoseconds();
+    record.linear_acceleration[0] = data.imu.linear_acceleration.x;
+    record.linear_acceleration[1] = data.imu.linear_acceleration.y;
+    record.linear_acceleration[2] = data.imu.linear_acceleration.z;
+    record.angular_velocity[0] = data.imu.angular_velocity.x;
+    record.angular_velocity[1] = data.imu.angular_velocity.y;
+    record.angular_velocity[2] = data.imu.angular_velocity.z;
+    record.orientation[0] = q.ox;
+    record.orientation[1] = q.oy;
+    record.orientation[2] = q.oz;
+    record.orientation[3] = q.ow;
+    record.magnetic_field[0] = data.magnetometer.magnetic_field_calibrated.x;
+    record.magnetic_field[1] = data.magnetometer.magnetic_field_calibrated.y;
+    record.magnetic_field[2] = data.magnetometer.magnetic_field_calibrated.z;
+    record.pressure = data.barometer.pressure;
+    record.flags = 0;
+    record.reserved = 0;
+}
+
+// Streams a log one record at a time, throws sl::ERROR_CODE::INVALID_SVO_FILE on a
+// foreign file
+class SensorLogReader
+{
+public:
+    SensorLogReader(const std::string &filename)
+        : file(filename, std::ios::binary)
+    {
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, SENSOR_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SENSOR_LOG_VERSION || header.record_bytes != sizeof(SensorRecord))
+            throw sl::ERROR_CODE::INVALID_SVO_FILE;
+    }
+
+    bool next(SensorRecord &record)
+    {
+        return (bool)file.read(reinterpret_cast<char *>(&record), sizeof(record));
+    }
+
+    const SensorLogHeader &get_header() const
+    {
+        return header;
+    }
+
+private:
+    std::ifstream file;
+    SensorLogHeader header;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef __COMMON_SOURCES__
+#define __COMMON_SOURCES__
+
+#include <frame_source.hpp>
+#include <zed_source.hpp>
+#include <synthetic_source.hpp>
+#include <raw_source.hpp>
+#include <archive_source.hpp>
+#include <stdexcept>
+
+// Opens the frame source named by `kind`. `params` configures the SDK for "camera" and
+// "svo" and provides resolution, framerate and unit to the synthetic generator, which
+// is unbounded when `frames` is negative. SDK failures are thrown as sl::ERROR_CODE.
+// "raw" replays a raw frame dump and "archive" a depth archive.
+static std::unique_ptr<FrameSource> open_frame_source(const std::string &kind, const std::string &path,
+                                                      sl::InitParameters params, int frames = -1)
+{
+    if (kind.compare("camera") == 0)
+    {
+        return std::make_unique<ZedFrameSource>(params);
+    }
+    else if (kind.compare("svo") == 0)
+    {
+        params.input.setFromSVOFile(sl::String(path.c_str()));
+        return std::make_unique<ZedFrameSource>(params);
+    }
+    else if (kind.compare("synthetic") == 0)
+    {
+        sl::Resolution size = sl::getResolution(params.camera_resolution);
+        return std::make_unique<SyntheticFrameSource>(
+            size.width, size.height, params.camera_fps, params.coordinate_units, frames);
+    }
+    else if (kind.compare("raw") == 0)
+    {
+        return std::make_unique<RawFrameSource>(path);
+    }
+    else if (kind.compare("archive") == 0)
+    {
+        return std::make_unique<ArchiveFrameSource>(path);
+    }
+
+    throw std::invalid_argument("Unknown frame source: " + kind);
+}
+
+#endif
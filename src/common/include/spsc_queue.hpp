@@ -0,0 +1,249 @@
+#ifndef __COMMON_SPSC_QUEUE__
+#define __COMMON_SPSC_QUEUE__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Bounded lock-free single producer / single consumer ring. Elements are small trivially
+// copyable handles (pointers into an ObjectPool) so a slot can be read atomically.
+// Besides the regular push, the producer may use push_overwrite to evict the oldest
+// element when the ring is full; both sides then claim elements by advancing `tail`
+// with a CAS, so whoever wins owns the element.
+template <typename T>
+class SpscQueue
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscQueue elements must be trivially copyable");
+
+public:
+    SpscQueue(size_t capacity)
+        : capacity(capacity), slots(new std::atomic<T>[capacity])
+    {
+    }
+
+    // Drop-newest: returns false and counts a drop when the ring is full
+    bool push(T item)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= capacity)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[h % capacity].store(item, std::memory_order_relaxed);
+        head.store(h + 1, std::memory_order_release);
+        on_pushed(h + 1);
+        return true;
+    }
+
+    // Drop-oldest: always enqueues `item`, returns true and hands back the evicted
+    // element when the ring was full
+    bool push_overwrite(T item, T &evicted)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        bool eviction = false;
+
+        while (h - t >= capacity)
+        {
+            T oldest = slots[t % capacity].load(std::memory_order_relaxed);
+            if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel))
+            {
+                evicted = oldest;
+                eviction = true;
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        slots[h % capacity].store(item, std::memory_order_relaxed);
+        head.store(h + 1, std::memory_order_release);
+        on_pushed(h + 1);
+        return eviction;
+    }
+
+    bool pop(T &item)
+    {
+        uint64_t t = tail.load(std::memory_order_acquire);
+        while (t != head.load(std::memory_order_acquire))
+        {
+            T value = slots[t % capacity].load(std::memory_order_relaxed);
+            if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel))
+            {
+                item = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t depth()
+    {
+        return (size_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+    }
+
+    size_t get_capacity()
+    {
+        return capacity;
+    }
+
+    uint64_t get_pushed()
+    {
+        return pushed.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_dropped()
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    size_t get_high_water()
+    {
+        return high_water.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Padding keeps the producer and consumer indices on separate cache lines
+    // without relying on over-aligned new, which C++14 does not provide
+    size_t capacity;
+    std::unique_ptr<std::atomic<T>[]> slots;
+    char pad_head[64];
+    std::atomic<uint64_t> head{0};
+    char pad_tail[64];
+    std::atomic<uint64_t> tail{0};
+    char pad_stats[64];
+    std::atomic<uint64_t> pushed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<size_t> high_water{0};
+
+    void on_pushed(uint64_t new_head)
+    {
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        size_t level = (size_t)(new_head - tail.load(std::memory_order_relaxed));
+        if (level > high_water.load(std::memory_order_relaxed))
+            high_water.store(level, std::memory_order_relaxed);
+    }
+};
+
+// Classic single producer / single consumer ring for records too large to be stored in
+// an atomic slot. The producer only writes `head` and the consumer only writes `tail`,
+// so a slot is published by the release store of `head` and recycled by that of `tail`.
+// push drops the newest record when the ring is full.
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing elements must be trivially copyable");
+
+public:
+    SpscRing(size_t capacity)
+        : capacity(capacity), slots(new T[capacity])
+    {
+    }
+
+    bool push(const T &item)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= capacity)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[h % capacity] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+
+        item = slots[t % capacity];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t get_dropped()
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    size_t capacity;
+    std::unique_ptr<T[]> slots;
+    char pad_head[64];
+    std::atomic<uint64_t> head{0};
+    char pad_tail[64];
+    std::atomic<uint64_t> tail{0};
+    char pad_stats[64];
+    std::atomic<uint64_t> dropped{0};
+};
+
+// SpscRing of byte records whose size is only known at run time, record_bytes per slot.
+// The producer fills the slot returned by claim() in place and publishes it with
+// commit(), the consumer reads the one returned by front() and recycles it with pop().
+// A full ring makes claim() return nullptr and counts the record as dropped.
+class SpscRecordRing
+{
+public:
+    SpscRecordRing(size_t capacity, size_t record_bytes)
+        : capacity(capacity), record_bytes(record_bytes), slots(new uint8_t[capacity * record_bytes])
+    {
+    }
+
+    uint8_t *claim()
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= capacity)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots[(h % capacity) * record_bytes];
+    }
+
+    void commit()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    const uint8_t *front()
+    {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return nullptr;
+        return &slots[(t % capacity) * record_bytes];
+    }
+
+    void pop()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t get_record_bytes() const
+    {
+        return record_bytes;
+    }
+
+    uint64_t get_dropped()
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    size_t capacity;
+    size_t record_bytes;
+    std::unique_ptr<uint8_t[]> slots;
+    char pad_head[64];
+    std::atomic<uint64_t> head{0};
+    char pad_tail[64];
+    std::atomic<uint64_t> tail{0};
+    char pad_stats[64];
+    std::atomic<uint64_t> dropped{0};
+};
+
+#endif
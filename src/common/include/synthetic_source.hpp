@@ -0,0 +1,250 @@
+#ifndef __COMMON_SYNTHETIC_SOURCE__
+#define __COMMON_SYNTHETIC_SOURCE__
+
+#include <frame_source.hpp>
+#include <cstdint>
+#include <limits>
+
+#define SYNTHETIC_START_NS 1000000000ULL
+#define SYNTHETIC_BASELINE 0.12f
+#define SYNTHETIC_MAX_DEPTH 10.f
+
+// Deterministic stereo scene: a sloped floor with a box oscillating in front of it,
+// an invalid occlusion band on the left, an out of range band on top and sparse holes.
+// Every frame is a pure function of its index so runs are reproducible across hosts.
+class SyntheticFrameSource : public FrameSource
+{
+public:
+    SyntheticFrameSource(size_t width, size_t height, int fps, sl::UNIT unit, int frames = -1)
+        : width(width), height(height), fps(fps > 0 ? fps : 30), unit(unit), frames(frames)
+    {
+        scale = meters_to_unit(unit);
+        focal = 0.5f * (float)width;
+    }
+
+    sl::ERROR_CODE retrieve_image(sl::Mat &image, sl::VIEW view = sl::VIEW::LEFT) override
+    {
+        if (position < 0)
+            return sl::ERROR_CODE::FAILURE;
+
+        switch (view)
+        {
+        case sl::VIEW::LEFT:
+            generate_image(image, false);
+            break;
+        case sl::VIEW::RIGHT:
+            generate_image(image, true);
+            break;
+        case sl::VIEW::SIDE_BY_SIDE:
+            generate_image(scratch_left, false);
+            generate_image(scratch_right, true);
+            compose_side_by_side(scratch_left, scratch_right, image);
+            break;
+        case sl::VIEW::DEPTH:
+            generate_depth(scratch_depth);
+            render_depth_view(scratch_depth, image, SYNTHETIC_MAX_DEPTH * scale);
+            break;
+        default:
+            return sl::ERROR_CODE::INVALID_FUNCTION_PARAMETERS;
+        }
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+    sl::ERROR_CODE retrieve_measure(sl::Mat &measure, sl::MEASURE type = sl::MEASURE::DEPTH) override
+    {
+        if (position < 0)
+            return sl::ERROR_CODE::FAILURE;
+        if (type != sl::MEASURE::DEPTH)
+            return sl::ERROR_CODE::INVALID_FUNCTION_PARAMETERS;
+
+        generate_depth(measure);
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+    sl::ERROR_CODE get_sensors_data(sl::SensorsData &data, sl::TIME_REFERENCE reference) override
+    {
+        if (position < 0)
+            return sl::ERROR_CODE::FAILURE;
+
+        float t = seconds();
+        sl::Timestamp timestamp = get_timestamp(reference);
+
+        data.imu.is_available = true;
+        data.imu.timestamp = timestamp;
+        data.imu.linear_acceleration = sl::float3(0.05f * std::sin(t), 9.81f, 0.02f * std::cos(t));
+        data.imu.angular_velocity = sl::float3(0.1f * std::sin(0.5f * t), 0.f, 0.05f * std::cos(0.5f * t));
+        data.imu.pose.setTranslation(sl::Translation(0.5f * std::sin(0.5f * t), 0.1f, 1.f));
+
+        data.barometer.is_available = true;
+        data.barometer.timestamp = timestamp;
+        data.barometer.pressure = 1013.25f + 0.1f * std::sin(0.1f * t);
+
+        data.magnetometer.is_available = true;
+        data.magnetometer.timestamp = timestamp;
+        data.magnetometer.magnetic_field_calibrated = sl::float3(30.f + std::sin(t), -5.f, 42.f);
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+    sl::Timestamp get_timestamp(sl::TIME_REFERENCE reference) override
+    {
+        return sl::Timestamp(SYNTHETIC_START_NS + (uint64_t)std::max(position, 0) * 1000000000ULL / fps);
+    }
+
+    int get_position() override
+    {
+        return position;
+    }
+
+    void set_position(int frame) override
+    {
+        next = std::max(frame, 0);
+    }
+
+    int get_frame_count() override
+    {
+        return frames;
+    }
+
+    float get_fps() override
+    {
+        return (float)fps;
+    }
+
+    float get_current_fps() override
+    {
+        return (float)fps;
+    }
+
+    sl::UNIT get_unit() override
+    {
+        return unit;
+    }
+
+    sl::Resolution get_resolution() override
+    {
+        return sl::Resolution(width, height);
+    }
+
+    sl::ERROR_CODE get_intrinsics(CameraIntrinsics &intrinsics) override
+    {
+        intrinsics.fx = focal;
+        intrinsics.fy = focal;
+        intrinsics.cx = 0.5f * (float)width;
+        intrinsics.cy = 0.5f * (float)height;
+        intrinsics.width = (int)width;
+        intrinsics.height = (int)height;
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+protected:
+    sl::ERROR_CODE grab_frame(sl::RuntimeParameters &params) override
+    {
+        if (frames >= 0 && next >= frames)
+            return sl::ERROR_CODE::END_OF_SVOFILE_REACHED;
+
+        position = next++;
+        update_scene();
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+private:
+    size_t width, height;
+    int fps;
+    sl::UNIT unit;
+    int frames;
+    int position = -1;
+    int next = 0;
+    float scale, focal;
+    int box_x0, box_x1, box_y0, box_y1;
+    float box_depth;
+    sl::Mat scratch_left, scratch_right, scratch_depth;
+
+    float seconds()
+    {
+        return (float)position / (float)fps;
+    }
+
+    void update_scene()
+    {
+        const float two_pi = 6.2831853f;
+        float t = seconds();
+        int box_w = (int)width / 5;
+        int box_h = (int)height / 3;
+        int cx = (int)width / 2 + (int)((float)width / 4.f * std::sin(two_pi * t / 4.f));
+        int cy = (int)height / 2;
+
+        box_x0 = cx - box_w / 2;
+        box_x1 = cx + box_w / 2;
+        box_y0 = cy - box_h / 2;
+        box_y1 = cy + box_h / 2;
+        box_depth = 1.2f + 0.3f * std::sin(two_pi * t / 6.f);
+    }
+
+    // Scene depth in meters, NaN for occluded pixels and +inf for out of range ones
+    float scene_depth(size_t col, size_t row)
+    {
+        if (col < width / 32)
+            return std::numeric_limits<float>::quiet_NaN();
+        if (row < height / 40)
+            return std::numeric_limits<float>::infinity();
+
+        uint32_t hash = ((uint32_t)col * 73856093u) ^ ((uint32_t)row * 19349663u) ^ ((uint32_t)position * 83492791u);
+        if (hash % 61 == 0)
+            return std::numeric_limits<float>::quiet_NaN();
+
+        return solid_depth(col, row);
+    }
+
+    float solid_depth(size_t col, size_t row)
+    {
+        int c = (int)col;
+        int r = (int)row;
+        if (c >= box_x0 && c < box_x1 && r >= box_y0 && r < box_y1)
+            return box_depth;
+        return 4.f - 2.5f * (float)row / (float)height;
+    }
+
+    unsigned char texture(int col, int row)
+    {
+        int cell = ((col >> 4) + (row >> 4)) & 1;
+        return (unsigned char)((cell ? 160 : 64) + ((col * 7 + row * 3) & 31));
+    }
+
+    void generate_depth(sl::Mat &depth)
+    {
+        ensure_mat(depth, width, height, sl::MAT_TYPE::F32_C1);
+        TypedView<float> view(depth);
+
+        for (size_t row = 0; row < height; ++row)
+        {
+            float *dst = view.row((int)row);
+            for (size_t col = 0; col < width; ++col)
+                dst[col] = scene_depth(col, row) * scale;
+        }
+    }
+
+    // The right view samples the left texture shifted by the disparity of the scene
+    void generate_image(sl::Mat &image, bool right)
+    {
+        ensure_mat(image, width, height, sl::MAT_TYPE::U8_C4);
+        TypedView<sl::uchar4> view(image);
+
+        for (size_t row = 0; row < height; ++row)
+        {
+            sl::uchar4 *dst = view.row((int)row);
+            for (size_t col = 0; col < width; ++col)
+            {
+                float d = solid_depth(col, row);
+                int shift = right ? (int)(focal * SYNTHETIC_BASELINE / d) : 0;
+                unsigned char value = texture((int)col + shift, (int)row);
+                unsigned char shade = (unsigned char)(255.f * (1.f - d / SYNTHETIC_MAX_DEPTH));
+                dst[col].x = value;
+                dst[col].y = (unsigned char)((value + shade) / 2);
+                dst[col].z = shade;
+                dst[col].w = 255;
+            }
+        }
+    }
+};
+
+#endif
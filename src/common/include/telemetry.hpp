@@ -0,0 +1,161 @@
+#ifndef __COMMON_TELEMETRY__
+#define __COMMON_TELEMETRY__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#define TELEMETRY_MAX_ZONES 64
+
+// Sequence lock for a trivially copyable snapshot. Writers never wait on readers; a
+// reader copies the payload and retries if a write overlapped. The payload is stored
+// as relaxed atomic words so concurrent copies are well defined. Writers serialize
+// among themselves by moving the sequence from even to odd with a CAS.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock()
+    {
+        for (auto &word : words)
+            word.store(0, std::memory_order_relaxed);
+    }
+
+    // `accept` sees the current value while the lock is held and may veto the write
+    template <typename Accept>
+    bool store(const T &value, Accept accept)
+    {
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        while (true)
+        {
+            if ((seq & 1) == 0 && sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+                break;
+            seq = sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        bool accepted = accept(read_words());
+        if (accepted)
+        {
+            uint64_t buffer[WORDS] = {};
+            std::memcpy(buffer, &value, sizeof(T));
+            for (size_t i = 0; i < WORDS; ++i)
+                words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        sequence.store(seq + 2, std::memory_order_release);
+        return accepted;
+    }
+
+    // Consistent copy of the last write, returns its sequence number (0 before any write)
+    uint64_t load(T &value) const
+    {
+        while (true)
+        {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            value = read_words();
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before)
+                return before;
+        }
+    }
+
+    uint64_t get_sequence() const
+    {
+        return sequence.load(std::memory_order_acquire);
+    }
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[WORDS];
+
+    T read_words() const
+    {
+        uint64_t buffer[WORDS];
+        for (size_t i = 0; i < WORDS; ++i)
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+};
+
+struct ZoneReading
+{
+    float reading;
+    float valid_fraction;
+};
+
+struct DepthTelemetry
+{
+    uint64_t frame_id;
+    uint64_t timestamp_ns;
+    uint64_t latency_ns;
+    float distance;
+    uint32_t zone_count;
+    ZoneReading zones[TELEMETRY_MAX_ZONES];
+};
+
+static inline uint64_t steady_now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Latest depth measurement, published by the compute workers and read by any number of
+// consumers (console, logger, exporters). Frames finishing out of order never replace
+// a newer one.
+class TelemetryBus
+{
+public:
+    bool publish(const DepthTelemetry &telemetry)
+    {
+        return snapshot.store(telemetry, [&telemetry](const DepthTelemetry &current)
+                              { return telemetry.frame_id > current.frame_id; });
+    }
+
+    bool read(DepthTelemetry &telemetry) const
+    {
+        return snapshot.load(telemetry) != 0;
+    }
+
+    // Polls until a frame newer than `frame_id` is published or `timeout` expires
+    bool wait_newer(uint64_t frame_id, DepthTelemetry &telemetry, std::chrono::microseconds timeout) const
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        int idle = 0;
+
+        while (true)
+        {
+            if (snapshot.load(telemetry) != 0 && telemetry.frame_id > frame_id)
+                return true;
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+
+            if (++idle < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+private:
+    SeqLock<DepthTelemetry> snapshot;
+};
+
+#endif
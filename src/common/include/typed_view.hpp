@@ -0,0 +1,107 @@
+#ifndef __COMMON_TYPED_VIEW__
+#define __COMMON_TYPED_VIEW__
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Element type of every sl::MAT_TYPE, specialised in mat_types.hpp
+template <typename T>
+struct MatTypeOf;
+
+// Zero-copy view of the CPU buffer of an sl::Mat, or of any buffer with rows
+// stride_bytes apart, as rows of T. The element type and stride are checked once at
+// construction, throwing std::invalid_argument, so loops only deal with plain
+// pointers. T may be const for read only access.
+template <typename T>
+class TypedView
+{
+public:
+    using Element = typename std::remove_const<T>::type;
+
+    TypedView()
+    {
+    }
+
+    // View of an sl::Mat, which needs mat_types.hpp. A Mat that was never allocated gives
+    // an empty view. Kept a template so the kernels using views build without the SDK.
+    template <typename Mat, typename = decltype(std::declval<Mat &>().getDataType())>
+    explicit TypedView(Mat &mat)
+    {
+        if (!mat.isInit())
+            return;
+        if (mat.getDataType() != MatTypeOf<Element>::value())
+            throw std::invalid_argument("sl::Mat element type does not match the view");
+        // getPtr and getStepBytes default to the CPU buffer
+        bind(mat.template getPtr<Element>(), mat.getStepBytes(), (int)mat.getWidth(), (int)mat.getHeight());
+    }
+
+    TypedView(T *data, size_t stride_bytes, int width, int height)
+    {
+        bind(data, stride_bytes, width, height);
+    }
+
+    T *row(int row) const
+    {
+        return reinterpret_cast<T *>(reinterpret_cast<Byte *>(pointer) + (size_t)row * stride);
+    }
+
+    T &operator()(int row, int col) const
+    {
+        return this->row(row)[col];
+    }
+
+    // Sub-rectangle sharing the same rows, not clipped
+    TypedView sub(int x, int y, int width, int height) const
+    {
+        return TypedView(row(y) + x, stride, width, height);
+    }
+
+    T *data() const
+    {
+        return pointer;
+    }
+
+    size_t stride_bytes() const
+    {
+        return stride;
+    }
+
+    int width() const
+    {
+        return cols;
+    }
+
+    int height() const
+    {
+        return rows;
+    }
+
+    bool empty() const
+    {
+        return pointer == nullptr || cols == 0 || rows == 0;
+    }
+
+private:
+    using Byte = typename std::conditional<std::is_const<T>::value, const uint8_t, uint8_t>::type;
+
+    T *pointer = nullptr;
+    size_t stride = 0;
+    int cols = 0;
+    int rows = 0;
+
+    void bind(T *data, size_t stride_bytes, int width, int height)
+    {
+        if (width < 0 || height < 0 || stride_bytes % alignof(Element) != 0 ||
+            (height > 1 && stride_bytes < (size_t)width * sizeof(Element)))
+            throw std::invalid_argument("Row stride does not fit the view");
+        pointer = data;
+        stride = stride_bytes;
+        cols = width;
+        rows = height;
+    }
+};
+
+#endif
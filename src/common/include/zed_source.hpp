@@ -0,0 +1,127 @@
+#ifndef __COMMON_ZED_SOURCE__
+#define __COMMON_ZED_SOURCE__
+
+#include <frame_source.hpp>
+
+// Live camera or SVO playback through the ZED SDK
+class ZedFrameSource : public FrameSource
+{
+public:
+    ZedFrameSource(sl::InitParameters params)
+        : unit(params.coordinate_units)
+    {
+        camera = std::make_unique<sl::Camera>();
+        auto err = camera->open(params);
+
+        if (err != sl::ERROR_CODE::SUCCESS)
+        {
+            throw err;
+        }
+
+        fps = camera->getCameraInformation().camera_configuration.fps;
+    }
+
+    ~ZedFrameSource()
+    {
+        disable_recording();
+        camera->close();
+    }
+
+    sl::ERROR_CODE retrieve_image(sl::Mat &image, sl::VIEW view = sl::VIEW::LEFT) override
+    {
+        return camera->retrieveImage(image, view);
+    }
+
+    sl::ERROR_CODE retrieve_measure(sl::Mat &measure, sl::MEASURE type = sl::MEASURE::DEPTH) override
+    {
+        return camera->retrieveMeasure(measure, type);
+    }
+
+    sl::ERROR_CODE get_sensors_data(sl::SensorsData &data, sl::TIME_REFERENCE reference) override
+    {
+        return camera->getSensorsData(data, reference);
+    }
+
+    sl::Timestamp get_timestamp(sl::TIME_REFERENCE reference) override
+    {
+        return camera->getTimestamp(reference);
+    }
+
+    int get_position() override
+    {
+        return camera->getSVOPosition();
+    }
+
+    void set_position(int position) override
+    {
+        camera->setSVOPosition(position);
+    }
+
+    int get_frame_count() override
+    {
+        return camera->getSVONumberOfFrames();
+    }
+
+    float get_fps() override
+    {
+        return fps;
+    }
+
+    float get_current_fps() override
+    {
+        return camera->getCurrentFPS();
+    }
+
+    sl::UNIT get_unit() override
+    {
+        return unit;
+    }
+
+    sl::Resolution get_resolution() override
+    {
+        return camera->getCameraInformation().camera_configuration.resolution;
+    }
+
+    sl::ERROR_CODE get_intrinsics(CameraIntrinsics &intrinsics) override
+    {
+        sl::CameraConfiguration config = camera->getCameraInformation().camera_configuration;
+        intrinsics.fx = config.calibration_parameters.left_cam.fx;
+        intrinsics.fy = config.calibration_parameters.left_cam.fy;
+        intrinsics.cx = config.calibration_parameters.left_cam.cx;
+        intrinsics.cy = config.calibration_parameters.left_cam.cy;
+        intrinsics.width = (int)config.resolution.width;
+        intrinsics.height = (int)config.resolution.height;
+        return sl::ERROR_CODE::SUCCESS;
+    }
+
+    sl::Camera *get_camera() override
+    {
+        return camera.get();
+    }
+
+protected:
+    sl::ERROR_CODE grab_frame(sl::RuntimeParameters &params) override
+    {
+        return camera->grab(params);
+    }
+
+    sl::ERROR_CODE enable_svo_recording(const std::string &filename, sl::SVO_COMPRESSION_MODE mode) override
+    {
+        sl::RecordingParameters recording_params;
+        recording_params.compression_mode = mode;
+        recording_params.video_filename = sl::String(filename.c_str());
+        return camera->enableRecording(recording_params);
+    }
+
+    void disable_svo_recording() override
+    {
+        camera->disableRecording();
+    }
+
+private:
+    std::unique_ptr<sl::Camera> camera;
+    sl::UNIT unit;
+    float fps;
+};
+
+#endif
@@ -12,6 +12,7 @@ using ValidDepth = std::vector<std::string>;
 using ValidUnit = std::vector<std::string>;
 using ValidSensing = std::vector<std::string>;
 using ValidGui = std::vector<std::string>;
+using ValidSource = std::vector<std::string>;
 using ArgStringMap = std::map<std::string, std::string>;
 
 class ArgParser
@@ -24,6 +25,20 @@ public:
         string_map.insert(std::make_pair(std::string("-d"), std::string("ultra")));
         string_map.insert(std::make_pair(std::string("-s"), std::string("standard")));
         string_map.insert(std::make_pair(std::string("-g"), std::string("off")));
+        string_map.insert(std::make_pair(std::string("-src"), std::string("camera")));
+        string_map.insert(std::make_pair(std::string("-i"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-w"), std::string("2")));
+        string_map.insert(std::make_pair(std::string("-b"), std::string("70")));
+        string_map.insert(std::make_pair(std::string("-r"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-m"), std::string("mean")));
+        string_map.insert(std::make_pair(std::string("-v"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-vs"), std::string("0.05")));
+        string_map.insert(std::make_pair(std::string("-c"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-near"), std::string("0.3")));
+        string_map.insert(std::make_pair(std::string("-far"), std::string("10")));
+        string_map.insert(std::make_pair(std::string("-l"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-lf"), std::string("csv")));
+        string_map.insert(std::make_pair(std::string("-lr"), std::string("64")));
 
         valid_depth.push_back("ultra");
         valid_depth.push_back("quality");
@@ -40,6 +55,12 @@ public:
 
         valid_gui.push_back("on");
         valid_gui.push_back("off");
+
+        valid_source.push_back("camera");
+        valid_source.push_back("svo");
+        valid_source.push_back("synthetic");
+        valid_source.push_back("raw");
+        valid_source.push_back("archive");
     }
 
     void parse(int argc, char *argv[])
@@ -96,6 +117,71 @@ public:
     {
         return string_map.at("-s");
     }
+    std::string get_source()
+    {
+        return string_map.at("-src");
+    }
+    std::string get_input_file()
+    {
+        return string_map.at("-i");
+    }
+    int get_workers()
+    {
+        return std::stoi(string_map.at("-w"));
+    }
+    // Side of the measurement box in pixels, 0 for the full frame
+    int get_box_size()
+    {
+        if (string_map.at("-b").compare("full") == 0)
+            return 0;
+        return std::stoi(string_map.at("-b"));
+    }
+    std::string get_roi_file()
+    {
+        return string_map.at("-r");
+    }
+    // mean, median or p<0-100>
+    std::string get_statistic()
+    {
+        return string_map.at("-m");
+    }
+    std::string get_volume_file()
+    {
+        return string_map.at("-v");
+    }
+    // Voxel size of the occupancy map in meters
+    float get_voxel_size()
+    {
+        return std::stof(string_map.at("-vs"));
+    }
+    std::string get_calibration_file()
+    {
+        return string_map.at("-c");
+    }
+    // Depth range of the GUI colormap in meters
+    float get_near_depth()
+    {
+        return std::stof(string_map.at("-near"));
+    }
+    float get_far_depth()
+    {
+        return std::stof(string_map.at("-far"));
+    }
+    // Base name of the distance log files, empty to log nothing
+    std::string get_log_file()
+    {
+        return string_map.at("-l");
+    }
+    // csv or bin
+    std::string get_log_format()
+    {
+        return string_map.at("-lf");
+    }
+    // Size in MB at which the log moves to a new file, 0 for a single file
+    int get_log_rotation()
+    {
+        return std::stoi(string_map.at("-lr"));
+    }
     bool get_gui_option()
     {
         if (string_map.at("-g").compare("on") == 0)
@@ -110,6 +196,7 @@ private:
     ValidUnit valid_unit;
     ValidSensing valid_sensing;
     ValidGui valid_gui;
+    ValidSource valid_source;
 
     bool check_keyword(const std::string &key, const std::string &value)
     {
@@ -128,6 +215,55 @@ private:
             if (std::find(valid_sensing.begin(), valid_sensing.end(), value) != valid_sensing.end())
                 return true;
         }
+        else if (key.compare("-src") == 0)
+        {
+            if (std::find(valid_source.begin(), valid_source.end(), value) != valid_source.end())
+                return true;
+        }
+        else if (key.compare("-i") == 0 || key.compare("-r") == 0 || key.compare("-v") == 0 ||
+                 key.compare("-c") == 0 || key.compare("-l") == 0)
+        {
+            if (value.compare("") != 0)
+                return true;
+        }
+        else if (key.compare("-w") == 0)
+        {
+            if (is_number(value) && std::stoi(value) > 0)
+                return true;
+        }
+        else if (key.compare("-m") == 0)
+        {
+            if (value.compare("mean") == 0 || value.compare("median") == 0)
+                return true;
+            if (value.size() > 1 && value[0] == 'p' && is_number(value.substr(1)) &&
+                std::stoi(value.substr(1)) <= 100)
+                return true;
+        }
+        else if (key.compare("-vs") == 0)
+        {
+            if (is_decimal(value) && std::stof(value) > 0.f && std::stof(value) <= 1.f)
+                return true;
+        }
+        else if (key.compare("-near") == 0 || key.compare("-far") == 0)
+        {
+            if (is_decimal(value) && std::stof(value) <= 100.f)
+                return true;
+        }
+        else if (key.compare("-lf") == 0)
+        {
+            if (value.compare("csv") == 0 || value.compare("bin") == 0)
+                return true;
+        }
+        else if (key.compare("-lr") == 0)
+        {
+            if (is_number(value))
+                return true;
+        }
+        else if (key.compare("-b") == 0)
+        {
+            if (value.compare("full") == 0 || (is_number(value) && std::stoi(value) > 0))
+                return true;
+        }
         else
         {
             if (std::find(valid_gui.begin(), valid_gui.end(), value) != valid_gui.end())
@@ -136,6 +272,21 @@ private:
         return false;
     }
 
+    bool is_number(const std::string &s)
+    {
+        return !s.empty() && s.size() < 5 &&
+               std::find_if(s.begin(), s.end(), [](unsigned char c)
+                            { return !std::isdigit(c); }) == s.end();
+    }
+
+    bool is_decimal(const std::string &s)
+    {
+        return !s.empty() && s.size() < 10 && std::count(s.begin(), s.end(), '.') <= 1 &&
+               std::find_if(s.begin(), s.end(), [](unsigned char c)
+                            { return !std::isdigit(c) && c != '.'; }) == s.end() &&
+               s != ".";
+    }
+
     void bad_keyword(const std::string &key, const std::string &value)
     {
         std::string message = "Invalid keyword value pair: (" + key + ", " + value + ").";
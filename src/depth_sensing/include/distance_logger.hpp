@@ -0,0 +1,327 @@
+#ifndef __DEPTH_DISTANCE_LOGGER__
+#define __DEPTH_DISTANCE_LOGGER__
+
+#include <roi.hpp>
+#include <spsc_queue.hpp>
+#include <telemetry.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Binary log layout: a DistanceLogHeader, then one record of header.record_bytes per
+// frame, the DepthTelemetry fields up to `zones` followed by zone_count ZoneReadings
+// in the order of the ROI file. Every rotated file starts with its own header. The log
+// keeps every zone, even past the TELEMETRY_MAX_ZONES published on the telemetry bus.
+#define DISTANCE_LOG_MAGIC "ZEDDST01"
+#define DISTANCE_LOG_VERSION 1
+#define DISTANCE_LOG_RING 2048
+#define DISTANCE_LOG_BATCH 256
+#define DISTANCE_LOG_ROTATE_MB 64
+// Frames a worker may lag behind the others and still be written in order
+#define DISTANCE_LOG_REORDER 256
+#define DISTANCE_LOG_HEAD_BYTES offsetof(DepthTelemetry, zones)
+
+struct DistanceLogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_bytes;
+    uint32_t zone_count;
+    uint32_t file_index;
+    char unit[8];
+};
+
+enum class DistanceLogFormat
+{
+    BINARY,
+    CSV
+};
+
+// Every computed frame to disk. Each compute worker owns a lock-free ring of
+// preallocated records sized for all the zones, so logging a frame is a copy and never
+// waits on I/O; a full ring drops the record and counts it. A writer thread drains the
+// rings every 20 ms and holds records back until frame order across workers is known,
+// up to DISTANCE_LOG_REORDER frames; later ones are written late and counted. It
+// formats the records into one buffer and writes it, starting a new file
+// <base>_<index>.<bin|csv> once rotate_bytes are reached. Frames the pipeline dropped
+// before compute never reach the logger, report() takes their count.
+class DistanceLogger
+{
+public:
+    DistanceLogger(const std::string &base, DistanceLogFormat format, uint64_t rotate_bytes, int producers,
+                   const std::vector<Roi> &rois, const std::string &unit)
+        : base(base), format(format), rotate_bytes(rotate_bytes), unit(unit),
+          zone_count((uint32_t)rois.size()), record_bytes(DISTANCE_LOG_HEAD_BYTES + rois.size() * sizeof(ZoneReading))
+    {
+        for (int i = 0; i < producers; ++i)
+            rings.emplace_back(new SpscRecordRing(DISTANCE_LOG_RING, record_bytes));
+        for (const Roi &roi : rois)
+            zone_names.push_back(roi.name);
+    }
+
+    ~DistanceLogger()
+    {
+        stop();
+    }
+
+    bool start()
+    {
+        if (!open_next())
+            return false;
+
+        writing = true;
+        writer_thread = std::thread(&DistanceLogger::writer_loop, this);
+        return true;
+    }
+
+    // Called once all producers are stopped, writes whatever is left in the rings
+    void stop()
+    {
+        if (!writer_thread.joinable())
+            return;
+
+        writing = false;
+        writer_thread.join();
+        file.close();
+    }
+
+    // From compute worker `producer` only, one producer per ring. `zones` holds the
+    // readings of every ROI, telemetry.zones only the ones the bus carries.
+    void log(size_t producer, const DepthTelemetry &telemetry, const ZoneReading *zones)
+    {
+        uint8_t *record = rings[producer]->claim();
+        if (record == nullptr)
+            return;
+        std::memcpy(record, &telemetry, DISTANCE_LOG_HEAD_BYTES);
+        std::memcpy(record + offsetof(DepthTelemetry, zone_count), &zone_count, sizeof(zone_count));
+        std::memcpy(record + DISTANCE_LOG_HEAD_BYTES, zones, zone_count * sizeof(ZoneReading));
+        rings[producer]->commit();
+    }
+
+    // `skipped` frames were grabbed but dropped before compute, so never logged
+    void report(std::ostream &out, uint64_t skipped = 0)
+    {
+        uint64_t dropped = 0;
+        for (auto &ring : rings)
+            dropped += ring->get_dropped();
+
+        std::streamsize precision = out.precision();
+        out << "Distance log: " << records << " records in " << files << " file(s), " << std::fixed
+            << std::setprecision(1) << bytes / 1e6 << " MB to " << base << "_*" << extension() << ", " << dropped
+            << " dropped, " << skipped << " frames not computed";
+        if (late > 0)
+            out << ", " << late << " written out of order";
+        out << std::defaultfloat << std::setprecision(precision) << std::endl;
+        if (failed)
+            out << "  Could not write " << file_name(files - 1) << ", logging stopped" << std::endl;
+    }
+
+private:
+    std::string base;
+    DistanceLogFormat format;
+    uint64_t rotate_bytes;
+    std::string unit;
+    uint32_t zone_count;
+    size_t record_bytes;
+    std::vector<std::string> zone_names;
+    std::vector<std::unique_ptr<SpscRecordRing>> rings;
+    std::ofstream file;
+    std::thread writer_thread;
+    std::atomic<bool> writing{false};
+
+    // Writer thread only until stop() returns
+    uint64_t records = 0;
+    uint64_t late = 0;
+    uint64_t last_written = 0;
+    uint64_t bytes = 0;
+    uint64_t file_bytes = 0;
+    uint32_t files = 0;
+    bool failed = false;
+
+    const char *extension() const
+    {
+        return format == DistanceLogFormat::BINARY ? ".bin" : ".csv";
+    }
+
+    std::string file_name(uint32_t index) const
+    {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "_%04u", index);
+        return base + suffix + extension();
+    }
+
+    bool open_next()
+    {
+        if (file.is_open())
+            file.close();
+        std::string header = format == DistanceLogFormat::BINARY ? binary_header() : csv_header();
+        file.open(file_name(files), std::ios::binary | std::ios::trunc);
+        files++;
+        if (!file.is_open())
+            return false;
+
+        file.write(header.data(), header.size());
+        file_bytes = header.size();
+        bytes += header.size();
+        return true;
+    }
+
+    std::string binary_header() const
+    {
+        DistanceLogHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, DISTANCE_LOG_MAGIC, sizeof(header.magic));
+        header.version = DISTANCE_LOG_VERSION;
+        header.record_bytes = (uint32_t)record_bytes;
+        header.zone_count = zone_count;
+        header.file_index = files;
+        std::strncpy(header.unit, unit.c_str(), sizeof(header.unit) - 1);
+        return std::string(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    std::string csv_header() const
+    {
+        std::string header = "frame_id,timestamp_ns,latency_ms,distance_" + unit;
+        for (const std::string &name : zone_names)
+            header += "," + name + "_" + unit + "," + name + "_valid";
+        return header + "\n";
+    }
+
+    void append_csv(std::vector<char> &buffer, const uint8_t *record) const
+    {
+        DepthTelemetry telemetry;
+        std::memcpy(&telemetry, record, DISTANCE_LOG_HEAD_BYTES);
+        char field[128];
+        int n = std::snprintf(field, sizeof(field), "%llu,%llu,%.3f,%.2f", (unsigned long long)telemetry.frame_id,
+                              (unsigned long long)telemetry.timestamp_ns, telemetry.latency_ns / 1e6,
+                              telemetry.distance);
+        buffer.insert(buffer.end(), field, field + std::min(n, (int)sizeof(field) - 1));
+        for (uint32_t i = 0; i < zone_count; ++i)
+        {
+            ZoneReading zone;
+            std::memcpy(&zone, record + DISTANCE_LOG_HEAD_BYTES + i * sizeof(ZoneReading), sizeof(zone));
+            n = std::snprintf(field, sizeof(field), ",%.2f,%.3f", zone.reading, zone.valid_fraction);
+            buffer.insert(buffer.end(), field, field + std::min(n, (int)sizeof(field) - 1));
+        }
+        buffer.push_back('\n');
+    }
+
+    // Records wait in `pending` until no worker can still deliver an older frame: every
+    // ring has gone past them, or they are DISTANCE_LOG_REORDER frames behind the newest
+    void writer_loop()
+    {
+        std::vector<uint8_t> pending;
+        std::vector<std::pair<uint64_t, size_t>> order;
+        std::vector<uint64_t> ring_last(rings.size(), 0);
+        uint64_t newest = 0;
+        std::vector<char> buffer;
+        buffer.reserve(DISTANCE_LOG_BATCH * rings.size() * std::max(record_bytes, (size_t)(32 + 24 * zone_count)));
+
+        while (true)
+        {
+            bool stopping = !writing;
+            bool full = false;
+            for (size_t r = 0; r < rings.size(); ++r)
+            {
+                size_t taken = 0;
+                const uint8_t *record;
+                while (taken < DISTANCE_LOG_BATCH && (record = rings[r]->front()) != nullptr)
+                {
+                    uint64_t frame_id;
+                    std::memcpy(&frame_id, record + offsetof(DepthTelemetry, frame_id), sizeof(frame_id));
+                    order.emplace_back(frame_id, pending.size());
+                    pending.insert(pending.end(), record, record + record_bytes);
+                    rings[r]->pop();
+                    ring_last[r] = frame_id;
+                    newest = std::max(newest, frame_id);
+                    taken++;
+                }
+                full = full || taken == DISTANCE_LOG_BATCH;
+            }
+            // Once the rings are empty at stop, nothing older can arrive anymore
+            bool draining = stopping && !full;
+
+            // Workers finish frames out of order, each ring is already in order
+            std::sort(order.begin(), order.end());
+            uint64_t settled = *std::min_element(ring_last.begin(), ring_last.end());
+            size_t ready = 0;
+            while (ready < order.size() &&
+                   (draining || order[ready].first <= settled || order[ready].first + DISTANCE_LOG_REORDER <= newest))
+                ready++;
+            for (size_t i = 0; i < ready && !failed; ++i)
+            {
+                if (order[i].first < last_written)
+                    late++;
+                last_written = std::max(last_written, order[i].first);
+                write_record(&pending[order[i].second], buffer);
+            }
+            flush(buffer);
+            compact(pending, order, ready);
+
+            if (full)
+                continue;
+            if (draining)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    // Drops the first `written` records of `order` and moves the others to the front
+    void compact(std::vector<uint8_t> &pending, std::vector<std::pair<uint64_t, size_t>> &order, size_t written)
+    {
+        std::vector<uint8_t> kept((order.size() - written) * record_bytes);
+        for (size_t i = written; i < order.size(); ++i)
+        {
+            std::memcpy(&kept[(i - written) * record_bytes], &pending[order[i].second], record_bytes);
+            order[i - written] = std::make_pair(order[i].first, (i - written) * record_bytes);
+        }
+        order.resize(order.size() - written);
+        pending.swap(kept);
+    }
+
+    void write_record(const uint8_t *record, std::vector<char> &buffer)
+    {
+        size_t before = buffer.size();
+        if (format == DistanceLogFormat::BINARY)
+            buffer.insert(buffer.end(), record, record + record_bytes);
+        else
+            append_csv(buffer, record);
+        records++;
+
+        file_bytes += buffer.size() - before;
+        if (rotate_bytes > 0 && file_bytes >= rotate_bytes)
+        {
+            flush(buffer);
+            if (!open_next())
+                failed = true;
+        }
+    }
+
+    void flush(std::vector<char> &buffer)
+    {
+        if (buffer.empty() || failed)
+        {
+            buffer.clear();
+            return;
+        }
+        file.write(buffer.data(), buffer.size());
+        file.flush();
+        if (!file)
+            failed = true;
+        bytes += buffer.size();
+        buffer.clear();
+    }
+};
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef __DEPTH_PIPELINE__
+#define __DEPTH_PIPELINE__
+
+#include "utils.hpp"
+#include "volume_monitor.hpp"
+#include "distance_logger.hpp"
+#include <spsc_queue.hpp>
+#include <object_pool.hpp>
+#include <telemetry.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#define PIPELINE_QUEUE_DEPTH 4
+
+struct DepthFrame
+{
+    sl::Mat depth;
+    uint64_t frame_id;
+    sl::Timestamp timestamp;
+    uint64_t grab_ns;
+    float distance;
+    std::vector<RoiStats> zones;
+};
+
+using FrameQueue = SpscQueue<DepthFrame *>;
+
+// Grab thread -> one compute queue per worker -> one display queue per worker.
+// Compute queues drop the incoming frame when a worker falls behind on a live source
+// and make the grab thread wait when replaying a recording. Display queues drop the
+// oldest frame since only the newest one is worth drawing. All frames live in a
+// preallocated pool, nothing is allocated once the Mats have their first size.
+// The optional volume monitor is fed from the grab thread, before any frame is dropped,
+// the optional distance logger from the compute workers with every computed frame.
+class DepthPipeline
+{
+public:
+    DepthPipeline(FrameSource *source, sl::RuntimeParameters params, int workers, bool with_gui,
+                  const MeasureOptions &options, TelemetryBus &bus, const DepthDisplay &display,
+                  VolumeMonitor *monitor = nullptr, DistanceLogger *logger = nullptr)
+        : source(source), params(params), with_gui(with_gui), options(options), bus(bus), display(display),
+          monitor(monitor), logger(logger),
+          pool(workers * (2 * PIPELINE_QUEUE_DEPTH + 1) + 2), integrals(workers), estimators(workers),
+          zone_readings(workers)
+    {
+        for (int i = 0; i < workers; ++i)
+        {
+            compute_queues.emplace_back(new FrameQueue(PIPELINE_QUEUE_DEPTH));
+            display_queues.emplace_back(new FrameQueue(PIPELINE_QUEUE_DEPTH));
+        }
+        for (size_t i = 0; i < pool.size(); ++i)
+            pool.at(i).zones.resize(options.rois.size());
+        for (auto &readings : zone_readings)
+            readings.resize(options.rois.size());
+    }
+
+    ~DepthPipeline()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        running = true;
+        computing = true;
+        grab_thread = std::thread(&DepthPipeline::grab_loop, this);
+        for (size_t i = 0; i < compute_queues.size(); ++i)
+            worker_threads.emplace_back(&DepthPipeline::compute_loop, this, i);
+    }
+
+    // The grab thread stops first, the workers then compute what is left in their
+    // queues so the last frames of a recording are still published and logged
+    void stop()
+    {
+        running = false;
+        if (grab_thread.joinable())
+            grab_thread.join();
+        computing = false;
+        for (auto &worker : worker_threads)
+            worker.join();
+        worker_threads.clear();
+    }
+
+    // Display stage, driven from the caller thread since HighGUI is not thread safe.
+    // Older frames found in the queues are skipped. Returns false when nothing was ready.
+    bool display_step(std::string &unit)
+    {
+        DepthFrame *newest = nullptr;
+        DepthFrame *frame;
+
+        for (auto &queue : display_queues)
+        {
+            while (queue->pop(frame))
+            {
+                if (newest != nullptr && newest->frame_id > frame->frame_id)
+                    std::swap(newest, frame);
+                if (newest != nullptr)
+                {
+                    pool.release(newest);
+                    stale++;
+                }
+                newest = frame;
+            }
+        }
+
+        if (newest == nullptr)
+            return false;
+
+        display.show(newest->depth, newest->distance, unit, options, newest->zones);
+        displayed++;
+        pool.release(newest);
+        return true;
+    }
+
+    // Frames grabbed but never computed since a compute queue was full
+    uint64_t get_compute_dropped()
+    {
+        uint64_t dropped = 0;
+        for (auto &queue : compute_queues)
+            dropped += queue->get_dropped();
+        return dropped;
+    }
+
+    bool end_of_input()
+    {
+        return input_ended.load();
+    }
+
+    void report(std::ostream &out)
+    {
+        out << "Pipeline statistics:" << std::endl;
+        out << "  grab: " << grabbed << " grabbed, " << grab_failures << " failed, "
+            << pool_exhausted << " dropped (pool exhausted), " << retrieve_failures << " depth retrievals failed"
+            << std::endl;
+        for (size_t i = 0; i < compute_queues.size(); ++i)
+        {
+            print_queue(out, "compute", i, *compute_queues[i]);
+            print_queue(out, "display", i, *display_queues[i]);
+        }
+        out << "  compute: " << computed << " frames" << std::endl;
+        if (with_gui)
+            out << "  display: " << displayed << " shown, " << stale << " skipped as stale" << std::endl;
+        if (monitor != nullptr)
+            monitor->report(out);
+    }
+
+private:
+    FrameSource *source;
+    sl::RuntimeParameters params;
+    bool with_gui;
+    MeasureOptions options;
+    TelemetryBus &bus;
+    DepthDisplay display;
+    VolumeMonitor *monitor;
+    DistanceLogger *logger;
+    ObjectPool<DepthFrame> pool;
+    std::vector<IntegralDepth> integrals;
+    std::vector<PercentileEstimator> estimators;
+    // Per worker, the readings of every zone of the frame being published
+    std::vector<std::vector<ZoneReading>> zone_readings;
+    std::vector<std::unique_ptr<FrameQueue>> compute_queues;
+    std::vector<std::unique_ptr<FrameQueue>> display_queues;
+    std::thread grab_thread;
+    std::vector<std::thread> worker_threads;
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> computing{false};
+    std::atomic<bool> input_ended{false};
+
+    std::atomic<uint64_t> grabbed{0};
+    std::atomic<uint64_t> grab_failures{0};
+    std::atomic<uint64_t> pool_exhausted{0};
+    std::atomic<uint64_t> retrieve_failures{0};
+    std::atomic<uint64_t> computed{0};
+    uint64_t displayed = 0;
+    uint64_t stale = 0;
+
+    // The SDK is only ever touched from this thread
+    void grab_loop()
+    {
+        size_t next_worker = 0;
+        uint64_t frame_id = 0;
+        bool recording = source->get_frame_count() > 0;
+
+        while (running)
+        {
+            auto err = source->grab(params);
+            if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+            {
+                input_ended = true;
+                break;
+            }
+            if (err != sl::ERROR_CODE::SUCCESS)
+            {
+                grab_failures++;
+                continue;
+            }
+
+            uint64_t grab_ns = steady_now_ns();
+            frame_id++;
+            grabbed++;
+
+            DepthFrame *frame = pool.acquire();
+            if (frame == nullptr)
+            {
+                pool_exhausted++;
+                continue;
+            }
+
+            // A failed retrieval leaves an older frame's depth in the pooled Mat
+            if (source->retrieve_measure(frame->depth, sl::MEASURE::DEPTH) != sl::ERROR_CODE::SUCCESS)
+            {
+                retrieve_failures++;
+                pool.release(frame);
+                continue;
+            }
+            if (monitor != nullptr)
+                monitor->update(source, frame->depth, frame_id);
+            frame->frame_id = frame_id;
+            frame->grab_ns = grab_ns;
+            frame->timestamp = source->get_timestamp(sl::TIME_REFERENCE::IMAGE);
+
+            // A recording waits for the worker instead, nothing is lost when replaying it
+            // faster than the workers compute
+            FrameQueue &queue = *compute_queues[next_worker];
+            int idle = 0;
+            while (recording && running && queue.depth() >= queue.get_capacity())
+                wait_for_work(idle);
+            if (!queue.push(frame))
+                pool.release(frame);
+            next_worker = (next_worker + 1) % compute_queues.size();
+        }
+    }
+
+    void compute_loop(size_t index)
+    {
+        FrameQueue &input = *compute_queues[index];
+        FrameQueue &output = *display_queues[index];
+        DepthFrame *frame;
+        DepthFrame *evicted;
+        int idle = 0;
+
+        while (true)
+        {
+            if (!input.pop(frame))
+            {
+                if (!computing)
+                    break;
+                wait_for_work(idle);
+                continue;
+            }
+            idle = 0;
+
+            frame->distance = compute_distance(frame->depth, options, estimators[index]);
+            compute_zones(frame->depth, options, integrals[index], estimators[index], frame->zones);
+            publish(frame, index);
+            computed++;
+
+            if (!with_gui)
+                pool.release(frame);
+            else if (output.push_overwrite(frame, evicted))
+                pool.release(evicted);
+        }
+    }
+
+    void publish(DepthFrame *frame, size_t index)
+    {
+        DepthTelemetry telemetry;
+        telemetry.frame_id = frame->frame_id;
+        telemetry.timestamp_ns = frame->timestamp.getNanoseconds();
+        telemetry.distance = frame->distance;
+        // The bus snapshot has room for TELEMETRY_MAX_ZONES, the log takes them all
+        std::vector<ZoneReading> &readings = zone_readings[index];
+        for (size_t i = 0; i < readings.size(); ++i)
+        {
+            readings[i].reading = (float)options.zone_reading(frame->zones[i]);
+            readings[i].valid_fraction = (float)frame->zones[i].valid_fraction();
+        }
+        telemetry.zone_count = (uint32_t)std::min(readings.size(), (size_t)TELEMETRY_MAX_ZONES);
+        std::copy(readings.begin(), readings.begin() + telemetry.zone_count, telemetry.zones);
+        telemetry.latency_ns = steady_now_ns() - frame->grab_ns;
+        bus.publish(telemetry);
+        if (logger != nullptr)
+            logger->log(index, telemetry, readings.data());
+    }
+
+    static void wait_for_work(int &idle)
+    {
+        if (++idle < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    static void print_queue(std::ostream &out, const char *stage, size_t index, FrameQueue &queue)
+    {
+        out << "  " << stage << "[" << index << "]: depth " << queue.depth() << "/" << queue.get_capacity()
+            << ", high water " << queue.get_high_water() << ", queued " << queue.get_pushed()
+            << ", dropped " << queue.get_dropped() << std::endl;
+    }
+};
+
+#endif
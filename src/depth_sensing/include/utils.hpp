@@ -2,92 +2,29 @@
 #define __DEPTH_UTILS__
 
 #include <sl/Camera.hpp>
+#include <sources.hpp>
+#include <depth_stats.hpp>
+#include <integral_depth.hpp>
+#include <depth_percentile.hpp>
+#include <depth_colormap.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <memory>
 #include <stdexcept>
 #include <cmath>
+#include <algorithm>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
-// Mapping between MAT_TYPE and CV_TYPE
-static int getOCVtype(sl::MAT_TYPE type)
-{
-    int cv_type = -1;
-    switch (type)
-    {
-    case sl::MAT_TYPE::F32_C1:
-        cv_type = CV_32FC1;
-        break;
-    case sl::MAT_TYPE::F32_C2:
-        cv_type = CV_32FC2;
-        break;
-    case sl::MAT_TYPE::F32_C3:
-        cv_type = CV_32FC3;
-        break;
-    case sl::MAT_TYPE::F32_C4:
-        cv_type = CV_32FC4;
-        break;
-    case sl::MAT_TYPE::U8_C1:
-        cv_type = CV_8UC1;
-        break;
-    case sl::MAT_TYPE::U8_C2:
-        cv_type = CV_8UC2;
-        break;
-    case sl::MAT_TYPE::U8_C3:
-        cv_type = CV_8UC3;
-        break;
-    case sl::MAT_TYPE::U8_C4:
-        cv_type = CV_8UC4;
-        break;
-    default:
-        break;
-    }
-    return cv_type;
-}
-
-static cv::Mat slMat2cvMat(sl::Mat &input)
-{
-    // Since cv::Mat data requires a uchar* pointer, we get the uchar1 pointer from sl::Mat (getPtr<T>())
-    // cv::Mat and sl::Mat will share a single memory structure
-    return cv::Mat(input.getHeight(), input.getWidth(), getOCVtype(input.getDataType()), input.getPtr<sl::uchar1>(sl::MEM::CPU), input.getStepBytes(sl::MEM::CPU));
-}
-
-static std::unique_ptr<sl::Camera> get_camera(sl::DEPTH_MODE depth_mode, sl::UNIT unit)
+static std::unique_ptr<FrameSource> get_frame_source(
+    const std::string &source, const std::string &input, sl::DEPTH_MODE depth_mode, sl::UNIT unit)
 {
     sl::InitParameters params;
     params.depth_mode = depth_mode;
     params.coordinate_units = unit;
 
-    auto zed_camera = std::make_unique<sl::Camera>();
-    auto err = zed_camera->open(params);
-
-    if (err != sl::ERROR_CODE::SUCCESS)
-    {
-        throw err;
-    }
-
-    return zed_camera;
-}
-
-static inline sl::UNIT string2unit(const std::string &s_unit)
-{
-    if (s_unit.compare("milli") == 0)
-        return sl::UNIT::MILLIMETER;
-
-    else if (s_unit.compare("centi") == 0)
-        return sl::UNIT::CENTIMETER;
-
-    else if (s_unit.compare("meter") == 0)
-        return sl::UNIT::METER;
-
-    else if (s_unit.compare("inch") == 0)
-        return sl::UNIT::INCH;
-
-    else if (s_unit.compare("foot") == 0)
-        return sl::UNIT::FOOT;
-
-    return sl::UNIT::MILLIMETER;
+    return open_frame_source(source, input, params);
 }
 
 static inline std::string unit_shorthand(const std::string &s_unit)
@@ -135,59 +72,153 @@ static inline sl::SENSING_MODE string2sensing(const std::string &s_sensing)
     return sl::SENSING_MODE::STANDARD;
 }
 
+// "mean" -> -1, "median" -> 0.5, "p<N>" -> N / 100
+static inline float string2quantile(const std::string &s_mode)
+{
+    if (s_mode.compare("median") == 0)
+        return 0.5f;
+
+    else if (s_mode.size() > 1 && s_mode[0] == 'p')
+        return std::stof(s_mode.substr(1)) / 100.f;
+
+    return -1.f;
+}
+
 #define BOX_WIDTH 70
 #define BOX_HEIGHT 70
-static float compute_distance(sl::Mat &depth_map)
+
+// What is measured on each frame and how a region is reduced to a single reading
+struct MeasureOptions
 {
-    cv::Mat cv_depth_map = slMat2cvMat(depth_map);
-    cv::Mat compute_region(
-        cv_depth_map,
-        cv::Rect(cv_depth_map.cols / 2 - BOX_WIDTH/2,
-                 cv_depth_map.rows / 2 - BOX_HEIGHT/2, BOX_WIDTH, BOX_HEIGHT));
-
-    float cum_sum = 0;
-    int invalid_count = 0;
-    for (int i = 0; i < compute_region.rows; ++i)
+    int box_width = BOX_WIDTH;
+    int box_height = BOX_HEIGHT;
+    float quantile = -1.f; // < 0 reports the mean, otherwise this percentile
+    std::vector<Roi> rois;
+
+    double zone_reading(const RoiStats &zone) const
     {
-        for (int j = 0; j < compute_region.cols; ++j)
-        {
-            float temp = compute_region.at<float>(i, j);
+        return quantile < 0.f ? zone.mean() : zone.percentile;
+    }
+};
+
+// Measurement box centered in the frame and clamped to it, 0 selects the whole frame
+static cv::Rect measurement_box(int cols, int rows, int box_width, int box_height)
+{
+    if (box_width <= 0 || box_height <= 0)
+        return cv::Rect(0, 0, cols, rows);
 
-            if (isnanf(temp) || isinff(temp))
-            {
-                invalid_count++;
-                continue;
-            }
+    int width = std::min(box_width, cols);
+    int height = std::min(box_height, rows);
+    return cv::Rect(cols / 2 - width / 2, rows / 2 - height / 2, width, height);
+}
 
-            cum_sum += temp;
-        }
+static float region_reading(sl::Mat &depth_map, int x, int y, int width, int height,
+                            const MeasureOptions &options, PercentileEstimator &estimator)
+{
+    TypedView<const float> region = TypedView<const float>(depth_map).sub(x, y, width, height);
+
+    if (options.quantile < 0.f)
+        return (float)compute_depth_stats(region.data(), region.stride_bytes(), width, height).mean();
+    return estimator.percentile(region.data(), region.stride_bytes(), width, height, options.quantile);
+}
+
+static float compute_distance(sl::Mat &depth_map, const MeasureOptions &options, PercentileEstimator &estimator)
+{
+    cv::Rect box = measurement_box(depth_map.getWidth(), depth_map.getHeight(), options.box_width, options.box_height);
+    return region_reading(depth_map, box.x, box.y, box.width, box.height, options, estimator);
+}
+
+// Per zone statistics from the summed-area tables of `integral`, rebuilt from `depth_map`.
+// Percentiles cannot come from the tables and are computed on each zone directly.
+static void compute_zones(sl::Mat &depth_map, const MeasureOptions &options, IntegralDepth &integral,
+                          PercentileEstimator &estimator, std::vector<RoiStats> &zones)
+{
+    if (options.rois.empty())
+        return;
+
+    TypedView<const float> depth(depth_map);
+    integral.build(depth.data(), depth.stride_bytes(), depth.width(), depth.height());
+
+    for (size_t i = 0; i < options.rois.size(); ++i)
+    {
+        PixelRect rect = roi_to_pixels(options.rois[i], integral.get_width(), integral.get_height());
+        zones[i] = integral.query(rect);
+        if (options.quantile >= 0.f)
+            zones[i].percentile = region_reading(depth_map, rect.x, rect.y, rect.width, rect.height, options, estimator);
     }
-    return cum_sum / (((float)compute_region.cols * (float)compute_region.rows) - (float)invalid_count);
 }
 
-static void display_depth_map(sl::Mat &view, float distance, std::string& unit)
+static void draw_zones(cv::Mat &cv_view, const MeasureOptions &options, const std::vector<RoiStats> &zones)
 {
-    cv::Mat cv_view = slMat2cvMat(view);
-    cv::cvtColor(cv_view, cv_view, cv::COLOR_BGRA2GRAY);
-    cv::applyColorMap(cv_view, cv_view, cv::COLORMAP_JET);
-
-    cv::rectangle(cv_view,
-                  cv::Rect(cv_view.cols / 2 - BOX_WIDTH/2,
-                           cv_view.rows / 2 - BOX_HEIGHT/2, BOX_WIDTH, BOX_HEIGHT),
-                  cv::Scalar(0, 0, 255),
-                  3);
-
-    cv::namedWindow("Depth Map", cv::WINDOW_NORMAL);
-    cv::resizeWindow("Depth Map", 800, 600);
-    
-    std::stringstream stream;
-    stream << std::fixed << std::setprecision(2) << distance;
-    std::string message = "Distance: " + stream.str() + " " + unit;
-    cv::putText(
-        cv_view, message, cv::Point(50, 50),
-        cv::FONT_HERSHEY_SIMPLEX, 2.0, cv::Scalar(255, 255, 255), 2);
-    cv::imshow("Depth Map", cv_view);
-    cv::waitKey(1);
+    for (size_t i = 0; i < options.rois.size(); ++i)
+    {
+        PixelRect zone = roi_to_pixels(options.rois[i], cv_view.cols, cv_view.rows);
+        cv::Rect rect(zone.x, zone.y, zone.width, zone.height);
+        cv::rectangle(cv_view, rect, cv::Scalar(255, 255, 255), 2);
+
+        std::stringstream stream;
+        stream << options.rois[i].name << " " << std::fixed << std::setprecision(1) << options.zone_reading(zones[i])
+               << " (" << std::setprecision(0) << 100.0 * zones[i].valid_fraction() << "%)";
+        cv::putText(
+            cv_view, stream.str(), cv::Point(rect.x + 5, rect.y + 20),
+            cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 1);
+    }
 }
 
+#define DISPLAY_WIDTH 800
+#define DISPLAY_HEIGHT 600
+
+// Draws the retrieved F32 depth through a DepthColormap at the window size, so the GUI
+// needs no extra sl::VIEW::DEPTH retrieval and no full resolution color conversion. The
+// window is created on the first frame. Only used from the display thread.
+class DepthDisplay
+{
+public:
+    DepthDisplay(float near_depth, float far_depth)
+        : colormap(near_depth, far_depth)
+    {
+    }
+
+    void show(sl::Mat &depth, float distance, const std::string &unit, const MeasureOptions &options,
+              const std::vector<RoiStats> &zones)
+    {
+        TypedView<const float> view(depth);
+        int width = view.width();
+        int height = view.height();
+        float scale = std::min(1.f, std::min((float)DISPLAY_WIDTH / width, (float)DISPLAY_HEIGHT / height));
+        int cols = std::max(1, (int)(width * scale));
+        int rows = std::max(1, (int)(height * scale));
+        if (canvas.rows != rows || canvas.cols != cols)
+            canvas.create(rows, cols, CV_8UC3);
+
+        colormap.render(view.data(), view.stride_bytes(), width, height, canvas.data, canvas.step, cols, rows);
+
+        // The measurement box is given in depth pixels
+        cv::Rect box = measurement_box(width, height, options.box_width, options.box_height);
+        cv::rectangle(canvas,
+                      cv::Rect((int)(box.x * scale), (int)(box.y * scale), (int)(box.width * scale),
+                               (int)(box.height * scale)),
+                      cv::Scalar(0, 0, 255), 2);
+        draw_zones(canvas, options, zones);
+
+        std::stringstream stream;
+        stream << std::fixed << std::setprecision(2) << distance;
+        std::string message = "Distance: " + stream.str() + " " + unit;
+        cv::putText(canvas, message, cv::Point(20, 40), cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(255, 255, 255), 2);
+
+        if (!window_created)
+        {
+            cv::namedWindow("Depth Map", cv::WINDOW_AUTOSIZE);
+            window_created = true;
+        }
+        cv::imshow("Depth Map", canvas);
+        cv::waitKey(1);
+    }
+
+private:
+    DepthColormap colormap;
+    cv::Mat canvas;
+    bool window_created = false;
+};
+
 #endif
\ No newline at end of file
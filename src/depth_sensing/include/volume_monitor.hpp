@@ -0,0 +1,141 @@
+#ifndef __DEPTH_VOLUME_MONITOR__
+#define __DEPTH_VOLUME_MONITOR__
+
+#include <frame_source.hpp>
+#include <occupancy_map.hpp>
+#include <calibration.hpp>
+#include <latency_histogram.hpp>
+#include <telemetry.hpp>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct VolumeState
+{
+    bool occupied = false;
+    uint32_t voxels = 0;
+    uint64_t occupied_frames = 0;
+    uint64_t entries = 0;
+};
+
+// Fuses every depth frame into an OccupancyMap and checks the watched volumes against
+// it, printing a line whenever one becomes occupied or clear. It runs on the grab
+// thread right after the depth is retrieved, so it sees every frame in order and an
+// SVO replay gives the same result as the live run.
+class VolumeMonitor
+{
+public:
+    VolumeMonitor(const std::vector<Volume> &volumes, float voxel_m, const std::string &calibration, sl::UNIT unit,
+                  std::ostream &events)
+        : volumes(volumes), states(volumes.size()), map(voxel_m * meters_to_unit(unit)), calibration(calibration),
+          unit_scale(meters_to_unit(unit)), events(events)
+    {
+        for (const Volume &volume : volumes)
+            boxes.push_back(volume.to_box(unit_scale));
+    }
+
+    void update(FrameSource *source, sl::Mat &depth, uint64_t frame_id)
+    {
+        if (error != sl::ERROR_CODE::SUCCESS)
+            return;
+
+        TypedView<const float> view(depth);
+        if (!intrinsics.is_valid() && !resolve_intrinsics(source, view.width(), view.height()))
+            return;
+
+        uint64_t start = steady_now_ns();
+        map.integrate(view.data(), view.stride_bytes(), view.width(), view.height(), intrinsics);
+        update_latency.record(steady_now_ns() - start);
+        frames++;
+
+        for (size_t i = 0; i < volumes.size(); ++i)
+        {
+            start = steady_now_ns();
+            uint32_t voxels = map.count_occupied(boxes[i]);
+            query_latency.record(steady_now_ns() - start);
+
+            VolumeState &state = states[i];
+            bool occupied = voxels >= volumes[i].min_voxels;
+            if (occupied != state.occupied)
+            {
+                events << std::endl
+                       << "Volume " << volumes[i].name << (occupied ? " occupied" : " clear") << " at frame "
+                       << frame_id << " (" << voxels << " voxels)" << std::endl;
+                if (occupied)
+                    state.entries++;
+            }
+            state.occupied = occupied;
+            state.voxels = voxels;
+            if (occupied)
+                state.occupied_frames++;
+        }
+    }
+
+    void report(std::ostream &out)
+    {
+        std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(3) << "Occupancy map: " << map.get_voxel_size() / unit_scale
+            << " m voxels, " << frames << " frames fused";
+        if (error != sl::ERROR_CODE::SUCCESS)
+        {
+            out << ", stopped: " << error << std::endl;
+            if (calibration.empty())
+                out << "  the source has no intrinsics, pass the camera calibration file with -c" << std::endl;
+            out << std::defaultfloat << std::setprecision(precision);
+            return;
+        }
+        out << ", " << map.get_block_count() << "/" << map.get_max_blocks() << " blocks, " << map.get_evicted()
+            << " evicted, " << map.get_dropped_points() << " points dropped" << std::endl;
+        if (frames > 0)
+        {
+            out << std::setprecision(2) << "  update p50 " << update_latency.percentile(0.5) / 1e6 << " ms, p99 "
+                << update_latency.percentile(0.99) / 1e6 << " ms; query p50 " << query_latency.percentile(0.5) / 1e3
+                << " us, p99 " << query_latency.percentile(0.99) / 1e3 << " us, max " << query_latency.get_max() / 1e3
+                << " us" << std::endl;
+        }
+        for (size_t i = 0; i < volumes.size(); ++i)
+        {
+            out << "  " << volumes[i].name << ": occupied in " << states[i].occupied_frames << " of " << frames
+                << " frames, entered " << states[i].entries << " times, now "
+                << (states[i].occupied ? "occupied" : "clear") << std::endl;
+        }
+        out << std::defaultfloat << std::setprecision(precision);
+    }
+
+private:
+    std::vector<Volume> volumes;
+    std::vector<OccupancyBox> boxes;
+    std::vector<VolumeState> states;
+    OccupancyMap map;
+    std::string calibration;
+    float unit_scale;
+    std::ostream &events;
+    CameraIntrinsics intrinsics;
+    sl::ERROR_CODE error = sl::ERROR_CODE::SUCCESS;
+    uint64_t frames = 0;
+    LatencyHistogram update_latency;
+    LatencyHistogram query_latency;
+
+    // From the calibration file when given, from the source otherwise. A failure stops
+    // the monitor, the pipeline keeps running and the report tells why.
+    bool resolve_intrinsics(FrameSource *source, int width, int height)
+    {
+        if (calibration.empty())
+        {
+            error = source->get_intrinsics(intrinsics);
+            return error == sl::ERROR_CODE::SUCCESS;
+        }
+        try
+        {
+            intrinsics = load_calibration(calibration, width, height);
+        }
+        catch (const sl::ERROR_CODE &err)
+        {
+            error = err;
+        }
+        return error == sl::ERROR_CODE::SUCCESS;
+    }
+};
+
+#endif
@@ -1,13 +1,12 @@
 #include "arg_dparser.hpp"
 #include "utils.hpp"
+#include "pipeline.hpp"
 #include <thread>
 #include <chrono>
 
-bool exit_app = false;
+std::atomic<bool> exit_app{false};
 void poll_exit();
-void show_distance(bool with_gui, std::string shorthand);
-
-float distance;
+void show_distance(bool with_gui, std::string shorthand, const TelemetryBus *bus);
 
 int main(int argc, char *argv[])
 {
@@ -26,8 +25,27 @@ int main(int argc, char *argv[])
     std::string depth_mode_s = parser.get_depth_mode();
     std::string sensing_mode_s = parser.get_sensing_mode();
     std::string m_unit_s = parser.get_measurement_unit();
+    std::string source_s = parser.get_source();
+    std::string input_s = parser.get_input_file();
 
     bool with_gui = parser.get_gui_option();
+    int workers = parser.get_workers();
+    int box_size = parser.get_box_size();
+    std::string roi_file = parser.get_roi_file();
+    std::string statistic_s = parser.get_statistic();
+    std::string volume_file = parser.get_volume_file();
+    float voxel_m = parser.get_voxel_size();
+    std::string calibration_file = parser.get_calibration_file();
+    float near_m = parser.get_near_depth();
+    float far_m = parser.get_far_depth();
+    std::string log_file = parser.get_log_file();
+    std::string log_format_s = parser.get_log_format();
+    int log_rotation_mb = parser.get_log_rotation();
+
+    MeasureOptions options;
+    options.box_width = box_size;
+    options.box_height = box_size;
+    options.quantile = string2quantile(statistic_s);
     sl::UNIT m_unit = string2unit(m_unit_s);
     sl::SENSING_MODE sensing_mode = string2sensing(sensing_mode_s);
     sl::DEPTH_MODE depth_mode = string2depth(depth_mode_s);
@@ -36,15 +54,65 @@ int main(int argc, char *argv[])
     std::cout << "Measurement unit: " << m_unit_s << std::endl;
     std::cout << "Sensing mode: " << sensing_mode_s << std::endl;
     std::cout << "Depth mode: " << depth_mode_s << std::endl;
-    std::cout << "GUI Enable: " << with_gui << std::endl << std::endl;
+    std::cout << "Source: " << source_s << " " << input_s << std::endl;
+    std::cout << "Compute workers: " << workers << std::endl;
+    std::cout << "Measurement box: " << (box_size > 0 ? std::to_string(box_size) : std::string("full")) << std::endl;
+    std::cout << "Statistic: " << statistic_s << std::endl;
+    std::cout << "GUI Enable: " << with_gui << std::endl;
+    if (with_gui)
+        std::cout << "Colormap range: " << near_m << " - " << far_m << " m" << std::endl;
+    if (!log_file.empty())
+        std::cout << "Distance log: " << log_file << " (" << log_format_s << ", "
+                  << (log_rotation_mb > 0 ? std::to_string(log_rotation_mb) + " MB files" : std::string("no rotation"))
+                  << ")" << std::endl;
+    std::cout << std::endl;
+
+    if (far_m <= near_m)
+    {
+        std::cerr << "Could not parse arguments: -far must be above -near" << std::endl;
+        return 1;
+    }
+
+    if (!roi_file.empty())
+    {
+        try
+        {
+            options.rois = load_roi_file(roi_file);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            std::cerr << "Could not load ROIs: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Zones: " << options.rois.size() << " from " << roi_file << std::endl;
+        if (options.rois.size() > TELEMETRY_MAX_ZONES)
+            std::cout << "  zones past the first " << TELEMETRY_MAX_ZONES
+                      << " are not on the telemetry bus, the distance log keeps all of them" << std::endl;
+    }
+
+    std::vector<Volume> volumes;
+    if (!volume_file.empty())
+    {
+        try
+        {
+            volumes = load_volume_file(volume_file);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            std::cerr << "Could not load volumes: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Volumes: " << volumes.size() << " from " << volume_file << ", " << voxel_m << " m voxels"
+                  << std::endl;
+    }
 
     std::cout << "Initializing resources..." << std::endl;
 
-    std::unique_ptr<sl::Camera> zed_camera;
+    std::unique_ptr<FrameSource> source;
 
     try
     {
-        zed_camera = get_camera(depth_mode, m_unit);
+        source = get_frame_source(source_s, input_s, depth_mode, m_unit);
     }
     catch (const sl::ERROR_CODE &err)
     {
@@ -56,27 +124,59 @@ int main(int argc, char *argv[])
 
     sl::RuntimeParameters rt_params;
     rt_params.sensing_mode = sensing_mode;
-    sl::Mat depth_map, view;
+
+    TelemetryBus bus;
+    std::unique_ptr<VolumeMonitor> monitor;
+    if (!volume_file.empty())
+        monitor.reset(new VolumeMonitor(volumes, voxel_m, calibration_file, m_unit, std::cout));
+    std::unique_ptr<DistanceLogger> logger;
+    if (!log_file.empty())
+    {
+        DistanceLogFormat log_format = log_format_s.compare("bin") == 0 ? DistanceLogFormat::BINARY
+                                                                        : DistanceLogFormat::CSV;
+        // "[mm]" -> "mm"
+        logger.reset(new DistanceLogger(log_file, log_format, (uint64_t)log_rotation_mb << 20, workers, options.rois,
+                                        unit_sh.substr(1, unit_sh.size() - 2)));
+        if (!logger->start())
+        {
+            std::cerr << "Could not open the distance log " << log_file << std::endl;
+            return 1;
+        }
+    }
+    DepthDisplay display(near_m * meters_to_unit(m_unit), far_m * meters_to_unit(m_unit));
+    DepthPipeline pipeline(source.get(), rt_params, workers, with_gui, options, bus, display, monitor.get(),
+                           logger.get());
 
     std::thread poll(poll_exit);
-    std::thread distance_viewer(show_distance, with_gui, m_unit_s);
+    std::thread distance_viewer(show_distance, with_gui, m_unit_s, &bus);
 
+    pipeline.start();
     while (exit_app == false)
     {
-        if (zed_camera->grab(rt_params) == sl::ERROR_CODE::SUCCESS)
+        if (pipeline.end_of_input())
         {
-            zed_camera->retrieveMeasure(depth_map, sl::MEASURE::DEPTH);
-            distance = compute_distance(depth_map);
-
-            if (with_gui)
-            {
-                zed_camera->retrieveImage(view, sl::VIEW::DEPTH);
-                display_depth_map(view, distance, unit_sh);
-            }
+            std::cout << std::endl << "End of input reached." << std::endl;
+            exit_app = true;
+            break;
         }
+
+        bool shown = with_gui && pipeline.display_step(unit_sh);
+        if (!shown)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pipeline.stop();
+    pipeline.report(std::cout);
+    if (logger)
+    {
+        logger->stop();
+        logger->report(std::cout, pipeline.get_compute_dropped());
     }
 
-    poll.join();
+    // poll_exit is still blocked on stdin when the input runs out
+    if (pipeline.end_of_input())
+        poll.detach();
+    else
+        poll.join();
     distance_viewer.join();
 }
 
@@ -102,15 +202,21 @@ void poll_exit()
     exit_app = true;
 }
 
-void show_distance(bool with_gui, std::string unit)
+void show_distance(bool with_gui, std::string unit, const TelemetryBus *bus)
 {
     std::string shorthand = unit_shorthand(unit);
+    DepthTelemetry telemetry;
     while (exit_app == false && !with_gui)
     {
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (!bus->read(telemetry))
+            continue;
+
         std::cout << '\r'
-                  << "Distance " << shorthand << ": " << std::setw(5) << distance << 
-                  " -> (Q to exit): " << std::flush;
+                  << "Distance " << shorthand << ": " << std::setw(5) << telemetry.distance
+                  << " [frame " << telemetry.frame_id << ", "
+                  << std::fixed << std::setprecision(1) << telemetry.latency_ns / 1e6 << " ms]" << std::defaultfloat
+                  << " -> (Q to exit): " << std::flush;
     }
     std::cout << std::endl;
 }
\ No newline at end of file
@@ -8,7 +8,10 @@
 #include <memory>
 #include <string>
 
+using ArgBoolMap = std::map<std::string, bool>;
 using ArgStringMap = std::map<std::string, std::string>;
+using ValidSource = std::vector<std::string>;
+using ValidUnit = std::vector<std::string>;
 
 class ArgParser
 {
@@ -16,7 +19,33 @@ class ArgParser
 public:
     ArgParser()
     {
+        bool_map.insert(std::make_pair(std::string("-max-speed"), false));
+        bool_map.insert(std::make_pair(std::string("-bench-codec"), false));
+
         string_map.insert(std::make_pair(std::string("-f"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-src"), std::string("svo")));
+        string_map.insert(std::make_pair(std::string("-seek-frame"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-seek-time"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-speed"), std::string("1")));
+        string_map.insert(std::make_pair(std::string("-export-depth"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-depth-codec"), std::string("mm16")));
+        string_map.insert(std::make_pair(std::string("-depth-error"), std::string("0")));
+        string_map.insert(std::make_pair(std::string("-unit"), std::string("milli")));
+        string_map.insert(std::make_pair(std::string("-export-ply"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-voxel"), std::string("0")));
+        string_map.insert(std::make_pair(std::string("-calib"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-split"), std::string("1")));
+
+        valid_source.push_back("svo");
+        valid_source.push_back("raw");
+        valid_source.push_back("synthetic");
+        valid_source.push_back("archive");
+
+        valid_unit.push_back("milli");
+        valid_unit.push_back("centi");
+        valid_unit.push_back("meter");
+        valid_unit.push_back("inch");
+        valid_unit.push_back("foot");
     }
 
     void parse(int argc, char *argv[])
@@ -44,7 +73,11 @@ public:
                 }
                 else
                 {
-                    if (string_map.find(arg) != string_map.end())
+                    if (bool_map.find(arg) != bool_map.end())
+                    {
+                        bool_map.at(arg) = true;
+                    }
+                    else if (string_map.find(arg) != string_map.end())
                     {
                         kw_flag = true;
                         key = &arg;
@@ -58,10 +91,16 @@ public:
             }
             if (kw_flag == true)
                 bad_keyword(args.back(), "");
+            if (!string_map.at("-seek-frame").empty() && !string_map.at("-seek-time").empty())
+                throw std::invalid_argument("-seek-frame and -seek-time are exclusive");
         }
         else 
         {
-            throw std::invalid_argument("Usage -> playback -f <filename>");
+            throw std::invalid_argument("Usage -> playback -f <filename> [-src svo|raw|synthetic|archive] "
+                                        "[-seek-frame frame | -seek-time seconds] [-speed factor] [-max-speed] "
+                                        "[-export-depth archive.zdepth [-depth-codec f32|mm16] [-depth-error mm]] "
+                                        "[-export-ply prefix [-voxel meters] [-calib SN<serial>.conf]] [-split segments] "
+                                        "[-bench-codec] [-unit milli|centi|meter|inch|foot]");
         }
     }
 
@@ -69,9 +108,82 @@ public:
     {
         return string_map.at("-f");
     }
+    std::string get_source()
+    {
+        return string_map.at("-src");
+    }
+    // Playback rate relative to the recording, 0.5 is half speed
+    double get_speed()
+    {
+        return std::stod(string_map.at("-speed"));
+    }
+    // Decode benchmark: no pacing and no display
+    bool get_max_speed()
+    {
+        return bool_map.at("-max-speed");
+    }
+    // Depth archive written instead of playing, empty when not exporting
+    std::string get_export_depth()
+    {
+        return string_map.at("-export-depth");
+    }
+    // Archive record encoding, f32 or mm16
+    std::string get_depth_codec()
+    {
+        return string_map.at("-depth-codec");
+    }
+    // Largest depth error the MM16 codec may introduce, in millimetres
+    float get_depth_error()
+    {
+        return std::stof(string_map.at("-depth-error"));
+    }
+    // Point cloud files prefix, empty when not exporting
+    std::string get_export_ply()
+    {
+        return string_map.at("-export-ply");
+    }
+    // Voxel grid size of the exported clouds, 0 keeps every point
+    float get_voxel()
+    {
+        return std::stof(string_map.at("-voxel"));
+    }
+    // Factory calibration file used when the source has no intrinsics, e.g. raw dumps
+    std::string get_calib()
+    {
+        return string_map.at("-calib");
+    }
+    // Encodes and decodes the depth of the recording instead of playing it
+    bool get_bench_codec()
+    {
+        return bool_map.at("-bench-codec");
+    }
+    // Frame ranges of the recording exported in parallel, each on its own source
+    int get_segments()
+    {
+        return std::stoi(string_map.at("-split"));
+    }
+    std::string get_unit()
+    {
+        return string_map.at("-unit");
+    }
+    // Start frame, -1 when not given
+    int get_seek_frame()
+    {
+        const std::string &value = string_map.at("-seek-frame");
+        return value.empty() ? -1 : std::stoi(value);
+    }
+    // Start time in seconds from the first frame, -1 when not given
+    double get_seek_time()
+    {
+        const std::string &value = string_map.at("-seek-time");
+        return value.empty() ? -1.0 : std::stod(value);
+    }
 
 private:
+    ArgBoolMap bool_map;
     ArgStringMap string_map;
+    ValidSource valid_source;
+    ValidUnit valid_unit;
 
     bool check_keyword(const std::string &key, const std::string &value)
     {
@@ -80,9 +192,79 @@ private:
             if (value.compare("") != 0)
                 return true;
         }
+        else if (key.compare("-src") == 0)
+        {
+            if (std::find(valid_source.begin(), valid_source.end(), value) != valid_source.end())
+                return true;
+        }
+        else if (key.compare("-seek-frame") == 0)
+        {
+            if (is_number(value) && value.size() < 10)
+                return true;
+        }
+        else if (key.compare("-seek-time") == 0)
+        {
+            if (is_decimal(value) && value.size() < 12)
+                return true;
+        }
+        else if (key.compare("-export-depth") == 0)
+        {
+            if (value.compare("") != 0)
+                return true;
+        }
+        else if (key.compare("-export-ply") == 0 || key.compare("-calib") == 0)
+        {
+            if (value.compare("") != 0)
+                return true;
+        }
+        else if (key.compare("-split") == 0)
+        {
+            if (is_number(value) && value.size() < 4 && std::stoi(value) > 0)
+                return true;
+        }
+        else if (key.compare("-voxel") == 0)
+        {
+            if (is_decimal(value) && value.size() < 8 && std::stod(value) <= 10.0)
+                return true;
+        }
+        else if (key.compare("-depth-codec") == 0)
+        {
+            if (value.compare("f32") == 0 || value.compare("mm16") == 0)
+                return true;
+        }
+        else if (key.compare("-depth-error") == 0)
+        {
+            if (is_decimal(value) && value.size() < 8 && std::stod(value) <= 1000.0)
+                return true;
+        }
+        else if (key.compare("-unit") == 0)
+        {
+            if (std::find(valid_unit.begin(), valid_unit.end(), value) != valid_unit.end())
+                return true;
+        }
+        else if (key.compare("-speed") == 0)
+        {
+            if (is_decimal(value) && value.size() < 8 && std::stod(value) >= 0.05 && std::stod(value) <= 20.0)
+                return true;
+        }
         return false;
     }
 
+    bool is_number(const std::string &s)
+    {
+        return !s.empty() && std::find_if(s.begin(),
+                                          s.end(), [](unsigned char c)
+                                          { return !std::isdigit(c); }) == s.end();
+    }
+
+    bool is_decimal(const std::string &s)
+    {
+        size_t dot = s.find('.');
+        if (dot == std::string::npos)
+            return is_number(s);
+        return (dot == 0 || is_number(s.substr(0, dot))) && is_number(s.substr(dot + 1));
+    }
+
     void bad_keyword(const std::string &key, const std::string &value)
     {
         std::string message = "Invalid keyword value pair: (" + key + ", " + value + ").";
@@ -0,0 +1,200 @@
+#ifndef __PLAYBACK_CLOUD_EXPORTER__
+#define __PLAYBACK_CLOUD_EXPORTER__
+
+#include <frame_source.hpp>
+#include <point_cloud.hpp>
+#include <calibration.hpp>
+#include <segment_runner.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+// Binary little endian PLY with float x, y, z vertices
+static bool write_ply(const std::string &filename, const std::vector<Point3> &points)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    file << "ply\nformat binary_little_endian 1.0\nelement vertex " << points.size()
+         << "\nproperty float x\nproperty float y\nproperty float z\nend_header\n";
+    file.write(reinterpret_cast<const char *>(points.data()), points.size() * sizeof(Point3));
+    return file.good();
+}
+
+// <prefix>_<frame>.ply, frame numbers padded to six digits so files sort in order
+static std::string ply_filename(const std::string &prefix, int frame)
+{
+    char number[16];
+    std::snprintf(number, sizeof(number), "_%06d.ply", frame);
+    return prefix + number;
+}
+
+// Point cloud of one frame per process() call, voxel filtered when the generator has a
+// leaf size. The intrinsics come from `calibration`, a factory calibration file, when
+// given and from the source otherwise. Throws the error of a missing intrinsics or a
+// failed PLY write. Also the segment worker of export_point_clouds_split, every frame
+// goes to its own file so segments need no merge beyond the statistics.
+struct CloudExportWorker
+{
+    std::string calibration;
+    std::string prefix;
+    PointCloudGenerator generator;
+    CameraIntrinsics intrinsics;
+    sl::Mat depth;
+    uint64_t frames = 0, valid = 0, written = 0;
+    double generate_seconds = 0.0;
+    int width = 0, height = 0;
+
+    bool process(FrameSource &source, int frame, sl::ERROR_CODE err, uint64_t &points)
+    {
+        if (err != sl::ERROR_CODE::SUCCESS || source.retrieve_measure(depth, sl::MEASURE::DEPTH) != sl::ERROR_CODE::SUCCESS)
+            return false;
+
+        TypedView<const float> view(depth);
+        width = view.width();
+        height = view.height();
+        if (!intrinsics.is_valid())
+        {
+            if (!calibration.empty())
+                intrinsics = load_calibration(calibration, width, height);
+            else if ((err = source.get_intrinsics(intrinsics)) != sl::ERROR_CODE::SUCCESS)
+                throw err;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        valid += generator.generate(view.data(), view.stride_bytes(), width, height, intrinsics);
+        generate_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!write_ply(ply_filename(prefix, frame), generator.get_points()))
+            throw sl::ERROR_CODE::SVO_RECORDING_ERROR;
+        points = generator.get_points().size();
+        written += points;
+        frames++;
+        return true;
+    }
+
+    void merge(const CloudExportWorker &other)
+    {
+        frames += other.frames;
+        valid += other.valid;
+        written += other.written;
+        generate_seconds += other.generate_seconds;
+        if (other.frames > 0)
+        {
+            width = other.width;
+            height = other.height;
+        }
+    }
+};
+
+static CloudExportWorker make_cloud_worker(FrameSource *source, const std::string &calibration,
+                                           const std::string &prefix, float voxel_m)
+{
+    CloudExportWorker worker;
+    worker.calibration = calibration;
+    worker.prefix = prefix;
+    worker.generator.set_voxel_size(voxel_m * meters_to_unit(source->get_unit()));
+    return worker;
+}
+
+// Throughput only counts the cloud generation, not the grab or the file writes, and
+// is compared against the recording frame rate
+static void report_point_clouds(const CloudExportWorker &totals, float fps, float voxel_m, std::ostream &out)
+{
+    uint64_t frames = totals.frames;
+    double per_frame_ms = frames > 0 ? 1000.0 * totals.generate_seconds / frames : 0.0;
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2) << "Exported " << frames << " point clouds of " << totals.width << "x"
+        << totals.height << " to " << totals.prefix << "_*.ply: " << (frames > 0 ? totals.valid / frames : 0)
+        << " valid pixels and " << (frames > 0 ? totals.written / frames : 0) << " points per frame";
+    if (voxel_m > 0.f)
+        out << " after a " << voxel_m << " m voxel grid";
+    out << std::endl
+        << "  " << per_frame_ms << " ms per cloud on one core ("
+        << simd_level_name(totals.generator.get_level()) << "), "
+        << (per_frame_ms > 0.0 ? 1000.0 / per_frame_ms / fps : 0.0) << "x the " << fps << " fps camera rate"
+        << std::defaultfloat << std::setprecision(precision) << std::endl;
+}
+
+// Writes the point cloud of every frame from the current position to the end, voxel
+// filtered when voxel_m is above 0, see CloudExportWorker for the intrinsics
+static sl::ERROR_CODE export_point_clouds(FrameSource *source, const std::string &calibration,
+                                          const std::string &prefix, float voxel_m, std::ostream &out)
+{
+    CloudExportWorker worker = make_cloud_worker(source, calibration, prefix, voxel_m);
+    sl::RuntimeParameters rt_params;
+    uint64_t points = 0;
+
+    auto last_progress = std::chrono::steady_clock::now();
+    bool progress_shown = false;
+    try
+    {
+        while (true)
+        {
+            auto err = source->grab(rt_params);
+            if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+                break;
+            if (!worker.process(*source, source->get_position(), err, points))
+                continue;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_progress > std::chrono::milliseconds(500))
+            {
+                out << "\r  exported frame " << source->get_position() + 1 << std::flush;
+                last_progress = now;
+                progress_shown = true;
+            }
+        }
+    }
+    catch (const sl::ERROR_CODE &err)
+    {
+        if (progress_shown)
+            out << std::endl;
+        return err;
+    }
+
+    if (progress_shown)
+        out << std::endl;
+    report_point_clouds(worker, source->get_fps(), voxel_m, out);
+    return sl::ERROR_CODE::SUCCESS;
+}
+
+// export_point_clouds from frame `begin` to the end over `segments` sources opened with
+// `open`, each writing the files of its own frame range
+static sl::ERROR_CODE export_point_clouds_split(FrameSource *source,
+                                                const SegmentRunner<CloudExportWorker, uint64_t>::Opener &open,
+                                                int begin, int segments, const std::string &calibration,
+                                                const std::string &prefix, float voxel_m, std::ostream &out)
+{
+    CloudExportWorker prototype = make_cloud_worker(source, calibration, prefix, voxel_m);
+    sl::RuntimeParameters rt_params;
+    SegmentRunner<CloudExportWorker, uint64_t> runner(open, segments, prototype, rt_params);
+    try
+    {
+        runner.run(begin, source->get_frame_count(), &out);
+    }
+    catch (const sl::ERROR_CODE &err)
+    {
+        return err;
+    }
+    catch (const std::exception &e)
+    {
+        out << "Segment failed: " << e.what() << std::endl;
+        return sl::ERROR_CODE::FAILURE;
+    }
+
+    CloudExportWorker totals = prototype;
+    for (const CloudExportWorker &worker : runner.get_workers())
+        totals.merge(worker);
+    report_point_clouds(totals, source->get_fps(), voxel_m, out);
+    std::streamsize precision = out.precision();
+    out << "  " << runner.get_ranges().size() << " segments in " << std::fixed << std::setprecision(2)
+        << runner.get_seconds() << " s" << std::defaultfloat << std::setprecision(precision) << std::endl;
+    return sl::ERROR_CODE::SUCCESS;
+}
+
+#endif
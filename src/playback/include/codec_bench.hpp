@@ -0,0 +1,136 @@
+#ifndef __PLAYBACK_CODEC_BENCH__
+#define __PLAYBACK_CODEC_BENCH__
+
+#include <frame_source.hpp>
+#include <depth_codec.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+struct CodecBenchStats
+{
+    uint64_t frames = 0;
+    uint64_t pixels = 0;
+    uint64_t raw_bytes = 0;
+    uint64_t encoded_bytes = 0;
+    double encode_seconds = 0.0;
+    double scalar_seconds = 0.0;
+    double simd_seconds = 0.0;
+    double max_error_mm = 0.0;
+    // Pixels decoded outside the error bound or with another invalid marker
+    uint64_t out_of_bound = 0;
+    // Frames the SIMD decoder did not reproduce bit for bit, or failed to decode
+    uint64_t simd_mismatches = 0;
+    uint64_t failures = 0;
+};
+
+static void compare_decoded_depth(const float *original, size_t stride_bytes, const float *decoded, int width,
+                                  int height, float to_mm, float bound_mm, CodecBenchStats &stats)
+{
+    for (int row = 0; row < height; ++row)
+    {
+        const float *src = depth_row(original, stride_bytes, row);
+        const float *dst = decoded + (size_t)row * width;
+        for (int col = 0; col < width; ++col)
+        {
+            float a = src[col], b = dst[col];
+            if (std::isfinite(a) && std::isfinite(b))
+            {
+                double error = std::fabs((double)a - b) * to_mm;
+                stats.max_error_mm = std::max(stats.max_error_mm, error);
+                if (error > bound_mm * 1.0001 + 1e-3)
+                    stats.out_of_bound++;
+            }
+            else if (!(std::isnan(a) && std::isnan(b)) && a != b)
+                stats.out_of_bound++;
+        }
+    }
+}
+
+// Round trips the depth of every frame from the current position through the MM16
+// codec, timing the encoder and the scalar and best SIMD decoders on the same records.
+// Throughputs are in MB of F32 depth per second.
+static CodecBenchStats bench_depth_codec(FrameSource *source, float max_error_mm, std::ostream &out)
+{
+    using clock = std::chrono::steady_clock;
+    DepthEncoder encoder(max_error_mm);
+    DepthDecoder scalar(SimdLevel::SCALAR);
+    DepthDecoder simd;
+    sl::RuntimeParameters rt_params;
+    sl::Mat depth;
+    std::vector<float> reference, decoded;
+    float to_mm = 1000.f / meters_to_unit(source->get_unit());
+    float bound_mm = 0.5f * encoder.get_step_mm();
+    CodecBenchStats stats;
+    int width = 0, height = 0;
+
+    while (true)
+    {
+        auto err = source->grab(rt_params);
+        if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+            break;
+        if (err != sl::ERROR_CODE::SUCCESS || source->retrieve_measure(depth, sl::MEASURE::DEPTH) != sl::ERROR_CODE::SUCCESS)
+            continue;
+
+        TypedView<const float> view(depth);
+        width = view.width();
+        height = view.height();
+        const float *data = view.data();
+        size_t step = view.stride_bytes();
+        size_t row_bytes = (size_t)width * sizeof(float);
+        reference.resize((size_t)width * height);
+        decoded.resize((size_t)width * height);
+
+        auto t0 = clock::now();
+        const std::vector<uint8_t> &record = encoder.encode(data, step, width, height, to_mm);
+        auto t1 = clock::now();
+        bool scalar_ok = scalar.decode(record.data(), record.size(), reference.data(), row_bytes, width, height);
+        auto t2 = clock::now();
+        bool simd_ok = simd.decode(record.data(), record.size(), decoded.data(), row_bytes, width, height);
+        auto t3 = clock::now();
+
+        stats.frames++;
+        stats.pixels += (uint64_t)width * height;
+        stats.raw_bytes += (uint64_t)row_bytes * height;
+        stats.encoded_bytes += record.size();
+        stats.encode_seconds += std::chrono::duration<double>(t1 - t0).count();
+        stats.scalar_seconds += std::chrono::duration<double>(t2 - t1).count();
+        stats.simd_seconds += std::chrono::duration<double>(t3 - t2).count();
+        if (!scalar_ok)
+        {
+            stats.failures++;
+            continue;
+        }
+        if (!simd_ok || std::memcmp(reference.data(), decoded.data(), reference.size() * sizeof(float)) != 0)
+            stats.simd_mismatches++;
+        compare_decoded_depth(data, step, reference.data(), width, height, to_mm, bound_mm, stats);
+    }
+
+    double raw_mb = stats.raw_bytes / 1e6;
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1) << "Depth codec benchmark: " << stats.frames << " frames of " << width
+        << "x" << height << ", " << encoder.get_step_mm() << " mm steps (error bound " << bound_mm << " mm)"
+        << std::endl;
+    if (stats.frames > 0)
+    {
+        out << "  F32 " << raw_mb << " MB -> MM16 " << stats.encoded_bytes / 1e6 << " MB, ratio "
+            << std::setprecision(2) << (double)stats.raw_bytes / std::max<uint64_t>(stats.encoded_bytes, 1) << ":1, "
+            << 8.0 * stats.encoded_bytes / stats.pixels << " bits/pixel" << std::endl;
+        out << std::setprecision(1) << "  encode " << raw_mb / std::max(stats.encode_seconds, 1e-9)
+            << " MB/s, decode " << raw_mb / std::max(stats.scalar_seconds, 1e-9) << " MB/s scalar";
+        if (simd.get_level() != SimdLevel::SCALAR)
+            out << ", " << raw_mb / std::max(stats.simd_seconds, 1e-9) << " MB/s " << simd_level_name(simd.get_level())
+                << " (" << std::setprecision(2) << stats.scalar_seconds / std::max(stats.simd_seconds, 1e-9) << "x)";
+        out << std::endl;
+        out << std::setprecision(3) << "  max error " << stats.max_error_mm << " mm, " << stats.out_of_bound
+            << " pixels outside the bound, " << stats.simd_mismatches << " SIMD mismatches, " << stats.failures
+            << " failed decodes" << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(precision);
+    return stats;
+}
+
+#endif
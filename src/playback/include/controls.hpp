@@ -0,0 +1,73 @@
+#ifndef __PLAYBACK_CONTROLS__
+#define __PLAYBACK_CONTROLS__
+
+#include <seek_index.hpp>
+#include <latency_histogram.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#define SEEK_JUMP_SECONDS 5.0
+#define KEY_ESCAPE 27
+
+// Keyboard in the playback window:
+//   space pause / resume      a, d  previous / next frame (pauses)
+//   j, l  back / forward 5 s  0-9   jump to 0% - 90% of the recording
+//   q, Esc quit
+struct PlaybackState
+{
+    bool paused = false;
+    bool quit = false;
+    int pending_seek = -1;
+};
+
+static void handle_key(int key, int current, const SeekIndex &index, PlaybackState &state)
+{
+    int last = std::max(0, index.size() - 1);
+    switch (key)
+    {
+    case ' ':
+        state.paused = !state.paused;
+        break;
+    case 'a':
+        state.paused = true;
+        state.pending_seek = std::max(0, current - 1);
+        break;
+    case 'd':
+        state.paused = true;
+        state.pending_seek = std::min(last, current + 1);
+        break;
+    case 'j':
+        state.pending_seek = index.frame_at_time(index.time_of(current) - SEEK_JUMP_SECONDS);
+        break;
+    case 'l':
+        state.pending_seek = index.frame_at_time(index.time_of(current) + SEEK_JUMP_SECONDS);
+        break;
+    case 'q':
+    case KEY_ESCAPE:
+        state.quit = true;
+        break;
+    default:
+        if (key >= '0' && key <= '9')
+            state.pending_seek = index.frame_at_time(index.duration() * (key - '0') / 10.0);
+        break;
+    }
+}
+
+// Seek latency runs from set_position to the retrieved image of the target frame
+static void print_seek_summary(std::ostream &out, const LatencyHistogram &latency, float fps)
+{
+    if (latency.get_count() == 0)
+        return;
+
+    double period_ms = fps > 0.f ? 1e3 / fps : 0.0;
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2) << "Seek latency over " << latency.get_count() << " seeks: p50 "
+        << latency.percentile(0.5) / 1e6 << " ms, p99 " << latency.percentile(0.99) / 1e6 << " ms, max "
+        << latency.get_max() / 1e6 << " ms (frame period " << period_ms << " ms)" << std::defaultfloat
+        << std::setprecision(precision) << std::endl;
+    if (period_ms > 0.0 && latency.get_max() / 1e6 > period_ms)
+        out << "Warning: some seeks took longer than one frame period" << std::endl;
+}
+
+#endif
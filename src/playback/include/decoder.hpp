@@ -0,0 +1,190 @@
+#ifndef __PLAYBACK_DECODER__
+#define __PLAYBACK_DECODER__
+
+#include <sl/Camera.hpp>
+#include <frame_source.hpp>
+#include <object_pool.hpp>
+#include <spsc_queue.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#define DECODE_AHEAD_FRAMES 8
+
+struct DecodedFrame
+{
+    sl::Mat image;
+    int frame;
+    uint64_t timestamp_ns;
+    uint64_t generation;
+};
+
+// Grabs and converts frames on its own thread into pooled buffers, up to
+// DECODE_AHEAD_FRAMES ahead of the consumer, and waits when the consumer falls behind.
+// Once started, the source belongs to the decode thread: seeks are requested through
+// seek() and every frame carries the generation of the last request, so the consumer
+// can release frames decoded before it.
+class FrameDecoder
+{
+public:
+    FrameDecoder(FrameSource *source)
+        : source(source), pool(DECODE_AHEAD_FRAMES + 2), queue(DECODE_AHEAD_FRAMES)
+    {
+        rt_params.enable_depth = false;
+    }
+
+    ~FrameDecoder()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        running = true;
+        thread = std::thread(&FrameDecoder::decode_loop, this);
+    }
+
+    void stop()
+    {
+        running = false;
+        if (thread.joinable())
+            thread.join();
+
+        DecodedFrame *frame;
+        while (queue.pop(frame))
+            pool.release(frame);
+    }
+
+    // Returns the generation frames decoded from `position` on will carry
+    uint64_t seek(int position)
+    {
+        std::lock_guard<std::mutex> lock(seek_mutex);
+        seek_target = position;
+        return generation.fetch_add(1, std::memory_order_release) + 1;
+    }
+
+    // nullptr when no frame is ready, the frame goes back with release()
+    DecodedFrame *next()
+    {
+        DecodedFrame *frame;
+        return queue.pop(frame) ? frame : nullptr;
+    }
+
+    void release(DecodedFrame *frame)
+    {
+        pool.release(frame);
+    }
+
+    size_t ready()
+    {
+        return queue.depth();
+    }
+
+    uint64_t get_generation()
+    {
+        return generation.load(std::memory_order_acquire);
+    }
+
+    // The decode thread reached the end of the recording, no seek is pending and every
+    // frame was consumed
+    bool finished()
+    {
+        return end_reached.load(std::memory_order_acquire) &&
+               applied.load(std::memory_order_acquire) == generation.load(std::memory_order_acquire) &&
+               queue.depth() == 0;
+    }
+
+    uint64_t get_decoded()
+    {
+        return decoded.load(std::memory_order_relaxed);
+    }
+
+private:
+    FrameSource *source;
+    sl::RuntimeParameters rt_params;
+    ObjectPool<DecodedFrame> pool;
+    SpscQueue<DecodedFrame *> queue;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> end_reached{false};
+    std::mutex seek_mutex;
+    int seek_target = -1;
+    std::atomic<uint64_t> generation{0};
+    std::atomic<uint64_t> applied{0};
+    std::atomic<uint64_t> decoded{0};
+
+    static void wait(int &idle)
+    {
+        if (++idle < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    void apply_seek(uint64_t &current)
+    {
+        std::lock_guard<std::mutex> lock(seek_mutex);
+        current = generation.load(std::memory_order_acquire);
+        int target = seek_target;
+        seek_target = -1;
+        if (target >= 0)
+        {
+            source->set_position(target);
+            end_reached.store(false, std::memory_order_release);
+        }
+        applied.store(current, std::memory_order_release);
+    }
+
+    void decode_loop()
+    {
+        uint64_t current = 0;
+        int idle = 0;
+        DecodedFrame *frame = nullptr;
+
+        while (running)
+        {
+            if (generation.load(std::memory_order_acquire) != current)
+                apply_seek(current);
+
+            if (end_reached.load(std::memory_order_relaxed) ||
+                (frame == nullptr && (frame = pool.acquire()) == nullptr))
+            {
+                wait(idle);
+                continue;
+            }
+            idle = 0;
+
+            auto err = source->grab(rt_params);
+            if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+            {
+                end_reached.store(true, std::memory_order_release);
+                continue;
+            }
+            if (err != sl::ERROR_CODE::SUCCESS ||
+                source->retrieve_image(frame->image, sl::VIEW::SIDE_BY_SIDE) != sl::ERROR_CODE::SUCCESS)
+                continue;
+
+            frame->frame = source->get_position();
+            frame->timestamp_ns = source->get_timestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+            frame->generation = current;
+            decoded.fetch_add(1, std::memory_order_relaxed);
+
+            bool queued = false;
+            while (running && !(queued = queue.push(frame)))
+            {
+                // A seek makes the frame stale, its buffer is reused instead of waiting
+                if (generation.load(std::memory_order_acquire) != current)
+                    break;
+                wait(idle);
+            }
+            if (queued)
+                frame = nullptr;
+        }
+
+        if (frame != nullptr)
+            pool.release(frame);
+    }
+};
+
+#endif
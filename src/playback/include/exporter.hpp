@@ -0,0 +1,192 @@
+#ifndef __PLAYBACK_EXPORTER__
+#define __PLAYBACK_EXPORTER__
+
+#include <frame_source.hpp>
+#include <depth_archive.hpp>
+#include <segment_runner.hpp>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// Throughput counts the depth going in, so both codecs compare
+static void report_depth_export(const DepthArchiveWriter &writer, const std::string &filename, uint32_t codec,
+                                double seconds, uint64_t missing, std::ostream &out)
+{
+    double megabytes = writer.get_bytes_written() / 1e6;
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1) << "Exported " << writer.get_frames_written() << " depth frames ("
+        << megabytes << " MB) to " << filename << " in " << seconds << " s, "
+        << (seconds > 0.0 ? writer.get_raw_bytes() / 1e6 / seconds : 0.0) << " MB/s";
+    if (codec == DEPTH_CODEC_MM16 && writer.get_bytes_written() > 0)
+        out << ", " << std::setprecision(2) << (double)writer.get_raw_bytes() / writer.get_bytes_written()
+            << ":1 over F32";
+    if (missing > 0)
+        out << ", " << missing << " frames without depth";
+    out << std::defaultfloat << std::setprecision(precision) << std::endl;
+}
+
+// Writes the depth of every frame from the current position to the end into a depth
+// archive with records encoded as `codec`. Returns the first write error, which removes
+// the archive, frames whose depth cannot be retrieved are skipped and counted.
+static sl::ERROR_CODE export_depth(FrameSource *source, const std::string &filename, uint32_t codec,
+                                   float max_error_mm, std::ostream &out)
+{
+    DepthArchiveWriter writer(filename, source->get_fps(), source->get_unit(), codec, max_error_mm);
+    sl::RuntimeParameters rt_params;
+    sl::Mat depth;
+    int total = source->get_frame_count();
+    uint64_t missing = 0;
+    bool progress_shown = false;
+
+    auto start = std::chrono::steady_clock::now();
+    auto last_progress = start;
+    while (true)
+    {
+        auto err = source->grab(rt_params);
+        if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+            break;
+        if (err != sl::ERROR_CODE::SUCCESS || source->retrieve_measure(depth, sl::MEASURE::DEPTH) != sl::ERROR_CODE::SUCCESS)
+        {
+            missing++;
+            continue;
+        }
+
+        err = writer.write(source->get_timestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds(), depth);
+        if (err != sl::ERROR_CODE::SUCCESS)
+        {
+            writer.discard();
+            return err;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_progress > std::chrono::milliseconds(500))
+        {
+            out << "\r  exported frame " << source->get_position() + 1;
+            if (total > 0)
+                out << "/" << total;
+            out << std::flush;
+            last_progress = now;
+            progress_shown = true;
+        }
+    }
+    writer.close();
+
+    if (progress_shown)
+        out << std::endl;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report_depth_export(writer, filename, codec, seconds, missing, out);
+    return sl::ERROR_CODE::SUCCESS;
+}
+
+// Segment worker of export_depth_split, writes its frames to a part archive of its own,
+// <filename>.part<first frame>, created on the first frame with depth. The writer is
+// shared so the prototype stays copyable, each copy starts without one.
+struct DepthExportWorker
+{
+    std::string filename;
+    float fps = 0.f;
+    sl::UNIT unit = sl::UNIT::MILLIMETER;
+    uint32_t codec = DEPTH_CODEC_F32;
+    float max_error_mm = 0.f;
+    std::shared_ptr<DepthArchiveWriter> part;
+    std::string part_name;
+    sl::Mat depth;
+    uint64_t missing = 0;
+
+    bool process(FrameSource &source, int frame, sl::ERROR_CODE err, int &)
+    {
+        if (err != sl::ERROR_CODE::SUCCESS || source.retrieve_measure(depth, sl::MEASURE::DEPTH) != sl::ERROR_CODE::SUCCESS)
+        {
+            missing++;
+            return false;
+        }
+
+        if (!part)
+        {
+            part_name = filename + ".part" + std::to_string(frame);
+            part = std::make_shared<DepthArchiveWriter>(part_name, fps, unit, codec, max_error_mm);
+        }
+        err = part->write(source.get_timestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds(), depth);
+        if (err != sl::ERROR_CODE::SUCCESS)
+            throw err;
+        return false;
+    }
+};
+
+// export_depth from frame `begin` to the end over `segments` sources opened with
+// `open`. Each segment encodes into its part archive, the parts are then copied into
+// `filename` in segment order, so frames keep the order of the recording, and removed.
+// A failed segment or copy removes `filename` as well.
+static sl::ERROR_CODE export_depth_split(FrameSource *source,
+                                         const SegmentRunner<DepthExportWorker, int>::Opener &open, int begin,
+                                         int segments, const std::string &filename, uint32_t codec,
+                                         float max_error_mm, std::ostream &out)
+{
+    DepthExportWorker prototype;
+    prototype.filename = filename;
+    prototype.fps = source->get_fps();
+    prototype.unit = source->get_unit();
+    prototype.codec = codec;
+    prototype.max_error_mm = max_error_mm;
+    sl::RuntimeParameters rt_params;
+    SegmentRunner<DepthExportWorker, int> runner(open, segments, prototype, rt_params);
+
+    auto start = std::chrono::steady_clock::now();
+    sl::ERROR_CODE result = sl::ERROR_CODE::SUCCESS;
+    try
+    {
+        runner.run(begin, source->get_frame_count(), &out);
+    }
+    catch (const sl::ERROR_CODE &err)
+    {
+        result = err;
+    }
+    catch (const std::exception &e)
+    {
+        out << "Segment failed: " << e.what() << std::endl;
+        result = sl::ERROR_CODE::FAILURE;
+    }
+
+    DepthArchiveWriter writer(filename, prototype.fps, prototype.unit, codec, max_error_mm);
+    uint64_t missing = 0;
+    for (DepthExportWorker &worker : runner.get_workers())
+    {
+        missing += worker.missing;
+        if (!worker.part)
+            continue;
+
+        worker.part->close();
+        if (result == sl::ERROR_CODE::SUCCESS)
+        {
+            try
+            {
+                DepthArchiveReader part(worker.part_name);
+                result = writer.append(part);
+            }
+            catch (const sl::ERROR_CODE &err)
+            {
+                result = err;
+            }
+        }
+        std::remove(worker.part_name.c_str());
+    }
+    if (result != sl::ERROR_CODE::SUCCESS)
+    {
+        writer.discard();
+        return result;
+    }
+    writer.close();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report_depth_export(writer, filename, codec, seconds, missing, out);
+    std::streamsize precision = out.precision();
+    out << "  " << runner.get_ranges().size() << " segments, merged in frame order, encoding took " << std::fixed
+        << std::setprecision(2) << runner.get_seconds() << " s" << std::defaultfloat << std::setprecision(precision)
+        << std::endl;
+    return sl::ERROR_CODE::SUCCESS;
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef __PLAYBACK_PRESENTER__
+#define __PLAYBACK_PRESENTER__
+
+#include <decoder.hpp>
+#include <controls.hpp>
+#include <utils.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+struct PlaybackStats
+{
+    uint64_t presented = 0;
+    uint64_t skipped = 0;
+    double seconds = 0.0;
+};
+
+// Shows decoded frames at `speed` times the recorded rate. Frame due times follow the
+// recording timestamps from an anchor taken at start, after a seek and on resume. A
+// frame more than one period late is skipped when the next one is already decoded, so
+// a slow display catches up instead of drifting.
+static PlaybackStats play(FrameDecoder &decoder, const SeekIndex &index, PlaybackState &state, double speed,
+                          float fps, LatencyHistogram &seek_latency)
+{
+    using clock = std::chrono::steady_clock;
+    PlaybackStats stats;
+    auto period = std::chrono::nanoseconds(fps > 0.f ? (int64_t)(1e9 / fps / speed) : 0);
+
+    uint64_t wanted = decoder.get_generation();
+    bool seeking = false, anchored = false, shown = false;
+    clock::time_point seek_start, anchor_wall;
+    uint64_t anchor_ts = 0;
+    int current = 0;
+    auto start = clock::now();
+
+    while (!state.quit)
+    {
+        if (state.pending_seek >= 0)
+        {
+            seek_start = clock::now();
+            wanted = decoder.seek(state.pending_seek);
+            state.pending_seek = -1;
+            seeking = true;
+            anchored = false;
+        }
+
+        if (state.paused && shown && !seeking)
+        {
+            handle_key(cv::waitKey(30), current, index, state);
+            anchored = false;
+            continue;
+        }
+
+        DecodedFrame *frame = decoder.next();
+        if (frame == nullptr)
+        {
+            if (decoder.finished())
+                break;
+            handle_key(cv::waitKey(1), current, index, state);
+            continue;
+        }
+        if (frame->generation != wanted)
+        {
+            decoder.release(frame);
+            continue;
+        }
+
+        auto now = clock::now();
+        if (!anchored)
+        {
+            anchor_wall = now;
+            anchor_ts = frame->timestamp_ns;
+            anchored = true;
+        }
+        int64_t offset_ns = (int64_t)(frame->timestamp_ns - anchor_ts);
+        auto due = anchor_wall + std::chrono::nanoseconds((int64_t)(offset_ns / speed));
+
+        if (!seeking && now > due + period && decoder.ready() > 0)
+        {
+            stats.skipped++;
+            decoder.release(frame);
+            continue;
+        }
+
+        while (now < due && !state.quit && state.pending_seek < 0 && !state.paused)
+        {
+            int wait_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count();
+            handle_key(cv::waitKey(std::max(1, wait_ms)), current, index, state);
+            now = clock::now();
+        }
+        if (state.quit || state.pending_seek >= 0)
+        {
+            decoder.release(frame);
+            continue;
+        }
+
+        current = frame->frame;
+        cv::Mat view = to_cv_mat(TypedView<sl::uchar4>(frame->image));
+        cv::imshow("Record", view);
+        decoder.release(frame);
+        shown = true;
+        stats.presented++;
+
+        if (seeking)
+        {
+            auto latency = clock::now() - seek_start;
+            seek_latency.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+            std::cout << "Seek to frame " << current << " (" << index.time_of(current) << " s) in "
+                      << std::chrono::duration<double, std::milli>(latency).count() << " ms" << std::endl;
+            seeking = false;
+        }
+        handle_key(cv::waitKey(1), current, index, state);
+    }
+
+    stats.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return stats;
+}
+
+// Drains the decoder without pacing or display and reports the decode throughput
+static void run_max_speed(FrameDecoder &decoder, float fps, std::ostream &out)
+{
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    auto last_report = start;
+    uint64_t frames = 0;
+    bool progress_shown = false;
+
+    while (!decoder.finished())
+    {
+        DecodedFrame *frame = decoder.next();
+        if (frame == nullptr)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        decoder.release(frame);
+        frames++;
+
+        auto now = clock::now();
+        if (now - last_report > std::chrono::seconds(1))
+        {
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            std::streamsize precision = out.precision();
+            out << "\r  decoded " << frames << " frames, " << std::fixed << std::setprecision(1) << frames / elapsed
+                << " frames/s" << std::defaultfloat << std::setprecision(precision) << std::flush;
+            last_report = now;
+            progress_shown = true;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(clock::now() - start).count();
+    double rate = seconds > 0.0 ? frames / seconds : 0.0;
+    if (progress_shown)
+        out << std::endl;
+    out << "Decoded " << frames << " frames in " << seconds << " s (" << rate << " frames/s";
+    if (fps > 0.f)
+        out << ", " << rate / fps << "x real time";
+    out << ")" << std::endl;
+}
+
+#endif
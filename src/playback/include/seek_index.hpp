@@ -0,0 +1,220 @@
+#ifndef __PLAYBACK_SEEK_INDEX__
+#define __PLAYBACK_SEEK_INDEX__
+
+#include <sl/Camera.hpp>
+#include <frame_source.hpp>
+#include <raw_frame.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// Index layout: a SeekIndexHeader followed by one SeekIndexEntry per frame. The header
+// keeps the size and modification time of the recording, a cached index that no longer
+// matches them is rebuilt. Raw dumps store a record offset per frame and every frame is
+// a keyframe; the SDK does not expose the SVO container layout, so SVO entries only
+// carry timestamps and the SDK decodes from its own keyframe on set_position.
+#define SEEK_INDEX_MAGIC "ZEDIDX01"
+#define SEEK_INDEX_VERSION 1
+#define SEEK_INDEX_KEYFRAME 0x1
+#define SEEK_INDEX_HAS_OFFSET 0x2
+
+struct SeekIndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_bytes;
+    uint64_t source_bytes;
+    int64_t source_mtime;
+    uint32_t frames;
+    float fps;
+};
+
+struct SeekIndexEntry
+{
+    uint64_t timestamp_ns;
+    uint64_t offset;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+class SeekIndex
+{
+public:
+    // Loads the cached index next to `filename` or builds it by scanning `source`, which
+    // is rewound to its first frame afterwards. Sources without a file on disk (the
+    // synthetic generator) are indexed in memory only, unbounded ones not at all.
+    void open(FrameSource *source, const std::string &filename, std::ostream *progress = nullptr)
+    {
+        struct stat info;
+        bool on_disk = stat(filename.c_str(), &info) == 0;
+        uint64_t bytes = on_disk ? (uint64_t)info.st_size : 0;
+        int64_t mtime = on_disk ? (int64_t)info.st_mtime : 0;
+        path = filename + ".idx";
+
+        if (on_disk && load(bytes, mtime, source->get_frame_count()))
+        {
+            loaded = true;
+            return;
+        }
+
+        build(source, filename, progress);
+        if (on_disk)
+            save(bytes, mtime, source->get_fps());
+    }
+
+    // Frame whose timestamp is closest to `seconds` after the first frame
+    int frame_at_time(double seconds) const
+    {
+        if (entries.empty())
+            return 0;
+
+        uint64_t target = entries.front().timestamp_ns + (uint64_t)std::max(0.0, seconds * 1e9);
+        auto it = std::lower_bound(entries.begin(), entries.end(), target,
+                                   [](const SeekIndexEntry &entry, uint64_t value)
+                                   { return entry.timestamp_ns < value; });
+        if (it == entries.end())
+            return (int)entries.size() - 1;
+        if (it != entries.begin() && target - (it - 1)->timestamp_ns < it->timestamp_ns - target)
+            --it;
+        return (int)(it - entries.begin());
+    }
+
+    // Seconds from the first frame to `frame`
+    double time_of(int frame) const
+    {
+        if (entries.empty())
+            return 0.0;
+        frame = std::max(0, std::min(frame, (int)entries.size() - 1));
+        return (entries[frame].timestamp_ns - entries.front().timestamp_ns) / 1e9;
+    }
+
+    int size() const
+    {
+        return (int)entries.size();
+    }
+
+    double duration() const
+    {
+        return time_of(size() - 1);
+    }
+
+    const SeekIndexEntry &at(int frame) const
+    {
+        return entries.at(frame);
+    }
+
+    bool was_loaded() const
+    {
+        return loaded;
+    }
+
+    const std::string &get_path() const
+    {
+        return path;
+    }
+
+private:
+    std::vector<SeekIndexEntry> entries;
+    std::string path;
+    bool loaded = false;
+
+    bool load(uint64_t bytes, int64_t mtime, int frames)
+    {
+        std::ifstream file(path, std::ios::binary);
+        SeekIndexHeader header;
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, SEEK_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SEEK_INDEX_VERSION || header.entry_bytes != sizeof(SeekIndexEntry) ||
+            header.source_bytes != bytes || header.source_mtime != mtime ||
+            (frames >= 0 && (int)header.frames != frames))
+            return false;
+
+        entries.resize(header.frames);
+        if (!file.read(reinterpret_cast<char *>(entries.data()), header.frames * sizeof(SeekIndexEntry)))
+        {
+            entries.clear();
+            return false;
+        }
+        return true;
+    }
+
+    void save(uint64_t bytes, int64_t mtime, float fps)
+    {
+        SeekIndexHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, SEEK_INDEX_MAGIC, sizeof(header.magic));
+        header.version = SEEK_INDEX_VERSION;
+        header.entry_bytes = sizeof(SeekIndexEntry);
+        header.source_bytes = bytes;
+        header.source_mtime = mtime;
+        header.frames = (uint32_t)entries.size();
+        header.fps = fps;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(SeekIndexEntry));
+        if (!file.good())
+            std::cerr << "Could not write seek index " << path << std::endl;
+    }
+
+    // Header only pass: no image is retrieved and depth is not computed
+    void build(FrameSource *source, const std::string &filename, std::ostream *progress)
+    {
+        RawFileHeader raw_header;
+        bool raw = false;
+        std::ifstream raw_file(filename, std::ios::binary);
+        if (raw_file.read(reinterpret_cast<char *>(&raw_header), sizeof(raw_header)) &&
+            std::memcmp(raw_header.magic, RAW_MAGIC, sizeof(raw_header.magic)) == 0)
+            raw = true;
+
+        entries.clear();
+        int total = source->get_frame_count();
+        if (total <= 0)
+            return;
+        entries.reserve(total);
+
+        sl::RuntimeParameters rt_params;
+        rt_params.enable_depth = false;
+
+        auto last_progress = std::chrono::steady_clock::now();
+        source->set_position(0);
+        while ((int)entries.size() < total)
+        {
+            auto err = source->grab(rt_params);
+            if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+                break;
+
+            SeekIndexEntry entry;
+            std::memset(&entry, 0, sizeof(entry));
+            if (err == sl::ERROR_CODE::SUCCESS)
+                entry.timestamp_ns = source->get_timestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+            // Failed frames keep the slot so entry i stays frame i, at the previous timestamp
+            else if (!entries.empty())
+                entry.timestamp_ns = entries.back().timestamp_ns;
+            if (raw)
+            {
+                entry.offset = sizeof(RawFileHeader) + (uint64_t)entries.size() * raw_record_bytes(raw_header);
+                entry.flags = SEEK_INDEX_KEYFRAME | SEEK_INDEX_HAS_OFFSET;
+            }
+            entries.push_back(entry);
+
+            auto now = std::chrono::steady_clock::now();
+            if (progress != nullptr && now - last_progress > std::chrono::milliseconds(500))
+            {
+                *progress << "\r  indexing frame " << entries.size() << "/" << total << std::flush;
+                last_progress = now;
+            }
+        }
+        if (progress != nullptr)
+            *progress << "\r  indexed " << entries.size() << " frames" << std::endl;
+        source->set_position(0);
+    }
+};
+
+#endif
@@ -2,67 +2,25 @@
 #define __VID_UTILS__
 
 #include <sl/Camera.hpp>
+#include <sources.hpp>
+#include <depth_archive.hpp>
+#include <cv_view.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 
-static std::unique_ptr<sl::Camera> open_svo_file(const std::string& filename)
-{
-    sl::String input_path(filename.c_str());
-    sl::InitParameters params;
-    params.input.setFromSVOFile(input_path);
-    
-    auto zed_camera = std::make_unique<sl::Camera>();
-    auto err = zed_camera->open(params);
-
-    if (err != sl::ERROR_CODE::SUCCESS)
-    {
-        throw err;
-    }
-
-    return zed_camera;
-}
+// Recordings can be replayed from an SVO, a raw frame dump or the synthetic
+// generator, which then produces a clip of SYNTHETIC_CLIP_FRAMES frames.
+#define SYNTHETIC_CLIP_FRAMES 900
 
-// Mapping between MAT_TYPE and CV_TYPE
-static int getOCVtype(sl::MAT_TYPE type)
+// Depth is only computed when it is going to be exported or benchmarked
+static std::unique_ptr<FrameSource> open_recording(const std::string &source, const std::string &filename,
+                                                   bool with_depth = false, sl::UNIT unit = sl::UNIT::MILLIMETER)
 {
-    int cv_type = -1;
-    switch (type)
-    {
-    case sl::MAT_TYPE::F32_C1:
-        cv_type = CV_32FC1;
-        break;
-    case sl::MAT_TYPE::F32_C2:
-        cv_type = CV_32FC2;
-        break;
-    case sl::MAT_TYPE::F32_C3:
-        cv_type = CV_32FC3;
-        break;
-    case sl::MAT_TYPE::F32_C4:
-        cv_type = CV_32FC4;
-        break;
-    case sl::MAT_TYPE::U8_C1:
-        cv_type = CV_8UC1;
-        break;
-    case sl::MAT_TYPE::U8_C2:
-        cv_type = CV_8UC2;
-        break;
-    case sl::MAT_TYPE::U8_C3:
-        cv_type = CV_8UC3;
-        break;
-    case sl::MAT_TYPE::U8_C4:
-        cv_type = CV_8UC4;
-        break;
-    default:
-        break;
-    }
-    return cv_type;
-}
-
-static cv::Mat slMat2cvMat(sl::Mat &input)
-{
-    // Since cv::Mat data requires a uchar* pointer, we get the uchar1 pointer from sl::Mat (getPtr<T>())
-    // cv::Mat and sl::Mat will share a single memory structure
-    return cv::Mat(input.getHeight(), input.getWidth(), getOCVtype(input.getDataType()), input.getPtr<sl::uchar1>(sl::MEM::CPU), input.getStepBytes(sl::MEM::CPU));
+    sl::InitParameters params;
+    params.coordinate_units = unit;
+    if (!with_depth)
+        params.depth_mode = sl::DEPTH_MODE::NONE;
+    return open_frame_source(source, filename, params, SYNTHETIC_CLIP_FRAMES);
 }
 
-#endif
\ No newline at end of file
+#endif
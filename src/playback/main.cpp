@@ -1,6 +1,11 @@
 #include <iostream>
 #include <utils.hpp>
 #include <arg_pparser.hpp>
+#include <controls.hpp>
+#include <presenter.hpp>
+#include <exporter.hpp>
+#include <codec_bench.hpp>
+#include <cloud_exporter.hpp>
 
 int main(int argc, char *argv[])
 {
@@ -17,11 +22,17 @@ int main(int argc, char *argv[])
     }
 
     std::string filename = parser.get_filename();
-    std::unique_ptr<sl::Camera> zed_camera;
+    std::string source_s = parser.get_source();
+    std::string export_filename = parser.get_export_depth();
+    std::string ply_prefix = parser.get_export_ply();
+    sl::UNIT unit = string2unit(parser.get_unit());
+    int segments = parser.get_segments();
+    std::unique_ptr<FrameSource> source;
 
     try
     {
-        zed_camera = open_svo_file(filename);
+        bool with_depth = !export_filename.empty() || !ply_prefix.empty() || parser.get_bench_codec();
+        source = open_recording(source_s, filename, with_depth, unit);
     }
     catch (const sl::ERROR_CODE &err)
     {
@@ -29,21 +40,107 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    sl::Mat image;
-    while (true)
+    // Building the index reads the whole recording when no sidecar exists yet, only the
+    // interactive player and -seek-time need it
+    bool interactive = export_filename.empty() && ply_prefix.empty() && !parser.get_bench_codec() &&
+                       !parser.get_max_speed();
+    SeekIndex index;
+    if (interactive || (parser.get_seek_frame() < 0 && parser.get_seek_time() >= 0.0))
     {
-        auto err = zed_camera->grab();
+        index.open(source.get(), filename, &std::cout);
+        std::cout << (index.was_loaded() ? "Loaded" : "Built") << " seek index: " << index.size() << " frames, "
+                  << index.duration() << " s" << std::endl;
+    }
+
+    PlaybackState state;
+    int frame_count = source->get_frame_count();
+    if (parser.get_seek_frame() >= 0)
+        state.pending_seek = frame_count >= 0 ? std::min(parser.get_seek_frame(), std::max(0, frame_count - 1))
+                                              : parser.get_seek_frame();
+    else if (parser.get_seek_time() >= 0.0)
+        state.pending_seek = index.frame_at_time(parser.get_seek_time());
+
+    // Exports only, every segment opens the recording again and seeks to its range
+    bool split = segments > 1 && source->get_frame_count() > 0;
+    if (segments > 1 && export_filename.empty() && ply_prefix.empty())
+        std::cout << "-split only applies to -export-depth and -export-ply, ignored" << std::endl;
+    else if (segments > 1 && !split)
+        std::cout << "-split needs a recording of known length, exporting sequentially" << std::endl;
+
+    if (parser.get_bench_codec())
+    {
+        if (state.pending_seek >= 0)
+            source->set_position(state.pending_seek);
+        CodecBenchStats stats = bench_depth_codec(source.get(), parser.get_depth_error(), std::cout);
+        return stats.failures == 0 && stats.simd_mismatches == 0 ? 0 : 1;
+    }
 
-        if (err == sl::ERROR_CODE::SUCCESS)
+    if (!ply_prefix.empty())
+    {
+        if (state.pending_seek >= 0)
+            source->set_position(state.pending_seek);
+        sl::ERROR_CODE err;
+        try
         {
-            zed_camera->retrieveImage(image, sl::VIEW::SIDE_BY_SIDE);
-            cv::Mat view = slMat2cvMat(image);
-            cv::imshow("Record", view);
-            cv::waitKey(1);
+            if (split)
+                err = export_point_clouds_split(
+                    source.get(), [&]() { return open_recording(source_s, filename, true, unit); },
+                    std::max(0, state.pending_seek), segments, parser.get_calib(), ply_prefix, parser.get_voxel(),
+                    std::cout);
+            else
+                err = export_point_clouds(source.get(), parser.get_calib(), ply_prefix, parser.get_voxel(),
+                                          std::cout);
         }
+        catch (const sl::ERROR_CODE &e)
+        {
+            err = e;
+        }
+        if (err != sl::ERROR_CODE::SUCCESS)
+        {
+            std::cerr << "Could not export point clouds: " << err << std::endl;
+            if (err == sl::ERROR_CODE::INVALID_CALIBRATION_FILE && parser.get_calib().empty())
+                std::cerr << source_s << " recordings carry no intrinsics, pass -calib SN<serial>.conf" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!export_filename.empty())
+    {
+        if (state.pending_seek >= 0)
+            source->set_position(state.pending_seek);
+        uint32_t codec = parser.get_depth_codec().compare("f32") == 0 ? DEPTH_CODEC_F32 : DEPTH_CODEC_MM16;
+        sl::ERROR_CODE err;
+        if (split)
+            err = export_depth_split(
+                source.get(), [&]() { return open_recording(source_s, filename, true, unit); },
+                std::max(0, state.pending_seek), segments, export_filename, codec, parser.get_depth_error(), std::cout);
         else
+            err = export_depth(source.get(), export_filename, codec, parser.get_depth_error(), std::cout);
+        if (err != sl::ERROR_CODE::SUCCESS)
         {
-            break;
+            std::cerr << "Could not export depth: " << err << std::endl;
+            return 1;
         }
+        return 0;
     }
-}
\ No newline at end of file
+
+    FrameDecoder decoder(source.get());
+    if (parser.get_max_speed())
+    {
+        if (state.pending_seek >= 0)
+            decoder.seek(state.pending_seek);
+        decoder.start();
+        run_max_speed(decoder, source->get_fps(), std::cout);
+        return 0;
+    }
+    decoder.start();
+
+    LatencyHistogram seek_latency;
+    PlaybackStats stats = play(decoder, index, state, parser.get_speed(), source->get_fps(), seek_latency);
+    decoder.stop();
+
+    std::cout << "Presented " << stats.presented << " frames, skipped " << stats.skipped << " late frames in "
+              << stats.seconds << " s" << std::endl;
+    print_seek_summary(std::cout, seek_latency, source->get_fps());
+}
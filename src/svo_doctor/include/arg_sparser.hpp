@@ -9,6 +9,7 @@
 #include <string>
 
 using ArgStringMap = std::map<std::string, std::string>;
+using ValidSource = std::vector<std::string>;
 
 class ArgParser
 {
@@ -17,6 +18,29 @@ public:
     ArgParser()
     {
         string_map.insert(std::make_pair(std::string("-f"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-src"), std::string("svo")));
+        string_map.insert(std::make_pair(std::string("-j"), std::string("2")));
+        string_map.insert(std::make_pair(std::string("-o"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-mode"), std::string("window")));
+        string_map.insert(std::make_pair(std::string("-t"), std::string("15")));
+        string_map.insert(std::make_pair(std::string("-stride"), std::string("10")));
+        string_map.insert(std::make_pair(std::string("-check"), std::string("none")));
+        string_map.insert(std::make_pair(std::string("-dw"), std::string("2")));
+        string_map.insert(std::make_pair(std::string("-split"), std::string("1")));
+
+        valid_mode.push_back("window");
+        valid_mode.push_back("full");
+        valid_mode.push_back("stride");
+
+        valid_check.push_back("none");
+        valid_check.push_back("image");
+        valid_check.push_back("depth");
+        valid_check.push_back("all");
+
+        valid_source.push_back("svo");
+        valid_source.push_back("raw");
+        valid_source.push_back("synthetic");
+        valid_source.push_back("archive");
     }
 
     void parse(int argc, char *argv[])
@@ -61,7 +85,10 @@ public:
         }
         else 
         {
-            throw std::invalid_argument("Usage -> svo_doctor -f <filename>");
+            throw std::invalid_argument(
+                "Usage -> svo_doctor -f <file|directory|glob> [-src svo|raw|synthetic|archive] [-j workers] [-o report_dir] "
+                "[-mode window|full|stride] [-t seconds] [-stride frames] [-check none|image|depth|all] "
+                "[-dw depth_workers] [-split segments]");
         }
     }
 
@@ -69,9 +96,54 @@ public:
     {
         return string_map.at("-f");
     }
+    std::string get_source()
+    {
+        return string_map.at("-src");
+    }
+    // Number of recordings checked concurrently in batch mode
+    int get_workers()
+    {
+        return std::stoi(string_map.at("-j"));
+    }
+    // Batch reports go next to each recording when empty
+    std::string get_report_dir()
+    {
+        return string_map.at("-o");
+    }
+    std::string get_mode()
+    {
+        return string_map.at("-mode");
+    }
+    // Wall clock budget of the window mode
+    int get_seconds()
+    {
+        return std::stoi(string_map.at("-t"));
+    }
+    int get_stride()
+    {
+        return std::stoi(string_map.at("-stride"));
+    }
+    // Opt-in per frame retrieval checks, none only reads headers and sensors
+    std::string get_checks()
+    {
+        return string_map.at("-check");
+    }
+    // Threads computing depth quality metrics per recording
+    int get_depth_workers()
+    {
+        return std::stoi(string_map.at("-dw"));
+    }
+    // Frame ranges of a single recording checked in parallel, each on its own source
+    int get_segments()
+    {
+        return std::stoi(string_map.at("-split"));
+    }
 
 private:
     ArgStringMap string_map;
+    ValidSource valid_source;
+    ValidSource valid_mode;
+    ValidSource valid_check;
 
     bool check_keyword(const std::string &key, const std::string &value)
     {
@@ -80,9 +152,46 @@ private:
             if (value.compare("") != 0)
                 return true;
         }
+        else if (key.compare("-src") == 0)
+        {
+            if (std::find(valid_source.begin(), valid_source.end(), value) != valid_source.end())
+                return true;
+        }
+        else if (key.compare("-mode") == 0)
+        {
+            if (std::find(valid_mode.begin(), valid_mode.end(), value) != valid_mode.end())
+                return true;
+        }
+        else if (key.compare("-check") == 0)
+        {
+            if (std::find(valid_check.begin(), valid_check.end(), value) != valid_check.end())
+                return true;
+        }
+        else if (key.compare("-t") == 0 || key.compare("-stride") == 0)
+        {
+            if (is_number(value) && value.size() < 7 && std::stoi(value) > 0)
+                return true;
+        }
+        else if (key.compare("-j") == 0 || key.compare("-dw") == 0 || key.compare("-split") == 0)
+        {
+            if (is_number(value) && value.size() < 4 && std::stoi(value) > 0)
+                return true;
+        }
+        else if (key.compare("-o") == 0)
+        {
+            if (value.compare("") != 0)
+                return true;
+        }
         return false;
     }
 
+    bool is_number(const std::string &s)
+    {
+        return !s.empty() && std::find_if(s.begin(),
+                                          s.end(), [](unsigned char c)
+                                          { return !std::isdigit(c); }) == s.end();
+    }
+
     void bad_keyword(const std::string &key, const std::string &value)
     {
         std::string message = "Invalid keyword value pair: (" + key + ", " + value + ").";
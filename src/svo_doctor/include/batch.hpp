@@ -0,0 +1,295 @@
+#ifndef __DOCTOR_BATCH__
+#define __DOCTOR_BATCH__
+
+#include <doctor.hpp>
+#include <utils.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <glob.h>
+#include <sys/stat.h>
+
+static bool is_directory(const std::string &path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+static bool has_glob_characters(const std::string &path)
+{
+    return path.find_first_of("*?[") != std::string::npos;
+}
+
+static std::string recording_extension(const std::string &source)
+{
+    if (source.compare("raw") == 0)
+        return ".raw";
+    if (source.compare("archive") == 0)
+        return DEPTH_ARCHIVE_EXTENSION;
+    return ".svo";
+}
+
+// A directory expands to its recordings of the given source kind, a pattern to its
+// matches, anything else is taken as a single file. The result is sorted.
+static std::vector<std::string> expand_inputs(const std::string &input, const std::string &source)
+{
+    std::string pattern = input;
+    if (is_directory(input))
+        pattern = input + "/*" + recording_extension(source);
+    else if (!has_glob_characters(input))
+        return std::vector<std::string>(1, input);
+
+    std::vector<std::string> files;
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, nullptr, &matches) == 0)
+    {
+        for (size_t i = 0; i < matches.gl_pathc; ++i)
+            if (!is_directory(matches.gl_pathv[i]))
+                files.push_back(matches.gl_pathv[i]);
+    }
+    globfree(&matches);
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static std::string json_escape(const std::string &value)
+{
+    std::string escaped;
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if ((unsigned char)c < 0x20)
+            continue;
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Quoted CSV field, embedded quotes are doubled
+static std::string csv_quote(const std::string &value)
+{
+    std::string quoted = "\"";
+    for (char c : value)
+    {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static void write_json(std::ostream &out, const FileReport &report)
+{
+    out << "{\"file\": \"" << json_escape(report.filename) << "\", "
+        << "\"opened\": " << (report.opened ? "true" : "false") << ", "
+        << "\"error\": \"" << json_escape(report.error) << "\", "
+        << "\"healthy\": " << (report.healthy() ? "true" : "false") << ", "
+        << "\"frames\": " << report.n_frames << ", "
+        << "\"frames_total\": " << report.frames_total << ", "
+        << "\"invalid_frames\": " << report.frame_drop_count << ", "
+        << "\"timestamp_errors\": " << report.timestamp_errors << ", "
+        << "\"timestamp_gaps\": " << report.timestamp_gaps << ", "
+        << "\"sensor_ok\": " << (report.sensor_ok ? "true" : "false") << ", "
+        << "\"imu_nonzero\": " << report.imu_count << ", "
+        << "\"barometer_nonzero\": " << report.bar_count << ", "
+        << "\"magnetometer_nonzero\": " << report.mag_count << ", "
+        << "\"depth_ok\": " << (report.depth_checked ? std::to_string(report.depth_count) : "null") << ", "
+        << "\"seconds\": " << report.seconds << ", \"sensors\": ";
+    write_timeline_json(out, report.sensors);
+    if (report.depth_checked)
+    {
+        out << ", \"depth_quality\": ";
+        write_depth_quality_json(out, report.depth_quality);
+    }
+    if (report.has_sensor_log)
+    {
+        out << ", \"sensor_log\": ";
+        write_timeline_json(out, report.sensor_log);
+    }
+    out << "}";
+}
+
+static void write_csv_header(std::ostream &out)
+{
+    out << "file,opened,healthy,frames,frames_total,invalid_frames,timestamp_errors,timestamp_gaps,sensor_ok,"
+        << "imu_nonzero,barometer_nonzero,magnetometer_nonzero,depth_ok,depth_valid_mean,depth_sparse_frames,"
+        << "depth_stability_m,seconds,imu_rate_hz,imu_max_gap_ms,imu_duplicates,imu_out_of_order,"
+        << "image_imu_drift_us_per_s,vio_ready,error" << std::endl;
+}
+
+// The IMU columns come from the sensor log when there is one
+static void write_csv_row(std::ostream &out, const FileReport &report)
+{
+    const SensorTimeline &timeline = report.has_sensor_log ? report.sensor_log : report.sensors;
+    const StreamTimeline &imu = timeline.imu;
+    out << csv_quote(report.filename) << "," << report.opened << "," << report.healthy() << ","
+        << report.n_frames << "," << report.frames_total << "," << report.frame_drop_count << ","
+        << report.timestamp_errors << "," << report.timestamp_gaps << "," << report.sensor_ok << ","
+        << report.imu_count << "," << report.bar_count << "," << report.mag_count << ","
+        << (report.depth_checked ? std::to_string(report.depth_count) : "") << ",";
+    if (report.depth_checked)
+        out << report.depth_quality.mean_valid_fraction() << "," << report.depth_quality.sparse_frames << ","
+            << report.depth_quality.mean_stability() << ",";
+    else
+        out << ",,,";
+    out << report.seconds << ","
+        << imu.rate_hz() << "," << imu.max_gap_ns() / 1e6 << "," << imu.get_duplicates() << ","
+        << imu.get_out_of_order() << "," << report.sensors.image_imu.drift_ns_per_s() / 1e3 << ","
+        << timeline.vio_ready() << "," << csv_quote(report.error) << std::endl;
+}
+
+static std::string report_path(const std::string &report_dir, const std::string &filename, const std::string &suffix)
+{
+    if (report_dir.empty())
+        return filename + suffix;
+
+    size_t slash = filename.find_last_of('/');
+    std::string name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+    return report_dir + "/" + name + suffix;
+}
+
+// Checks recordings on a bounded pool of workers. Each worker opens one recording at a
+// time, so at most `workers` SDK cameras are alive at once. Workers pull the next file
+// from a shared index, which keeps them busy when file lengths differ.
+class BatchDoctor
+{
+public:
+    BatchDoctor(const std::vector<std::string> &files, const std::string &source, int workers,
+                const std::string &report_dir, const CheckOptions &options)
+        : files(files), source(source), report_dir(report_dir), options(options), reports(files.size()),
+          worker_frames(workers, 0), worker_seconds(workers, 0.0)
+    {
+    }
+
+    void run()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < worker_frames.size(); ++i)
+            threads.emplace_back(&BatchDoctor::worker_loop, this, i);
+        for (auto &thread : threads)
+            thread.join();
+
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Aggregate report in CSV and JSON, plus throughput on `out`. Returns the number
+    // of recordings that could not be opened.
+    int summarize(std::ostream &out)
+    {
+        std::string prefix = report_dir.empty() ? std::string("svo_doctor_summary") : report_dir + "/summary";
+        std::ofstream csv(prefix + ".csv");
+        write_csv_header(csv);
+
+        int failed = 0, healthy = 0;
+        long long total_frames = 0;
+        for (auto &report : reports)
+        {
+            write_csv_row(csv, report);
+            failed += !report.opened;
+            healthy += report.healthy();
+            total_frames += report.n_frames;
+        }
+
+        std::ofstream json(prefix + ".json");
+        json << "{\"files\": " << reports.size() << ", \"healthy\": " << healthy << ", \"failed_to_open\": "
+             << failed << ", \"frames\": " << total_frames << ", \"seconds\": " << elapsed
+             << ", \"files_per_minute\": " << files_per_minute() << ", \"workers\": [";
+        for (size_t i = 0; i < worker_frames.size(); ++i)
+            json << (i ? ", " : "") << "{\"frames\": " << worker_frames[i] << ", \"frames_per_second\": "
+                 << worker_fps(i) << "}";
+        json << "], \"reports\": [";
+        for (size_t i = 0; i < reports.size(); ++i)
+        {
+            json << (i ? ", " : "");
+            write_json(json, reports[i]);
+        }
+        json << "]}" << std::endl;
+
+        out << std::endl << "Checked " << reports.size() << " recordings in " << std::fixed << std::setprecision(1)
+            << elapsed << " s: " << healthy << " healthy, " << reports.size() - healthy - failed << " with issues, "
+            << failed << " could not be opened" << std::endl;
+        out << "Throughput: " << files_per_minute() << " files/min, " << total_frames << " frames" << std::endl;
+        for (size_t i = 0; i < worker_frames.size(); ++i)
+            out << "  worker " << i << ": " << worker_frames[i] << " frames, " << worker_fps(i) << " frames/s"
+                << std::endl;
+        out << std::defaultfloat << "Summary written to " << prefix << ".csv and " << prefix << ".json" << std::endl;
+        return failed;
+    }
+
+private:
+    std::vector<std::string> files;
+    std::string source;
+    std::string report_dir;
+    CheckOptions options;
+    std::vector<FileReport> reports;
+    std::vector<long long> worker_frames;
+    std::vector<double> worker_seconds;
+    std::atomic<size_t> next_file{0};
+    std::mutex console;
+    double elapsed = 0.0;
+
+    void worker_loop(size_t worker)
+    {
+        size_t index;
+        while ((index = next_file.fetch_add(1)) < files.size())
+        {
+            FileReport &report = reports[index];
+            report.filename = files[index];
+            auto start = std::chrono::steady_clock::now();
+
+            try
+            {
+                std::unique_ptr<FrameSource> recording = open_recording(source, report.filename, options.check_depth);
+                report.opened = true;
+                check_recording(recording.get(), report, options);
+                check_sensor_log(report);
+            }
+            catch (const sl::ERROR_CODE &err)
+            {
+                std::ostringstream message;
+                message << err;
+                report.error = message.str();
+            }
+            catch (const std::exception &e)
+            {
+                // Anything else, a failed allocation or a bad sidecar, fails this file only
+                report.error = e.what();
+            }
+
+            worker_frames[worker] += report.n_frames;
+            worker_seconds[worker] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::ofstream json(report_path(report_dir, report.filename, ".doctor.json"));
+            write_json(json, report);
+            json << std::endl;
+
+            std::lock_guard<std::mutex> lock(console);
+            std::cout << "[" << worker << "] " << report.filename << ": "
+                      << (report.opened ? (report.healthy() ? "OK" : "ISSUES") : "FAILED " + report.error) << " ("
+                      << report.n_frames << " frames)" << std::endl;
+        }
+    }
+
+    double files_per_minute() const
+    {
+        return elapsed > 0.0 ? 60.0 * reports.size() / elapsed : 0.0;
+    }
+
+    double worker_fps(size_t worker) const
+    {
+        return worker_seconds[worker] > 0.0 ? worker_frames[worker] / worker_seconds[worker] : 0.0;
+    }
+};
+
+#endif
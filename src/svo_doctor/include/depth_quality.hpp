@@ -0,0 +1,287 @@
+#ifndef __DOCTOR_DEPTH_QUALITY__
+#define __DOCTOR_DEPTH_QUALITY__
+
+#include <frame_source.hpp>
+#include <depth_stats.hpp>
+#include <object_pool.hpp>
+#include <spsc_queue.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#define QUALITY_QUEUE_DEPTH 4
+#define DEPTH_HIST_BINS 20
+#define DEPTH_HIST_BIN_METERS 0.5f
+// Frames with fewer valid pixels than this count as sparse
+#define SPARSE_VALID_FRACTION 0.5
+
+// Per file aggregate of the per frame depth metrics. Stability is the mean absolute
+// depth change in meters over the pixels valid in a frame and in the previous one.
+struct DepthQuality
+{
+    uint64_t frames = 0;
+    uint64_t sparse_frames = 0;
+    double valid_fraction_sum = 0.0;
+    double valid_fraction_min = 1.0;
+    uint64_t pairs = 0;
+    double stability_sum = 0.0;
+    double stability_max = 0.0;
+    uint64_t histogram[DEPTH_HIST_BINS + 1] = {};
+
+    double mean_valid_fraction() const
+    {
+        return frames > 0 ? valid_fraction_sum / frames : 0.0;
+    }
+
+    double mean_stability() const
+    {
+        return pairs > 0 ? stability_sum / pairs : 0.0;
+    }
+
+    void merge(const DepthQuality &other)
+    {
+        frames += other.frames;
+        sparse_frames += other.sparse_frames;
+        valid_fraction_sum += other.valid_fraction_sum;
+        valid_fraction_min = std::min(valid_fraction_min, other.valid_fraction_min);
+        pairs += other.pairs;
+        stability_sum += other.stability_sum;
+        stability_max = std::max(stability_max, other.stability_max);
+        for (int i = 0; i <= DEPTH_HIST_BINS; ++i)
+            histogram[i] += other.histogram[i];
+    }
+};
+
+struct DepthBuffer
+{
+    sl::Mat depth;
+    DepthBuffer *previous;
+    // One reference for its own analysis, one for the analysis of the next frame
+    std::atomic<int> references{0};
+};
+
+using DepthQueue = SpscQueue<DepthBuffer *>;
+
+// One pass over a depth map: valid pixels, histogram and change against the previous
+// map when there is one of the same size
+static void analyse_depth(sl::Mat &depth, sl::Mat *previous, float to_meters, DepthQuality &quality)
+{
+    TypedView<const float> view(depth);
+    int width = view.width();
+    int height = view.height();
+
+    TypedView<const float> prev_view;
+    if (previous != nullptr && (int)previous->getWidth() == width && (int)previous->getHeight() == height)
+        prev_view = TypedView<const float>(*previous);
+
+    const float bin_scale = to_meters / DEPTH_HIST_BIN_METERS;
+    uint64_t valid = 0, both = 0;
+    double change = 0.0;
+
+    for (int row = 0; row < height; ++row)
+    {
+        const float *src = view.row(row);
+        const float *prev = !prev_view.empty() ? prev_view.row(row) : nullptr;
+        for (int col = 0; col < width; ++col)
+        {
+            float value = src[col];
+            if (!std::isfinite(value))
+                continue;
+
+            valid++;
+            quality.histogram[std::min((int)(value * bin_scale), DEPTH_HIST_BINS)]++;
+            if (prev != nullptr && std::isfinite(prev[col]))
+            {
+                change += std::fabs(value - prev[col]);
+                both++;
+            }
+        }
+    }
+
+    double valid_fraction = width * height > 0 ? (double)valid / ((double)width * height) : 0.0;
+    quality.frames++;
+    quality.valid_fraction_sum += valid_fraction;
+    quality.valid_fraction_min = std::min(quality.valid_fraction_min, valid_fraction);
+    if (valid_fraction < SPARSE_VALID_FRACTION)
+        quality.sparse_frames++;
+
+    if (both > 0)
+    {
+        double stability = change / both * to_meters;
+        quality.pairs++;
+        quality.stability_sum += stability;
+        quality.stability_max = std::max(quality.stability_max, stability);
+    }
+}
+
+// Depth maps retrieved by the grab thread are handed to worker threads, which compute
+// the metrics without slowing decoding. Buffers come from a pool and each one keeps a
+// link to the previous frame for the stability score; a buffer returns to the pool once
+// both its own frame and the next one are analysed. The grab thread waits when the
+// pool or a queue is full instead of dropping, so every submitted frame is measured.
+class DepthQualityAnalyzer
+{
+public:
+    DepthQualityAnalyzer(int workers, sl::UNIT unit)
+        : to_meters(1.f / meters_to_unit(unit)), pool(workers * (QUALITY_QUEUE_DEPTH + 1) + 2),
+          results(workers)
+    {
+        for (int i = 0; i < workers; ++i)
+            queues.emplace_back(new DepthQueue(QUALITY_QUEUE_DEPTH));
+    }
+
+    ~DepthQualityAnalyzer()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        running = true;
+        for (size_t i = 0; i < queues.size(); ++i)
+            threads.emplace_back(&DepthQualityAnalyzer::worker_loop, this, i);
+    }
+
+    // Retrieves the depth of the last grabbed frame into a pooled buffer and queues it
+    sl::ERROR_CODE submit(FrameSource *source)
+    {
+        DepthBuffer *buffer;
+        int idle = 0;
+        while ((buffer = pool.acquire()) == nullptr)
+            wait(idle);
+
+        auto err = source->retrieve_measure(buffer->depth, sl::MEASURE::DEPTH);
+        if (err != sl::ERROR_CODE::SUCCESS)
+        {
+            pool.release(buffer);
+            return err;
+        }
+
+        buffer->references.store(2, std::memory_order_relaxed);
+        buffer->previous = last;
+        last = buffer;
+
+        idle = 0;
+        while (!queues[next_queue]->push(buffer))
+            wait(idle);
+        next_queue = (next_queue + 1) % queues.size();
+        return err;
+    }
+
+    // Stops the workers after the queued frames and returns the merged metrics
+    DepthQuality finish()
+    {
+        stop();
+        DepthQuality total;
+        for (auto &result : results)
+            total.merge(result);
+        return total;
+    }
+
+private:
+    float to_meters;
+    ObjectPool<DepthBuffer> pool;
+    std::vector<std::unique_ptr<DepthQueue>> queues;
+    std::vector<DepthQuality> results;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running{false};
+    DepthBuffer *last = nullptr;
+    size_t next_queue = 0;
+
+    void stop()
+    {
+        running = false;
+        for (auto &thread : threads)
+            thread.join();
+        threads.clear();
+
+        if (last != nullptr)
+            unref(last);
+        last = nullptr;
+    }
+
+    void unref(DepthBuffer *buffer)
+    {
+        if (buffer->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            pool.release(buffer);
+    }
+
+    static void wait(int &idle)
+    {
+        if (++idle < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    void worker_loop(size_t index)
+    {
+        DepthQueue &queue = *queues[index];
+        DepthBuffer *buffer;
+        int idle = 0;
+
+        while (true)
+        {
+            if (!queue.pop(buffer))
+            {
+                if (!running)
+                    break;
+                wait(idle);
+                continue;
+            }
+            idle = 0;
+
+            analyse_depth(buffer->depth, buffer->previous != nullptr ? &buffer->previous->depth : nullptr, to_meters,
+                          results[index]);
+            if (buffer->previous != nullptr)
+                unref(buffer->previous);
+            unref(buffer);
+        }
+    }
+};
+
+static void print_depth_quality(std::ostream &out, const DepthQuality &quality)
+{
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1) << "Depth valid pixels: mean " << 100.0 * quality.mean_valid_fraction()
+        << "%, min " << 100.0 * (quality.frames > 0 ? quality.valid_fraction_min : 0.0) << "%, "
+        << quality.sparse_frames << "/" << quality.frames << " frames below " << 100.0 * SPARSE_VALID_FRACTION
+        << "%" << std::endl;
+    out << std::setprecision(3) << "Depth stability: mean change " << quality.mean_stability() << " m, worst frame "
+        << quality.stability_max << " m over " << quality.pairs << " frame pairs" << std::endl;
+
+    uint64_t total = 0;
+    for (int i = 0; i <= DEPTH_HIST_BINS; ++i)
+        total += quality.histogram[i];
+    out << std::setprecision(1) << "Depth histogram (" << DEPTH_HIST_BIN_METERS << " m bins):";
+    for (int i = 0; i <= DEPTH_HIST_BINS; ++i)
+    {
+        if (i % 7 == 0)
+            out << std::endl << "  ";
+        if (i < DEPTH_HIST_BINS)
+            out << std::setw(4) << i * DEPTH_HIST_BIN_METERS << "m ";
+        else
+            out << ">" << std::setw(3) << i * DEPTH_HIST_BIN_METERS << "m ";
+        out << std::setw(5) << (total > 0 ? 100.0 * quality.histogram[i] / total : 0.0) << "%  ";
+    }
+    out << std::defaultfloat << std::setprecision(precision) << std::endl;
+}
+
+static void write_depth_quality_json(std::ostream &out, const DepthQuality &quality)
+{
+    out << "{\"frames\": " << quality.frames << ", \"valid_fraction_mean\": " << quality.mean_valid_fraction()
+        << ", \"valid_fraction_min\": " << (quality.frames > 0 ? quality.valid_fraction_min : 0.0)
+        << ", \"sparse_frames\": " << quality.sparse_frames << ", \"stability_mean_m\": " << quality.mean_stability()
+        << ", \"stability_max_m\": " << quality.stability_max << ", \"histogram_bin_m\": " << DEPTH_HIST_BIN_METERS
+        << ", \"histogram\": [";
+    for (int i = 0; i <= DEPTH_HIST_BINS; ++i)
+        out << (i ? ", " : "") << quality.histogram[i];
+    out << "]}";
+}
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef __DOCTOR_CHECK__
+#define __DOCTOR_CHECK__
+
+#include <sl/Camera.hpp>
+#include <frame_source.hpp>
+#include <depth_quality.hpp>
+#include <sensor_timeline.hpp>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// Consecutive frames further apart than this many periods count as a timestamp gap
+#define TIMESTAMP_GAP_TOLERANCE 1.5
+
+// WINDOW checks the frames reached within `seconds` of wall time, FULL every frame as
+// fast as possible and STRIDE every `stride`-th frame by seeking. Header checks
+// (timestamps, sensors) always run, image and depth retrieval only on request.
+enum class CheckMode
+{
+    WINDOW,
+    FULL,
+    STRIDE
+};
+
+struct CheckOptions
+{
+    CheckMode mode = CheckMode::WINDOW;
+    int seconds = 15;
+    int stride = 1;
+    bool check_image = false;
+    bool check_depth = false;
+    int depth_workers = 2;
+};
+
+struct FileReport
+{
+    std::string filename;
+    std::string error;
+    bool opened = false;
+    bool sensor_ok = true;
+    bool image_checked = false;
+    bool depth_checked = false;
+    int frames_total = -1;
+    int n_frames = 0;
+    int frame_drop_count = 0;
+    int timestamp_errors = 0;
+    int timestamp_gaps = 0;
+    int imu_count = 0;
+    int bar_count = 0;
+    int mag_count = 0;
+    int depth_count = 0;
+    double seconds = 0.0;
+    DepthQuality depth_quality;
+    SensorTimeline sensors;
+    SensorTimeline sensor_log;
+    bool has_sensor_log = false;
+
+    bool healthy() const
+    {
+        return opened && error.empty() && sensor_ok && frame_drop_count == 0 && timestamp_errors == 0 &&
+               timestamp_gaps == 0 && (!depth_checked || depth_count == n_frames);
+    }
+};
+
+static void print_progress(std::ostream &out, const FileReport &report, int position, double elapsed)
+{
+    double fps = elapsed > 0.0 ? report.n_frames / elapsed : 0.0;
+    out << '\r' << std::fixed << std::setprecision(1) << "  frame " << position;
+    if (report.frames_total > 0)
+    {
+        double done = (double)position / report.frames_total;
+        double eta = done > 0.0 ? elapsed * (1.0 - done) / done : 0.0;
+        out << "/" << report.frames_total << " (" << 100.0 * done << "%), ETA " << eta << " s";
+    }
+    out << ", " << fps << " frames/s   " << std::defaultfloat << std::flush;
+}
+
+// Per frame outcome of the checks, folded into a FileReport in frame order
+#define FRAME_GRABBED 0x1
+#define FRAME_IMAGE_OK 0x2
+#define FRAME_SENSORS_OK 0x4
+#define FRAME_IMU_NONZERO 0x8
+#define FRAME_BAROMETER_NONZERO 0x10
+#define FRAME_MAGNETOMETER_NONZERO 0x20
+#define FRAME_DEPTH_OK 0x40
+
+struct FrameCheck
+{
+    uint64_t timestamp_ns;
+    uint64_t imu_ns;
+    uint64_t barometer_ns;
+    uint64_t magnetometer_ns;
+    uint32_t flags;
+};
+
+// Everything but depth, which callers retrieve into their own buffers
+static void check_frame(FrameSource *source, sl::ERROR_CODE err, const CheckOptions &options, sl::Mat &image,
+                        FrameCheck &check)
+{
+    check = FrameCheck();
+    if (err != sl::ERROR_CODE::SUCCESS)
+        return;
+
+    check.flags = FRAME_GRABBED;
+    check.timestamp_ns = source->get_timestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+    if (!options.check_image || source->retrieve_image(image, sl::VIEW::SIDE_BY_SIDE) == sl::ERROR_CODE::SUCCESS)
+        check.flags |= FRAME_IMAGE_OK;
+
+    sl::SensorsData data;
+    if (source->get_sensors_data(data, sl::TIME_REFERENCE::IMAGE) == sl::ERROR_CODE::SUCCESS)
+    {
+        check.flags |= FRAME_SENSORS_OK;
+        check.imu_ns = data.imu.timestamp.getNanoseconds();
+        check.barometer_ns = data.barometer.timestamp.getNanoseconds();
+        check.magnetometer_ns = data.magnetometer.timestamp.getNanoseconds();
+    }
+
+    if (data.imu.pose.getTranslation().norm() > std::abs(0.05))
+        check.flags |= FRAME_IMU_NONZERO;
+    if (data.barometer.pressure > std::abs(0.05))
+        check.flags |= FRAME_BAROMETER_NONZERO;
+    if (data.magnetometer.magnetic_field_calibrated.norm() > std::abs(0.05))
+        check.flags |= FRAME_MAGNETOMETER_NONZERO;
+}
+
+// `last_timestamp` carries the previous frame between calls, `period_ns` is the
+// expected spacing of consecutive checked frames
+static void add_frame_check(FileReport &report, const FrameCheck &check, double period_ns, uint64_t &last_timestamp)
+{
+    report.n_frames++;
+    if (!(check.flags & FRAME_GRABBED))
+    {
+        report.frame_drop_count++;
+        return;
+    }
+
+    uint64_t timestamp = check.timestamp_ns;
+    if (last_timestamp != 0 && timestamp <= last_timestamp)
+        report.timestamp_errors++;
+    else if (last_timestamp != 0 && period_ns > 0.0 && timestamp - last_timestamp > TIMESTAMP_GAP_TOLERANCE * period_ns)
+        report.timestamp_gaps++;
+    last_timestamp = timestamp;
+
+    if (!(check.flags & FRAME_IMAGE_OK))
+        report.frame_drop_count++;
+
+    if (check.flags & FRAME_SENSORS_OK)
+        report.sensors.add_frame(timestamp, check.imu_ns, check.barometer_ns, check.magnetometer_ns);
+    if (report.sensor_ok == true)
+    {
+        if (!(check.flags & FRAME_SENSORS_OK))
+            report.sensor_ok = false;
+        if (check.flags & FRAME_IMU_NONZERO)
+            report.imu_count++;
+        if (check.flags & FRAME_BAROMETER_NONZERO)
+            report.bar_count++;
+        if (check.flags & FRAME_MAGNETOMETER_NONZERO)
+            report.mag_count++;
+    }
+
+    if (check.flags & FRAME_DEPTH_OK)
+        report.depth_count++;
+}
+
+static void begin_report(FrameSource *source, FileReport &report, const CheckOptions &options)
+{
+    report.image_checked = options.check_image;
+    report.depth_checked = options.check_depth;
+    report.frames_total = source->get_frame_count();
+}
+
+static int check_stride(const CheckOptions &options)
+{
+    return options.mode == CheckMode::STRIDE ? std::max(1, options.stride) : 1;
+}
+
+// `progress` receives a status line twice per second when not null
+static void check_recording(FrameSource *source, FileReport &report, const CheckOptions &options,
+                            std::ostream *progress = nullptr)
+{
+    sl::RuntimeParameters rt_params;
+    rt_params.enable_depth = options.check_depth;
+    sl::Mat image;
+    FrameCheck check;
+
+    begin_report(source, report, options);
+    int stride = check_stride(options);
+    double period_ns = source->get_fps() > 0.f ? stride * 1e9 / source->get_fps() : 0.0;
+    uint64_t last_timestamp = 0;
+
+    std::unique_ptr<DepthQualityAnalyzer> depth_analyzer;
+    if (options.check_depth)
+    {
+        depth_analyzer.reset(new DepthQualityAnalyzer(std::max(1, options.depth_workers), source->get_unit()));
+        depth_analyzer->start();
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto last_progress = start;
+    bool progress_shown = false;
+
+    while (options.mode != CheckMode::WINDOW ||
+           std::chrono::duration_cast<std::chrono::seconds>(end - start).count() < options.seconds)
+    {
+        auto err = source->grab(rt_params);
+        if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+            break;
+
+        check_frame(source, err, options, image, check);
+        if (err == sl::ERROR_CODE::SUCCESS && depth_analyzer &&
+            depth_analyzer->submit(source) == sl::ERROR_CODE::SUCCESS)
+            check.flags |= FRAME_DEPTH_OK;
+        add_frame_check(report, check, period_ns, last_timestamp);
+        end = std::chrono::high_resolution_clock::now();
+
+        int position = source->get_position();
+        if (stride > 1)
+        {
+            if (report.frames_total > 0 && position + stride >= report.frames_total)
+                break;
+            source->set_position(position + stride);
+        }
+
+        if (progress != nullptr && end - last_progress > std::chrono::milliseconds(500))
+        {
+            print_progress(*progress, report, position + 1, std::chrono::duration<double>(end - start).count());
+            last_progress = end;
+            progress_shown = true;
+        }
+    }
+
+    if (depth_analyzer)
+        report.depth_quality = depth_analyzer->finish();
+    report.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    if (progress_shown)
+        *progress << std::endl;
+}
+
+// Full rate sensor log written by video_capture -imu next to the recording
+static std::string sensor_log_path(const std::string &filename)
+{
+    size_t dot = filename.find_last_of('.');
+    size_t slash = filename.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return filename + ".imu";
+    return filename.substr(0, dot) + ".imu";
+}
+
+static void check_sensor_log(FileReport &report)
+{
+    std::ifstream probe(sensor_log_path(report.filename));
+    if (!probe.is_open())
+        return;
+    probe.close();
+
+    try
+    {
+        SensorLogReader reader(sensor_log_path(report.filename));
+        SensorRecord record;
+        while (reader.next(record))
+            report.sensor_log.add_record(record);
+        report.has_sensor_log = true;
+    }
+    catch (const sl::ERROR_CODE &)
+    {
+    }
+}
+
+static void print_report(std::ostream &out, const FileReport &report)
+{
+    out << "Frames processed: " << report.n_frames;
+    if (report.frames_total > 0)
+        out << " of " << report.frames_total;
+    out << " in " << report.seconds << " s (" << (report.seconds > 0.0 ? report.n_frames / report.seconds : 0.0)
+        << " frames/s)" << std::endl;
+    out << "Timestamps: " << report.timestamp_errors << " non increasing, " << report.timestamp_gaps << " gaps"
+        << std::endl;
+    if (report.sensor_ok)
+    {
+        out << "Sensor status: OK" << std::endl;
+        out << "Invalid frame count: " << report.frame_drop_count << std::endl;
+        out << "IMU non zero measurements: " << report.imu_count << "/" << report.n_frames << std::endl;
+        out << "Barometer non zero measurements: " << report.bar_count << "/" << report.n_frames << std::endl;
+        out << "Magnetometer non zero measurements: " << report.mag_count << "/" << report.n_frames << std::endl;
+    }
+    else
+        out << "Sensor status: Unavailable" << std::endl;
+
+    if (report.depth_checked)
+    {
+        out << "Depth successful computations: " << report.depth_count << "/" << report.n_frames << std::endl;
+        print_depth_quality(out, report.depth_quality);
+    }
+    else
+        out << "Depth: not checked (-check depth)" << std::endl;
+
+    print_timeline(out, "Sensor timeline (per frame):", report.sensors, true);
+    if (report.has_sensor_log)
+        print_timeline(out, ("Sensor timeline (" + sensor_log_path(report.filename) + "):").c_str(),
+                       report.sensor_log, false);
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef __DOCTOR_SENSOR_TIMELINE__
+#define __DOCTOR_SENSOR_TIMELINE__
+
+#include <sl/Camera.hpp>
+#include <latency_histogram.hpp>
+#include <sensor_log.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+
+// Inter-sample gaps are bucketed in multiples of the median period
+#define GAP_BUCKETS 5
+static const double GAP_BUCKET_LIMITS[GAP_BUCKETS] = {1.5, 2.5, 5.0, 10.0, std::numeric_limits<double>::infinity()};
+
+// Timestamp statistics of one sensor stream in constant memory. Repeated timestamps
+// count as duplicates and earlier ones as out of order; neither moves the reference
+// the next gap is measured from.
+class StreamTimeline
+{
+public:
+    void add(uint64_t timestamp_ns)
+    {
+        if (timestamp_ns == 0)
+            return;
+
+        if (samples == 0)
+        {
+            first = last = timestamp_ns;
+            samples = 1;
+            return;
+        }
+        if (timestamp_ns == last)
+        {
+            duplicates++;
+            return;
+        }
+        if (timestamp_ns < last)
+        {
+            out_of_order++;
+            return;
+        }
+
+        gaps.record(timestamp_ns - last);
+        last = timestamp_ns;
+        samples++;
+    }
+
+    double rate_hz() const
+    {
+        return samples > 1 ? (samples - 1) * 1e9 / (double)(last - first) : 0.0;
+    }
+
+    uint64_t median_period_ns() const
+    {
+        return gaps.percentile(0.5);
+    }
+
+    uint64_t max_gap_ns() const
+    {
+        return gaps.get_max();
+    }
+
+    // Gaps longer than 1.5 median periods
+    uint64_t long_gaps() const
+    {
+        return gaps.get_count() - gaps.count_below((uint64_t)(1.5 * median_period_ns()));
+    }
+
+    // counts[i]: gaps up to GAP_BUCKET_LIMITS[i] median periods
+    void gap_histogram(uint64_t counts[GAP_BUCKETS]) const
+    {
+        uint64_t median = median_period_ns();
+        uint64_t below = 0;
+        for (int i = 0; i < GAP_BUCKETS; ++i)
+        {
+            uint64_t upto = i + 1 < GAP_BUCKETS ? gaps.count_below((uint64_t)(GAP_BUCKET_LIMITS[i] * median))
+                                                : gaps.get_count();
+            counts[i] = upto - below;
+            below = upto;
+        }
+    }
+
+    uint64_t get_samples() const
+    {
+        return samples;
+    }
+
+    uint64_t get_duplicates() const
+    {
+        return duplicates;
+    }
+
+    uint64_t get_out_of_order() const
+    {
+        return out_of_order;
+    }
+
+private:
+    LatencyHistogram gaps;
+    uint64_t samples = 0;
+    uint64_t duplicates = 0;
+    uint64_t out_of_order = 0;
+    uint64_t first = 0;
+    uint64_t last = 0;
+};
+
+// Image minus IMU timestamp per frame, with a least squares fit of the offset against
+// recording time whose slope is the drift between the two clocks
+class OffsetDrift
+{
+public:
+    void add(uint64_t image_ns, uint64_t imu_ns)
+    {
+        if (image_ns == 0 || imu_ns == 0)
+            return;
+        if (n == 0)
+            origin = image_ns;
+
+        double offset = (double)((int64_t)(image_ns - imu_ns));
+        double t = (double)((int64_t)(image_ns - origin)) / 1e9;
+        n++;
+        sum_t += t;
+        sum_o += offset;
+        sum_tt += t * t;
+        sum_to += t * offset;
+        min_offset = std::min(min_offset, offset);
+        max_offset = std::max(max_offset, offset);
+    }
+
+    double mean_offset_ns() const
+    {
+        return n > 0 ? sum_o / n : 0.0;
+    }
+
+    // Nanoseconds of offset change per second of recording
+    double drift_ns_per_s() const
+    {
+        double denominator = n * sum_tt - sum_t * sum_t;
+        return n > 1 && denominator > 0.0 ? (n * sum_to - sum_t * sum_o) / denominator : 0.0;
+    }
+
+    double get_min() const
+    {
+        return n > 0 ? min_offset : 0.0;
+    }
+
+    double get_max() const
+    {
+        return n > 0 ? max_offset : 0.0;
+    }
+
+    uint64_t get_count() const
+    {
+        return n;
+    }
+
+private:
+    uint64_t n = 0;
+    uint64_t origin = 0;
+    double sum_t = 0.0, sum_o = 0.0, sum_tt = 0.0, sum_to = 0.0;
+    double min_offset = std::numeric_limits<double>::max();
+    double max_offset = std::numeric_limits<double>::lowest();
+};
+
+struct SensorTimeline
+{
+    StreamTimeline imu;
+    StreamTimeline barometer;
+    StreamTimeline magnetometer;
+    OffsetDrift image_imu;
+
+    void add_frame(uint64_t image_ns, uint64_t imu_ns, uint64_t barometer_ns, uint64_t magnetometer_ns)
+    {
+        imu.add(imu_ns);
+        barometer.add(barometer_ns);
+        magnetometer.add(magnetometer_ns);
+        image_imu.add(image_ns, imu_ns);
+    }
+
+    void add_record(const SensorRecord &record)
+    {
+        imu.add(record.imu_timestamp_ns);
+        if (record.flags & SENSOR_NEW_BAROMETER)
+            barometer.add(record.barometer_timestamp_ns);
+        if (record.flags & SENSOR_NEW_MAGNETOMETER)
+            magnetometer.add(record.magnetometer_timestamp_ns);
+    }
+
+    // IMU samples strictly ordered and no gap above ten median periods
+    bool vio_ready() const
+    {
+        uint64_t counts[GAP_BUCKETS];
+        imu.gap_histogram(counts);
+        return imu.get_samples() > 1 && imu.get_out_of_order() == 0 && counts[GAP_BUCKETS - 1] == 0;
+    }
+};
+
+static void print_stream(std::ostream &out, const char *name, const StreamTimeline &stream)
+{
+    uint64_t counts[GAP_BUCKETS];
+    stream.gap_histogram(counts);
+
+    out << "  " << std::left << std::setw(13) << name << std::right << stream.get_samples() << " samples, "
+        << stream.rate_hz() << " Hz, median period " << stream.median_period_ns() / 1e6 << " ms, max gap "
+        << stream.max_gap_ns() / 1e6 << " ms, " << stream.get_duplicates() << " duplicated, "
+        << stream.get_out_of_order() << " out of order" << std::endl;
+    out << "    gaps (x median) <=1.5: " << counts[0] << "  <=2.5: " << counts[1] << "  <=5: " << counts[2]
+        << "  <=10: " << counts[3] << "  >10: " << counts[4] << std::endl;
+}
+
+static void print_timeline(std::ostream &out, const char *title, const SensorTimeline &timeline, bool with_offset)
+{
+    std::streamsize precision = out.precision();
+    out << title << std::fixed << std::setprecision(2) << std::endl;
+    print_stream(out, "IMU", timeline.imu);
+    print_stream(out, "Barometer", timeline.barometer);
+    print_stream(out, "Magnetometer", timeline.magnetometer);
+    if (with_offset && timeline.image_imu.get_count() > 0)
+        out << "  image - IMU offset: mean " << timeline.image_imu.mean_offset_ns() / 1e6 << " ms, range ["
+            << timeline.image_imu.get_min() / 1e6 << ", " << timeline.image_imu.get_max() / 1e6 << "] ms, drift "
+            << timeline.image_imu.drift_ns_per_s() / 1e3 << " us/s" << std::endl;
+    out << "  usable for VIO: " << (timeline.vio_ready() ? "yes" : "no") << std::defaultfloat
+        << std::setprecision(precision) << std::endl;
+}
+
+static void write_stream_json(std::ostream &out, const StreamTimeline &stream)
+{
+    uint64_t counts[GAP_BUCKETS];
+    stream.gap_histogram(counts);
+
+    out << "{\"samples\": " << stream.get_samples() << ", \"rate_hz\": " << stream.rate_hz()
+        << ", \"median_period_ms\": " << stream.median_period_ns() / 1e6
+        << ", \"max_gap_ms\": " << stream.max_gap_ns() / 1e6 << ", \"duplicates\": " << stream.get_duplicates()
+        << ", \"out_of_order\": " << stream.get_out_of_order() << ", \"gap_histogram\": [";
+    for (int i = 0; i < GAP_BUCKETS; ++i)
+        out << (i ? ", " : "") << counts[i];
+    out << "]}";
+}
+
+static void write_timeline_json(std::ostream &out, const SensorTimeline &timeline)
+{
+    out << "{\"imu\": ";
+    write_stream_json(out, timeline.imu);
+    out << ", \"barometer\": ";
+    write_stream_json(out, timeline.barometer);
+    out << ", \"magnetometer\": ";
+    write_stream_json(out, timeline.magnetometer);
+    out << ", \"image_imu_offset_ms\": " << timeline.image_imu.mean_offset_ns() / 1e6
+        << ", \"image_imu_drift_us_per_s\": " << timeline.image_imu.drift_ns_per_s() / 1e3
+        << ", \"vio_ready\": " << (timeline.vio_ready() ? "true" : "false") << "}";
+}
+
+#endif
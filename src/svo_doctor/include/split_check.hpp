@@ -0,0 +1,67 @@
+#ifndef __DOCTOR_SPLIT_CHECK__
+#define __DOCTOR_SPLIT_CHECK__
+
+#include <doctor.hpp>
+#include <segment_runner.hpp>
+
+// Segment worker of check_recording_split. Depth quality is measured inline since the
+// segments already provide the parallelism, stability pairs stop at segment borders.
+struct SplitCheckWorker
+{
+    CheckOptions options;
+    float to_meters = 1.f;
+    sl::Mat image;
+    sl::Mat depth[2];
+    int current = 0;
+    bool has_previous = false;
+    DepthQuality quality;
+
+    bool process(FrameSource &source, int frame, sl::ERROR_CODE err, FrameCheck &check)
+    {
+        check_frame(&source, err, options, image, check);
+        if (err != sl::ERROR_CODE::SUCCESS || !options.check_depth)
+            return true;
+
+        if (source.retrieve_measure(depth[current], sl::MEASURE::DEPTH) != sl::ERROR_CODE::SUCCESS)
+        {
+            has_previous = false;
+            return true;
+        }
+
+        check.flags |= FRAME_DEPTH_OK;
+        analyse_depth(depth[current], has_previous ? &depth[1 - current] : nullptr, to_meters, quality);
+        has_previous = true;
+        current = 1 - current;
+        return true;
+    }
+};
+
+// FULL and STRIDE checks of one recording over `segments` sources opened with `open`,
+// each reading its own frame range. The per frame checks are folded back in frame
+// order, so timestamp gaps across segment borders are still detected.
+static void check_recording_split(FrameSource *source, const SegmentRunner<SplitCheckWorker, FrameCheck>::Opener &open,
+                                  FileReport &report, const CheckOptions &options, int segments,
+                                  std::ostream *progress = nullptr)
+{
+    begin_report(source, report, options);
+    int stride = check_stride(options);
+    double period_ns = source->get_fps() > 0.f ? stride * 1e9 / source->get_fps() : 0.0;
+
+    SplitCheckWorker prototype;
+    prototype.options = options;
+    prototype.to_meters = 1.f / meters_to_unit(source->get_unit());
+    sl::RuntimeParameters rt_params;
+    rt_params.enable_depth = options.check_depth;
+
+    SegmentRunner<SplitCheckWorker, FrameCheck> runner(open, segments, prototype, rt_params, stride);
+    runner.run(0, std::max(0, report.frames_total), progress);
+
+    uint64_t last_timestamp = 0;
+    for (const FrameCheck &check : runner.get_results())
+        add_frame_check(report, check, period_ns, last_timestamp);
+    for (SplitCheckWorker &worker : runner.get_workers())
+        report.depth_quality.merge(worker.quality);
+    report.seconds = runner.get_seconds();
+}
+
+#endif
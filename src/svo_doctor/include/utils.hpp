@@ -2,21 +2,37 @@
 #define __VID_UTILS__
 
 #include <sl/Camera.hpp>
-static std::unique_ptr<sl::Camera> open_svo_file(const std::string& filename)
+#include <sources.hpp>
+#include <doctor.hpp>
+
+// Recordings can be replayed from an SVO, a raw frame dump or the synthetic
+// generator, which then produces a clip of SYNTHETIC_CLIP_FRAMES frames.
+#define SYNTHETIC_CLIP_FRAMES 900
+
+// Depth computation is disabled in the SDK when depth is not going to be retrieved
+static std::unique_ptr<FrameSource> open_recording(const std::string &source, const std::string &filename,
+                                                   bool with_depth = true)
 {
-    sl::String input_path(filename.c_str());
     sl::InitParameters params;
-    params.input.setFromSVOFile(input_path);
-    
-    auto zed_camera = std::make_unique<sl::Camera>();
-    auto err = zed_camera->open(params);
-
-    if (err != sl::ERROR_CODE::SUCCESS)
-    {
-        throw err;
-    }
+    if (!with_depth)
+        params.depth_mode = sl::DEPTH_MODE::NONE;
+    return open_frame_source(source, filename, params, SYNTHETIC_CLIP_FRAMES);
+}
 
-    return zed_camera;
+static CheckOptions get_check_options(const std::string &mode, int seconds, int stride, const std::string &checks,
+                                      int depth_workers)
+{
+    CheckOptions options;
+    if (mode.compare("full") == 0)
+        options.mode = CheckMode::FULL;
+    else if (mode.compare("stride") == 0)
+        options.mode = CheckMode::STRIDE;
+    options.seconds = seconds;
+    options.stride = stride;
+    options.check_image = checks.compare("image") == 0 || checks.compare("all") == 0;
+    options.check_depth = checks.compare("depth") == 0 || checks.compare("all") == 0;
+    options.depth_workers = depth_workers;
+    return options;
 }
 
 #endif
\ No newline at end of file
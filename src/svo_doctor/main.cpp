@@ -1,5 +1,7 @@
 #include <iostream>
 #include <utils.hpp>
+#include <batch.hpp>
+#include <split_check.hpp>
 #include <arg_sparser.hpp>
 #include <chrono>
 
@@ -18,11 +20,31 @@ int main(int argc, char *argv[])
     }
 
     std::string filename = parser.get_filename();
-    std::unique_ptr<sl::Camera> zed_camera;
+    std::string source_s = parser.get_source();
+    CheckOptions options = get_check_options(parser.get_mode(), parser.get_seconds(), parser.get_stride(),
+                                             parser.get_checks(), parser.get_depth_workers());
+
+    std::vector<std::string> files = expand_inputs(filename, source_s);
+    if (files.size() != 1 || files.front().compare(filename) != 0)
+    {
+        if (files.empty())
+        {
+            std::cerr << "No recordings found in " << filename << std::endl;
+            return 1;
+        }
+
+        int workers = std::min(parser.get_workers(), (int)files.size());
+        std::cout << "Checking " << files.size() << " recordings with " << workers << " workers..." << std::endl;
+        BatchDoctor doctor(files, source_s, workers, parser.get_report_dir(), options);
+        doctor.run();
+        return doctor.summarize(std::cout) > 0 ? 1 : 0;
+    }
+
+    std::unique_ptr<FrameSource> source;
 
     try
     {
-        zed_camera = open_svo_file(filename);
+        source = open_recording(source_s, filename, options.check_depth);
     }
     catch (const sl::ERROR_CODE &err)
     {
@@ -30,78 +52,38 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    sl::Mat image, depth;
-    sl::SensorsData data;
-    bool sensor_ok = true;
-
-    int n_frames = 0;
-    int frame_drop_count = 0;
-    int imu_count = 0;
-    int bar_count = 0;
-    int mag_count = 0;
-    int depth_count = 0;
-
-    auto start = std::chrono::high_resolution_clock::now();
-    auto end = std::chrono::high_resolution_clock::now();
+    FileReport report;
+    report.filename = filename;
+    report.opened = true;
 
     std::cout << "Checking " << filename << " status..." << std::endl;
-    while (std::chrono::duration_cast<std::chrono::seconds>(end - start).count() < 15)
+    int segments = parser.get_segments();
+    if (segments > 1 && options.mode != CheckMode::WINDOW && source->get_frame_count() > 0)
     {
-        auto err = zed_camera->grab();
-
-        if (err == sl::ERROR_CODE::SUCCESS)
+        try
         {
-            auto err_frame = zed_camera->retrieveImage(image, sl::VIEW::SIDE_BY_SIDE);
-            if (err_frame != sl::ERROR_CODE::SUCCESS)
-                frame_drop_count++;
-
-            auto measure_err = zed_camera->getSensorsData(data, sl::TIME_REFERENCE::IMAGE);
-            if (sensor_ok == true)
-            {
-                if (measure_err != sl::ERROR_CODE::SUCCESS)
-                    sensor_ok = false;
-
-                float norm = data.imu.pose.getTranslation().norm();
-                if (norm > std::abs(0.05))
-                    imu_count++;
-
-                float pressure = data.barometer.pressure;
-                if (pressure > std::abs(0.05))
-                    bar_count++;
-
-                float mag_data = data.magnetometer.magnetic_field_calibrated.norm();
-                if (mag_data > std::abs(0.05))
-                    mag_count++;
-            }
-
-            auto depth_err = zed_camera->retrieveMeasure(depth);
-            if (depth_err == sl::ERROR_CODE::SUCCESS)
-                depth_count++;
+            check_recording_split(
+                source.get(), [&]() { return open_recording(source_s, filename, options.check_depth); }, report,
+                options, segments, &std::cout);
         }
-        else if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+        catch (const sl::ERROR_CODE &err)
         {
-            break;
+            std::cerr << "Could not open svo file: " << err << std::endl;
+            return 1;
         }
-        else
+        catch (const std::exception &e)
         {
-            frame_drop_count++;
+            std::cerr << "Check failed: " << e.what() << std::endl;
+            return 1;
         }
-
-        n_frames++;
-        end = std::chrono::high_resolution_clock::now();
     }
-
-    std::cout << "Frames processed: " << n_frames << std::endl;
-    if (sensor_ok)
+    else
     {
-        std::cout << "Sensor status: OK" << std::endl;
-        std::cout << "Invalid frame count: " << frame_drop_count << std::endl;
-        std::cout << "IMU non zero measurements: " << imu_count << "/" << n_frames << std::endl;
-        std::cout << "Barometer non zero measurements: " << bar_count << "/" << n_frames << std::endl;
-        std::cout << "Magnetometer non zero measurements: " << mag_count << "/" << n_frames << std::endl;
+        if (segments > 1)
+            std::cout << "-split needs -mode full or stride on a recording of known length, checking sequentially"
+                      << std::endl;
+        check_recording(source.get(), report, options, &std::cout);
     }
-    else
-        std::cout << "Sensor status: Unavailable" << std::endl;
-
-    std::cout << "Depth successful computations: " << depth_count << "/" << n_frames << std::endl;
-}
\ No newline at end of file
+    check_sensor_log(report);
+    print_report(std::cout, report);
+}
@@ -0,0 +1,129 @@
+#include <test_check.hpp>
+#include <depth_codec.hpp>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Odd sizes so the SIMD loops leave a scalar tail on every row
+#define CODEC_TEST_WIDTH 75
+#define CODEC_TEST_HEIGHT 19
+
+// A tilted plane with noise and steps, holes of every invalid class in runs and alone,
+// including a fully invalid row and rows starting and ending invalid
+static std::vector<float> make_depth(int width, int height, float mm_to_unit)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> noise(-40.f, 40.f);
+    std::vector<float> depth((size_t)width * height);
+    for (int row = 0; row < height; ++row)
+    {
+        for (int col = 0; col < width; ++col)
+        {
+            float mm = 800.f + 31.f * col + 17.f * row + noise(random);
+            if (col > width / 2)
+                mm += 2500.f;
+            depth[(size_t)row * width + col] = mm * mm_to_unit;
+        }
+    }
+
+    float *data = depth.data();
+    for (int col = 0; col < width; ++col)
+        data[3 * width + col] = nan;
+    for (int col = 10; col < 30; ++col)
+        data[5 * width + col] = inf;
+    for (int col = 0; col < 9; ++col)
+        data[7 * width + col] = -inf;
+    for (int col = width - 6; col < width; ++col)
+        data[8 * width + col] = nan;
+    data[11 * width + 4] = nan;
+    data[11 * width + 5] = inf;
+    data[11 * width + 6] = -inf;
+    data[11 * width + 7] = nan;
+    data[(size_t)(height - 1) * width + width - 1] = inf;
+    return depth;
+}
+
+static std::vector<SimdLevel> levels_to_test()
+{
+    std::vector<SimdLevel> levels{SimdLevel::SCALAR};
+    SimdLevel detected = detect_simd_level();
+    if (detected == SimdLevel::SSE41 || detected == SimdLevel::AVX2)
+        levels.push_back(SimdLevel::SSE41);
+    if (detected == SimdLevel::AVX2 || detected == SimdLevel::NEON)
+        levels.push_back(detected);
+    return levels;
+}
+
+// Encodes and decodes with every SIMD level: invalid pixels keep their class, finite
+// depth is within half a step and every level decodes the same bits as the scalar one
+static void check_round_trip(float max_error_mm, float unit_to_mm)
+{
+    const int width = CODEC_TEST_WIDTH, height = CODEC_TEST_HEIGHT;
+    std::vector<float> depth = make_depth(width, height, 1.f / unit_to_mm);
+
+    DepthEncoder encoder(max_error_mm);
+    std::vector<uint8_t> record = encoder.encode(depth.data(), width * sizeof(float), width, height, unit_to_mm);
+    CHECK(record.size() > sizeof(DepthCodecHeader));
+    // Depth on a step boundary may round either way, the unit scaling adds a few ulps
+    float half_step = encoder.get_step_mm() / 2.f / unit_to_mm;
+    const float ulp = std::numeric_limits<float>::epsilon();
+
+    std::vector<float> scalar;
+    for (SimdLevel level : levels_to_test())
+    {
+        // Padded rows check the stride is honoured
+        const int stride = width + 5;
+        std::vector<float> decoded((size_t)stride * height, 0.f);
+        DepthDecoder decoder(level);
+        CHECK(decoder.decode(record.data(), record.size(), decoded.data(), stride * sizeof(float), width, height));
+
+        std::vector<float> packed((size_t)width * height);
+        for (int row = 0; row < height; ++row)
+            std::memcpy(&packed[(size_t)row * width], &decoded[(size_t)row * stride], width * sizeof(float));
+
+        for (size_t i = 0; i < depth.size(); ++i)
+        {
+            float in = depth[i], out = packed[i];
+            if (std::isnan(in))
+                CHECK(std::isnan(out));
+            else if (std::isinf(in))
+                CHECK(std::isinf(out) && (out > 0.f) == (in > 0.f));
+            else
+                CHECK(std::isfinite(out) && std::fabs(out - in) <= half_step + 4.f * ulp * std::fabs(in));
+        }
+
+        if (level == SimdLevel::SCALAR)
+            scalar = packed;
+        else
+            CHECK(std::memcmp(scalar.data(), packed.data(), packed.size() * sizeof(float)) == 0);
+    }
+}
+
+// Truncated or foreign records are rejected instead of decoding garbage
+static void check_corrupt_records()
+{
+    const int width = CODEC_TEST_WIDTH, height = CODEC_TEST_HEIGHT;
+    std::vector<float> depth = make_depth(width, height, 1.f);
+    DepthEncoder encoder;
+    std::vector<uint8_t> record = encoder.encode(depth.data(), width * sizeof(float), width, height, 1.f);
+    std::vector<float> decoded((size_t)width * height);
+    DepthDecoder decoder;
+
+    CHECK(!decoder.decode(record.data(), record.size() / 2, decoded.data(), width * sizeof(float), width, height));
+    CHECK(!decoder.decode(record.data(), record.size(), decoded.data(), width * sizeof(float), width - 1, height));
+    CHECK(!decoder.decode(nullptr, 0, decoded.data(), width * sizeof(float), width, height));
+}
+
+int main()
+{
+    check_round_trip(0.f, 1.f);
+    check_round_trip(2.5f, 1.f);
+    check_round_trip(0.f, 1000.f);
+    check_round_trip(10.f, 10.f);
+    check_corrupt_records();
+    return test_result("depth_codec");
+}
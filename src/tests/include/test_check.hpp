@@ -0,0 +1,29 @@
+#ifndef __TESTS_CHECK__
+#define __TESTS_CHECK__
+
+#include <iostream>
+
+// Every test is its own executable run by ctest: CHECK reports a failed condition with
+// its location and keeps going, main returns test_result() so ctest sees the failure.
+static int test_failures = 0;
+
+#define CHECK(condition)                                                                                       \
+    do                                                                                                         \
+    {                                                                                                          \
+        if (!(condition))                                                                                      \
+        {                                                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl;         \
+            test_failures++;                                                                                   \
+        }                                                                                                      \
+    } while (0)
+
+static inline int test_result(const char *name)
+{
+    if (test_failures > 0)
+        std::cerr << name << ": " << test_failures << " check(s) failed" << std::endl;
+    else
+        std::cout << name << ": passed" << std::endl;
+    return test_failures > 0 ? 1 : 0;
+}
+
+#endif
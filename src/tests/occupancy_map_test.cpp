@@ -0,0 +1,87 @@
+#include <test_check.hpp>
+#include <occupancy_map.hpp>
+#include <vector>
+
+#define OCCUPANCY_TEST_WIDTH 64
+#define OCCUPANCY_TEST_HEIGHT 8
+
+// Wall 1000 units away filling a 64x8 image, about 16 blocks of 10 unit voxels
+static void integrate_wall(OccupancyMap &map)
+{
+    std::vector<float> depth(OCCUPANCY_TEST_WIDTH * OCCUPANCY_TEST_HEIGHT, 1000.f);
+    CameraIntrinsics camera;
+    camera.fx = 128.f;
+    camera.fy = 128.f;
+    camera.cx = 32.f;
+    camera.cy = 4.f;
+    camera.width = OCCUPANCY_TEST_WIDTH;
+    camera.height = OCCUPANCY_TEST_HEIGHT;
+    map.integrate(depth.data(), OCCUPANCY_TEST_WIDTH * sizeof(float), OCCUPANCY_TEST_WIDTH, OCCUPANCY_TEST_HEIGHT,
+                  camera);
+}
+
+// A static scene larger than the pool: the blocks hit first each frame must stay, the
+// rest of the points are dropped. Recycling a block already hit by the same frame
+// would lose its hits and evict blocks frame after frame.
+static void check_full_pool()
+{
+    OccupancyMap small(10.f, 4, 1);
+    OccupancyMap large(10.f, 1024, 1);
+    // The four blocks of the first row, left of the optical axis and above it
+    OccupancyBox kept{{-320.f, -80.f, 960.f}, {-0.5f, -0.5f, 1039.f}};
+
+    uint32_t occupied = 0;
+    for (int frame = 0; frame < 6; ++frame)
+    {
+        integrate_wall(small);
+        integrate_wall(large);
+        CHECK(small.get_block_count() == 4);
+        CHECK(small.get_evicted() == 0);
+        if (frame == 2)
+            occupied = small.count_occupied(kept);
+    }
+
+    CHECK(small.get_dropped_points() > 0);
+    CHECK(large.get_dropped_points() == 0);
+    CHECK(large.get_block_count() > 4);
+    CHECK(occupied > 0);
+    CHECK(small.count_occupied(kept) == occupied);
+    CHECK(small.count_occupied(kept) == large.count_occupied(kept));
+}
+
+// Blocks are recycled least recently updated first once the view moves away
+static void check_eviction()
+{
+    OccupancyMap map(10.f, 4, 1);
+    std::vector<float> depth(OCCUPANCY_TEST_WIDTH * OCCUPANCY_TEST_HEIGHT);
+    CameraIntrinsics camera;
+    camera.fx = 128.f;
+    camera.fy = 128.f;
+    camera.cx = 4.f;
+    camera.cy = 4.f;
+    camera.width = OCCUPANCY_TEST_WIDTH;
+    camera.height = OCCUPANCY_TEST_HEIGHT;
+
+    // Only the 8x8 top left pixels carry depth, first near then far
+    for (float distance : {500.f, 500.f, 2000.f, 2000.f})
+    {
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::quiet_NaN());
+        for (int row = 0; row < OCCUPANCY_TEST_HEIGHT; ++row)
+            for (int col = 0; col < 8; ++col)
+                depth[row * OCCUPANCY_TEST_WIDTH + col] = distance;
+        map.integrate(depth.data(), OCCUPANCY_TEST_WIDTH * sizeof(float), OCCUPANCY_TEST_WIDTH,
+                      OCCUPANCY_TEST_HEIGHT, camera);
+    }
+
+    OccupancyBox far{{-100.f, -100.f, 1900.f}, {100.f, 100.f, 2100.f}};
+    CHECK(map.get_evicted() > 0);
+    CHECK(map.get_block_count() <= 4);
+    CHECK(map.count_occupied(far) > 0);
+}
+
+int main()
+{
+    check_full_pool();
+    check_eviction();
+    return test_result("occupancy_map");
+}
@@ -0,0 +1,105 @@
+#include <test_check.hpp>
+#include <point_cloud.hpp>
+#include <cmath>
+#include <vector>
+
+static bool near(float a, float b)
+{
+    return std::fabs(a - b) <= 1e-4f * std::max(1.f, std::fabs(b));
+}
+
+static bool near(const Point3 &p, float x, float y, float z)
+{
+    return near(p.x, x) && near(p.y, y) && near(p.z, z);
+}
+
+// Centroids per cell in first hit order, negative coordinates round down
+static void check_centroids()
+{
+    VoxelGrid grid(1.f);
+    std::vector<Point3> points;
+
+    grid.begin();
+    grid.add(0.2f, 0.2f, 2.2f);
+    grid.add(0.8f, 0.4f, 2.6f);
+    grid.add(-0.5f, 0.5f, 2.5f);
+    grid.add(0.6f, 0.9f, 2.1f);
+    grid.add(-0.1f, 0.3f, 2.9f);
+    grid.add(5.5f, -3.5f, 10.5f);
+    grid.finish(points);
+
+    CHECK(points.size() == 3);
+    if (points.size() == 3)
+    {
+        CHECK(near(points[0], 1.6f / 3.f, 1.5f / 3.f, 6.9f / 3.f));
+        CHECK(near(points[1], -0.3f, 0.4f, 2.7f));
+        CHECK(near(points[2], 5.5f, -3.5f, 10.5f));
+    }
+
+    // A new frame starts empty, cells of the previous one are not carried over
+    grid.begin();
+    grid.add(0.5f, 0.5f, 2.5f);
+    grid.finish(points);
+    CHECK(points.size() == 1);
+    if (points.size() == 1)
+        CHECK(near(points[0], 0.5f, 0.5f, 2.5f));
+}
+
+// Enough cells to grow the table several times within one frame, points of a cell
+// alternate with the others so sums must survive every resize
+static void check_growth()
+{
+    const int side = 64;
+    const float leaf = 0.25f;
+    VoxelGrid grid(leaf);
+    std::vector<Point3> points;
+
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        grid.begin();
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (int i = 0; i < side * side * 24; ++i)
+            {
+                float x = (i % side) * leaf, y = (i / side % side) * leaf, z = (i / (side * side)) * leaf;
+                float offset = pass == 0 ? 0.05f : 0.15f;
+                grid.add(x + offset, y + offset, z + offset);
+            }
+        }
+        grid.finish(points);
+
+        CHECK(points.size() == (size_t)side * side * 24);
+        bool all_near = true;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            float x = (i % side) * leaf, y = (i / side % side) * leaf, z = (i / (side * side)) * leaf;
+            all_near = all_near && near(points[i], x + 0.1f, y + 0.1f, z + 0.1f);
+        }
+        CHECK(all_near);
+    }
+}
+
+// Single points are kept as they are
+static void check_single_points()
+{
+    VoxelGrid grid(0.01f);
+    std::vector<Point3> points;
+    grid.begin();
+    grid.add(1.2345f, -2.5f, 3.f);
+    grid.add(-7.f, 0.f, 0.005f);
+    grid.finish(points);
+    CHECK(points.size() == 2);
+    if (points.size() == 2)
+    {
+        CHECK(near(points[0], 1.2345f, -2.5f, 3.f));
+        CHECK(near(points[1], -7.f, 0.f, 0.005f));
+    }
+}
+
+int main()
+{
+    check_centroids();
+    check_growth();
+    check_single_points();
+    return test_result("voxel_grid");
+}
@@ -11,6 +11,7 @@ using ArgBoolMap = std::map<std::string, bool>;
 using ValidRes = std::vector<std::string>;
 using ValidFps = std::map<std::string, std::vector<int>>;
 using ArgStringMap = std::map<std::string, std::string>;
+using ValidSource = std::vector<std::string>;
 
 class ArgParser
 {
@@ -18,8 +19,30 @@ class ArgParser
 public:
     ArgParser()
     {
+        bool_map.insert(std::make_pair(std::string("-imu"), false));
+
         string_map.insert(std::make_pair(std::string("-r"), std::string("1080p")));
         string_map.insert(std::make_pair(std::string("-f"), std::string("30")));
+        string_map.insert(std::make_pair(std::string("-src"), std::string("camera")));
+        string_map.insert(std::make_pair(std::string("-i"), std::string("")));
+        string_map.insert(std::make_pair(std::string("-stats"), std::string("10")));
+        string_map.insert(std::make_pair(std::string("-seg-minutes"), std::string("0")));
+        string_map.insert(std::make_pair(std::string("-seg-mb"), std::string("0")));
+        string_map.insert(std::make_pair(std::string("-trigger"), std::string("off")));
+        string_map.insert(std::make_pair(std::string("-pre"), std::string("3")));
+        string_map.insert(std::make_pair(std::string("-post"), std::string("5")));
+        string_map.insert(std::make_pair(std::string("-motion-th"), std::string("2")));
+        string_map.insert(std::make_pair(std::string("-depth-th"), std::string("1.0")));
+
+        valid_trigger.push_back("off");
+        valid_trigger.push_back("motion");
+        valid_trigger.push_back("depth");
+        valid_trigger.push_back("signal");
+
+        valid_source.push_back("camera");
+        valid_source.push_back("svo");
+        valid_source.push_back("synthetic");
+        valid_source.push_back("raw");
 
         valid_res.push_back("wvga");
         valid_res.push_back("720p");
@@ -92,6 +115,11 @@ public:
         }
     }
 
+    // Full rate sensor log next to the recording
+    bool get_imu_logging()
+    {
+        return bool_map.at("-imu");
+    }
     std::string get_fps_value()
     {
         return string_map.at("-f");
@@ -100,12 +128,60 @@ public:
     {
         return string_map.at("-r");
     }
+    std::string get_source()
+    {
+        return string_map.at("-src");
+    }
+    std::string get_input_file()
+    {
+        return string_map.at("-i");
+    }
+    // Seconds between periodic capture reports, 0 disables them
+    int get_stats_interval()
+    {
+        return std::stoi(string_map.at("-stats"));
+    }
+    // Segment limits, 0 leaves the recording in one file
+    int get_segment_minutes()
+    {
+        return std::stoi(string_map.at("-seg-minutes"));
+    }
+    int get_segment_megabytes()
+    {
+        return std::stoi(string_map.at("-seg-mb"));
+    }
+    // Event mode: off, motion, depth or signal. SIGUSR1 or T on stdin fire a trigger
+    // in every event mode.
+    std::string get_trigger()
+    {
+        return string_map.at("-trigger");
+    }
+    int get_pre_seconds()
+    {
+        return std::stoi(string_map.at("-pre"));
+    }
+    int get_post_seconds()
+    {
+        return std::stoi(string_map.at("-post"));
+    }
+    // Percentage of the motion grid that must change
+    float get_motion_threshold()
+    {
+        return std::stof(string_map.at("-motion-th"));
+    }
+    // Meters, triggers while the center of the frame is closer
+    float get_depth_threshold()
+    {
+        return std::stof(string_map.at("-depth-th"));
+    }
 
 private:
     ArgBoolMap bool_map;
     ArgStringMap string_map;
     ValidRes valid_res;
     ValidFps valid_fps;
+    ValidSource valid_source;
+    ValidSource valid_trigger;
 
     bool check_keyword(const std::string &key, const std::string &value)
     {
@@ -117,6 +193,27 @@ private:
         {
             return check_framerate(key, value);
         }
+        else if (key.compare("-src") == 0)
+        {
+            return std::find(valid_source.begin(), valid_source.end(), value) != valid_source.end();
+        }
+        else if (key.compare("-i") == 0)
+        {
+            return !value.empty();
+        }
+        else if (key.compare("-stats") == 0 || key.compare("-seg-minutes") == 0 || key.compare("-seg-mb") == 0 ||
+                 key.compare("-pre") == 0 || key.compare("-post") == 0)
+        {
+            return is_number(value) && value.size() < 6;
+        }
+        else if (key.compare("-trigger") == 0)
+        {
+            return std::find(valid_trigger.begin(), valid_trigger.end(), value) != valid_trigger.end();
+        }
+        else if (key.compare("-motion-th") == 0 || key.compare("-depth-th") == 0)
+        {
+            return is_decimal(value);
+        }
         return false;
     }
 
@@ -152,6 +249,14 @@ private:
                                           { return !std::isdigit(c); }) == s.end();
     }
 
+    bool is_decimal(const std::string &s)
+    {
+        size_t dot = s.find('.');
+        if (dot == std::string::npos)
+            return is_number(s);
+        return (dot == 0 || is_number(s.substr(0, dot))) && is_number(s.substr(dot + 1));
+    }
+
     void bad_option(const std::string &option)
     {
         std::string message = "Unrecognize option: " + option;
@@ -0,0 +1,161 @@
+#ifndef __VID_CAPTURE_STATS__
+#define __VID_CAPTURE_STATS__
+
+#include <sl/Camera.hpp>
+#include <latency_histogram.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <initializer_list>
+#include <iomanip>
+#include <ostream>
+
+// A frame counts as a gap when it arrives more than this many periods after the previous one
+#define CAPTURE_GAP_TOLERANCE 1.5
+
+// Health of a recording: grab latency distribution, failed grabs and frames missing from
+// the timestamp sequence. Only the record loop touches it, so nothing is synchronized.
+// Interval counters restart after each periodic report, totals cover the whole recording.
+class CaptureStats
+{
+public:
+    CaptureStats(float fps)
+        : period_ns(fps > 0.f ? 1e9 / fps : 0.0), started(std::chrono::steady_clock::now()),
+          interval_started(started)
+    {
+    }
+
+    void record_grab(sl::ERROR_CODE err, uint64_t latency_ns, uint64_t timestamp_ns, float current_fps)
+    {
+        total.latency.record(latency_ns);
+        interval.latency.record(latency_ns);
+
+        if (err != sl::ERROR_CODE::SUCCESS)
+        {
+            total.failed++;
+            interval.failed++;
+            last_error = err;
+            return;
+        }
+
+        total.frames++;
+        interval.frames++;
+        if (current_fps > 0.f)
+        {
+            interval.min_fps = interval.min_fps > 0.f ? std::min(interval.min_fps, current_fps) : current_fps;
+            total.min_fps = total.min_fps > 0.f ? std::min(total.min_fps, current_fps) : current_fps;
+            last_fps = current_fps;
+        }
+
+        if (last_timestamp_ns != 0)
+            check_timestamp(timestamp_ns);
+        last_timestamp_ns = timestamp_ns;
+    }
+
+    bool interval_elapsed(std::chrono::seconds period) const
+    {
+        return period.count() > 0 && std::chrono::steady_clock::now() - interval_started >= period;
+    }
+
+    void report_interval(std::ostream &out)
+    {
+        auto now = std::chrono::steady_clock::now();
+        out << std::endl << "[capture] last " << (int)std::lround(seconds_since(interval_started, now)) << " s: ";
+        print_counters(out, interval, seconds_since(interval_started, now));
+
+        interval = Counters();
+        interval_started = now;
+    }
+
+    void report(std::ostream &out)
+    {
+        double elapsed = seconds_since(started, std::chrono::steady_clock::now());
+        out << "Capture statistics (" << (int)std::lround(elapsed) << " s):" << std::endl << "  ";
+        print_counters(out, total, elapsed);
+        if (total.failed > 0)
+            out << "  last grab error: " << last_error << std::endl;
+        if (total.gaps > 0)
+            out << "  largest gap: " << to_ms(total.largest_gap_ns) << " ms" << std::endl;
+        if (total.backwards > 0)
+            out << "  non increasing timestamps: " << total.backwards << std::endl;
+        out << "  last reported fps: " << last_fps << std::endl;
+    }
+
+    uint64_t get_dropped() const
+    {
+        return total.dropped;
+    }
+
+private:
+    struct Counters
+    {
+        LatencyHistogram latency;
+        uint64_t frames = 0;
+        uint64_t failed = 0;
+        uint64_t gaps = 0;
+        uint64_t dropped = 0;
+        uint64_t backwards = 0;
+        uint64_t largest_gap_ns = 0;
+        float min_fps = 0.f;
+    };
+
+    double period_ns;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point interval_started;
+    Counters total;
+    Counters interval;
+    uint64_t last_timestamp_ns = 0;
+    float last_fps = 0.f;
+    sl::ERROR_CODE last_error = sl::ERROR_CODE::SUCCESS;
+
+    void check_timestamp(uint64_t timestamp_ns)
+    {
+        if (timestamp_ns <= last_timestamp_ns)
+        {
+            total.backwards++;
+            interval.backwards++;
+            return;
+        }
+
+        uint64_t delta = timestamp_ns - last_timestamp_ns;
+        if (period_ns <= 0.0 || delta <= CAPTURE_GAP_TOLERANCE * period_ns)
+            return;
+
+        uint64_t missing = (uint64_t)std::llround(delta / period_ns) - 1;
+        for (Counters *counters : {&total, &interval})
+        {
+            counters->gaps++;
+            counters->dropped += std::max<uint64_t>(missing, 1);
+            counters->largest_gap_ns = std::max(counters->largest_gap_ns, delta);
+        }
+    }
+
+    static double seconds_since(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+    static void print_counters(std::ostream &out, const Counters &counters, double elapsed)
+    {
+        uint64_t expected = counters.frames + counters.dropped;
+        double drop_rate = expected > 0 ? 100.0 * counters.dropped / expected : 0.0;
+        std::streamsize precision = out.precision();
+
+        out << std::fixed << std::setprecision(1)
+            << counters.frames << " frames (" << (elapsed > 0.0 ? counters.frames / elapsed : 0.0) << " fps, min reported "
+            << counters.min_fps << "), " << counters.dropped << " dropped in " << counters.gaps << " gaps ("
+            << std::setprecision(2) << drop_rate << "%), " << counters.failed << " failed grabs" << std::endl
+            << "  grab latency ms: p50 " << to_ms(counters.latency.percentile(0.5))
+            << " p90 " << to_ms(counters.latency.percentile(0.9))
+            << " p99 " << to_ms(counters.latency.percentile(0.99))
+            << " max " << to_ms(counters.latency.get_max()) << std::defaultfloat << std::setprecision(precision)
+            << std::endl;
+    }
+
+    static double to_ms(uint64_t ns)
+    {
+        return ns / 1e6;
+    }
+};
+
+#endif
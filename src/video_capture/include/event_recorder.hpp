@@ -0,0 +1,341 @@
+#ifndef __VID_EVENT_RECORDER__
+#define __VID_EVENT_RECORDER__
+
+#include <frame_source.hpp>
+#include <depth_stats.hpp>
+#include <spsc_queue.hpp>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define MOTION_GRID_WIDTH 64
+#define MOTION_PIXEL_DELTA 25
+
+// Queue marker closing the current clip, slot indices are >= 0
+#define EVENT_CLIP_END -1
+
+enum class EventTrigger
+{
+    MOTION,
+    DEPTH,
+    SIGNAL
+};
+
+static EventTrigger string2trigger(const std::string &trigger)
+{
+    if (trigger.compare("motion") == 0)
+        return EventTrigger::MOTION;
+    if (trigger.compare("depth") == 0)
+        return EventTrigger::DEPTH;
+    return EventTrigger::SIGNAL;
+}
+
+struct EventOptions
+{
+    EventTrigger trigger;
+    int pre_seconds;
+    int post_seconds;
+    float motion_percent;
+    float depth_meters;
+};
+
+// Frame differencing on a downscaled luma grid. Each cell averages a sparse sample of
+// its pixels; motion is reported when more than `percent` of the cells changed.
+class MotionDetector
+{
+public:
+    bool update(sl::Mat &image, float percent)
+    {
+        int width = (int)image.getWidth();
+        int height = (int)image.getHeight();
+        int cell = std::max(1, width / MOTION_GRID_WIDTH);
+        int cols = width / cell;
+        int rows = height / cell;
+        if (current.size() != (size_t)(cols * rows))
+        {
+            current.assign(cols * rows, 0);
+            previous.clear();
+        }
+
+        TypedView<const sl::uchar4> view(image);
+        int sample = std::max(1, cell / 4);
+        for (int r = 0; r < rows; ++r)
+        {
+            for (int c = 0; c < cols; ++c)
+            {
+                int sum = 0, count = 0;
+                for (int y = r * cell; y < (r + 1) * cell; y += sample)
+                {
+                    const sl::uchar4 *row = view.row(y);
+                    for (int x = c * cell; x < (c + 1) * cell; x += sample)
+                    {
+                        sum += (row[x].x + 2 * row[x].y + row[x].z) >> 2;
+                        count++;
+                    }
+                }
+                current[r * cols + c] = (unsigned char)(sum / count);
+            }
+        }
+
+        bool motion = false;
+        if (previous.size() == current.size())
+        {
+            int changed = 0;
+            for (size_t i = 0; i < current.size(); ++i)
+                changed += std::abs(current[i] - previous[i]) > MOTION_PIXEL_DELTA;
+            motion = 100.f * changed > percent * (float)current.size();
+        }
+        previous.swap(current);
+        current.resize(previous.size());
+        return motion;
+    }
+
+private:
+    std::vector<unsigned char> current;
+    std::vector<unsigned char> previous;
+};
+
+// Keeps the last `pre_seconds` of frames in a preallocated ring and writes a raw clip
+// only around events: the pre-roll is handed to a writer thread when a trigger fires,
+// then every frame until `post_seconds` after the last trigger. The ring has one
+// second of spare slots so capture continues while the pre-roll is flushed; a slot the
+// writer has not released yet is never overwritten, the new frame is dropped instead.
+// Clips are raw dumps because past frames cannot be injected into an SVO.
+class EventRecorder
+{
+public:
+    // The ring is sized from the frames the source actually delivers, not the requested
+    // mode, so an SVO, a raw dump or a camera falling back to another mode never
+    // reallocates a slot on its first frame
+    EventRecorder(FrameSource *source, const std::string &basename, const EventOptions &options)
+        : source(source), basename(basename), options(options),
+          fps(std::max(1, (int)(source->get_fps() + 0.5f))), unit(source->get_unit()),
+          pre_frames(std::max(1, options.pre_seconds * fps)),
+          slots(pre_frames + fps), queue(2 * slots.size())
+    {
+        sl::Resolution size = source->get_resolution();
+        for (auto &slot : slots)
+        {
+            slot.left.alloc(size, sl::MAT_TYPE::U8_C4, sl::MEM::CPU);
+            slot.right.alloc(size, sl::MAT_TYPE::U8_C4, sl::MEM::CPU);
+            if (with_depth())
+                slot.depth.alloc(size, sl::MAT_TYPE::F32_C1, sl::MEM::CPU);
+        }
+    }
+
+    ~EventRecorder()
+    {
+        stop();
+    }
+
+    bool with_depth() const
+    {
+        return options.trigger == EventTrigger::DEPTH;
+    }
+
+    size_t get_ring_bytes() const
+    {
+        size_t pixels = slots.front().left.getWidth() * slots.front().left.getHeight();
+        return slots.size() * pixels * (with_depth() ? 12 : 8);
+    }
+
+    void start()
+    {
+        running = true;
+        writer_thread = std::thread(&EventRecorder::writer_loop, this);
+    }
+
+    void stop()
+    {
+        if (!writer_thread.joinable())
+            return;
+
+        if (active)
+            push(EVENT_CLIP_END);
+        active = false;
+        running = false;
+        writer_thread.join();
+    }
+
+    // Called after every successful grab, `external` carries the out of band trigger
+    void on_frame(bool external)
+    {
+        Slot &slot = slots[next];
+        if (slot.pending.load(std::memory_order_acquire))
+        {
+            dropped++;
+            return;
+        }
+
+        source->get_raw_header(slot.header);
+        source->retrieve_image(slot.left, sl::VIEW::LEFT);
+        source->retrieve_image(slot.right, sl::VIEW::RIGHT);
+        slot.depth_ok = with_depth() && source->retrieve_measure(slot.depth, sl::MEASURE::DEPTH) ==
+                                             sl::ERROR_CODE::SUCCESS;
+
+        bool triggered = external || check_trigger(slot);
+        uint64_t timestamp_ns = slot.header.timestamp_ns;
+
+        if (triggered)
+        {
+            if (!active)
+                begin_clip();
+            post_deadline_ns = timestamp_ns + (uint64_t)options.post_seconds * 1000000000ull;
+        }
+
+        if (active)
+        {
+            slot.pending.store(true, std::memory_order_relaxed);
+            push((int)next);
+            if (!triggered && timestamp_ns >= post_deadline_ns)
+            {
+                push(EVENT_CLIP_END);
+                active = false;
+            }
+        }
+        else
+            buffered = std::min(buffered + 1, pre_frames);
+
+        next = (next + 1) % slots.size();
+    }
+
+    void report(std::ostream &out) const
+    {
+        out << "Events: " << clips << " clips, " << frames_written << " frames written, "
+            << dropped << " frames dropped (writer behind)" << std::endl;
+    }
+
+private:
+    struct Slot
+    {
+        RawFrameHeader header;
+        sl::Mat left;
+        sl::Mat right;
+        sl::Mat depth;
+        bool depth_ok = false;
+        std::atomic<bool> pending{false};
+    };
+
+    FrameSource *source;
+    std::string basename;
+    EventOptions options;
+    int fps;
+    sl::UNIT unit;
+    int pre_frames;
+    std::vector<Slot> slots;
+    SpscQueue<int> queue;
+    MotionDetector motion;
+    std::thread writer_thread;
+    std::atomic<bool> running{false};
+
+    size_t next = 0;
+    int buffered = 0;
+    bool active = false;
+    uint64_t post_deadline_ns = 0;
+    uint64_t clips = 0;
+    uint64_t dropped = 0;
+    std::atomic<uint64_t> frames_written{0};
+
+    bool check_trigger(Slot &slot)
+    {
+        switch (options.trigger)
+        {
+        case EventTrigger::MOTION:
+            return motion.update(slot.left, options.motion_percent);
+        case EventTrigger::DEPTH:
+            return slot.depth_ok && center_closer_than(slot.depth, options.depth_meters * meters_to_unit(unit));
+        default:
+            return false;
+        }
+    }
+
+    // Mean depth of the central quarter of the frame below `threshold`
+    static bool center_closer_than(sl::Mat &depth, float threshold)
+    {
+        TypedView<const float> view(depth);
+        TypedView<const float> center =
+            view.sub(view.width() / 4, view.height() / 4, view.width() / 2, view.height() / 2);
+
+        DepthStats stats = compute_depth_stats(center.data(), center.stride_bytes(), center.width(), center.height());
+        return stats.valid > 0 && stats.mean() < threshold;
+    }
+
+    void begin_clip()
+    {
+        active = true;
+        clips++;
+        for (int i = buffered; i > 0; --i)
+        {
+            size_t index = (next + slots.size() - i) % slots.size();
+            slots[index].pending.store(true, std::memory_order_relaxed);
+            push((int)index);
+        }
+        buffered = 0;
+    }
+
+    void push(int item)
+    {
+        if (!queue.push(item) && item >= 0)
+            slots[item].pending.store(false, std::memory_order_release);
+    }
+
+    std::string clip_name(uint64_t index) const
+    {
+        char suffix[24];
+        std::snprintf(suffix, sizeof(suffix), "_event_%03llu.raw", (unsigned long long)index);
+        return basename + suffix;
+    }
+
+    void writer_loop()
+    {
+        std::unique_ptr<RawFrameWriter> writer;
+        uint64_t clip_index = 0;
+        int item;
+        int idle = 0;
+
+        while (true)
+        {
+            if (!queue.pop(item))
+            {
+                if (!running)
+                    break;
+                if (++idle < 64)
+                    std::this_thread::yield();
+                else
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                continue;
+            }
+            idle = 0;
+
+            if (item == EVENT_CLIP_END)
+            {
+                if (writer)
+                {
+                    std::cout << std::endl << "Event clip " << clip_name(clip_index) << ": "
+                              << writer->get_frames_written() << " frames" << std::endl;
+                    writer->close();
+                    writer.reset();
+                    clip_index++;
+                }
+                continue;
+            }
+
+            if (!writer)
+                writer = std::make_unique<RawFrameWriter>(clip_name(clip_index), (uint32_t)fps, unit);
+
+            Slot &slot = slots[item];
+            sl::Mat *depth = slot.depth_ok ? &slot.depth : nullptr;
+            if (writer->write(slot.header, slot.left, slot.right, depth, with_depth()) == sl::ERROR_CODE::SUCCESS)
+                frames_written++;
+            slot.pending.store(false, std::memory_order_release);
+        }
+    }
+};
+
+#endif
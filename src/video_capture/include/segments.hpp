@@ -0,0 +1,327 @@
+#ifndef __VID_SEGMENTS__
+#define __VID_SEGMENTS__
+
+#include <utils.hpp>
+#include <latency_histogram.hpp>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+// Frames between two file size checks, the size in between is extrapolated
+#define SEGMENT_SIZE_CHECK_FRAMES 30
+
+// Splits a recording into segments named <basename>_<index><extension> once a segment
+// reaches `minutes` of frame time or `megabytes` on disk (0 disables a limit). The
+// switch happens right before the next grab so no frame straddles segments, and each
+// closed segment is appended to <basename>.manifest right away so a crash keeps the
+// listing.
+// A finisher thread keeps the grab thread out of the file system: it creates the next
+// raw segment while the current one records, so the switch is a pointer swap, then
+// closes the previous segment and writes its manifest line. SVO segments are still
+// closed and reopened by the SDK on the grab thread, only the manifest work moves.
+// Without limits the recording is a single <basename><extension> file, as before.
+class SegmentedRecorder
+{
+public:
+    SegmentedRecorder(FrameSource *source, const std::string &basename, const std::string &extension,
+                      int minutes, int megabytes)
+        : source(source), basename(basename), extension(extension),
+          max_duration_ns((uint64_t)minutes * 60 * 1000000000ull),
+          max_bytes((uint64_t)megabytes * 1024 * 1024),
+          frame_period_ns(source->get_fps() > 0.f ? (uint64_t)(1e9 / source->get_fps()) : 0),
+          segmented(minutes > 0 || megabytes > 0)
+    {
+    }
+
+    ~SegmentedRecorder()
+    {
+        close();
+    }
+
+    void open()
+    {
+        start_segment();
+        if (segmented)
+        {
+            manifest.open(basename + ".manifest");
+            manifest << "# segment first_frame last_frame frames first_timestamp_ns last_timestamp_ns bytes"
+                     << std::endl;
+            prepare_pending = true;
+            finisher = std::thread(&SegmentedRecorder::finisher_loop, this);
+        }
+    }
+
+    // Starts the next segment if the previous frame filled the current one
+    void before_grab()
+    {
+        if (roll_pending)
+            roll();
+    }
+
+    // Called after every successful grab, the frame is already in the current segment
+    void on_frame(uint64_t timestamp_ns)
+    {
+        if (current.frames == 0)
+            current.first_timestamp_ns = timestamp_ns;
+        current.last_timestamp_ns = timestamp_ns;
+        current.frames++;
+        frames++;
+
+        roll_pending = segmented && segment_full();
+    }
+
+    void close()
+    {
+        if (recording)
+            source->disable_recording();
+        stop_finisher();
+        if (!recording)
+            return;
+        recording = false;
+
+        // The input ended right after a rollover
+        if (segmented && current.frames == 0 && segment_index > 0)
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(get_filename(), ec);
+            segment_index--;
+            return;
+        }
+        finish_segment(current, get_filename());
+    }
+
+    std::string get_filename() const
+    {
+        return segment_name(segment_index);
+    }
+
+    bool is_segmented() const
+    {
+        return segmented;
+    }
+
+    void report(std::ostream &out) const
+    {
+        if (!segmented)
+            return;
+
+        std::streamsize precision = out.precision();
+        out << "Segments: " << segment_index + 1 << " written, manifest " << basename << ".manifest" << std::endl;
+        if (rollovers.get_count() > 0)
+            out << std::fixed << std::setprecision(2)
+                << "  rollover ms: mean " << rollovers.mean() / 1e6 << " p99 " << rollovers.percentile(0.99) / 1e6
+                << " max " << rollovers.get_max() / 1e6 << std::defaultfloat << std::setprecision(precision)
+                << ", " << slow_rollovers << " longer than a frame period" << std::endl;
+    }
+
+private:
+    struct Segment
+    {
+        uint64_t first_frame = 0;
+        uint64_t frames = 0;
+        uint64_t first_timestamp_ns = 0;
+        uint64_t last_timestamp_ns = 0;
+    };
+
+    FrameSource *source;
+    std::string basename;
+    std::string extension;
+    uint64_t max_duration_ns;
+    uint64_t max_bytes;
+    uint64_t frame_period_ns;
+    bool segmented;
+    bool recording = false;
+    bool roll_pending = false;
+
+    int segment_index = 0;
+    uint64_t frames = 0;
+    Segment current;
+    uint64_t checked_frames = 0;
+    uint64_t checked_bytes = 0;
+    LatencyHistogram rollovers;
+    uint64_t slow_rollovers = 0;
+    std::ofstream manifest;
+
+    // A segment handed to the finisher, `writer` is its raw dump still open
+    struct Closing
+    {
+        Segment segment;
+        std::string filename;
+        std::unique_ptr<RawFrameWriter> writer;
+    };
+
+    // Shared with the finisher thread
+    std::thread finisher;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Closing> closing;
+    std::unique_ptr<RawFrameWriter> prepared;
+    bool prepare_pending = false;
+    bool stopping = false;
+
+    std::string segment_name(int index) const
+    {
+        if (!segmented)
+            return basename + extension;
+
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "_%03d", index);
+        return basename + suffix + extension;
+    }
+
+    bool segment_full()
+    {
+        // Half a period of slack absorbs timestamp jitter at the boundary
+        uint64_t duration_ns = current.last_timestamp_ns - current.first_timestamp_ns + frame_period_ns * 3 / 2;
+        if (max_duration_ns > 0 && duration_ns >= max_duration_ns)
+            return true;
+        return max_bytes > 0 && estimated_bytes() >= max_bytes;
+    }
+
+    // Stats the file every SEGMENT_SIZE_CHECK_FRAMES frames and extrapolates from the
+    // mean frame size of the segment in between, a stat per frame is too costly
+    uint64_t estimated_bytes()
+    {
+        if (current.frames - checked_frames >= SEGMENT_SIZE_CHECK_FRAMES || checked_frames == 0)
+        {
+            checked_bytes = file_bytes(get_filename());
+            checked_frames = current.frames;
+        }
+        uint64_t frame_bytes = checked_frames > 0 ? checked_bytes / checked_frames : 0;
+        return checked_bytes + (current.frames - checked_frames) * frame_bytes;
+    }
+
+    static uint64_t file_bytes(const std::string &filename)
+    {
+        boost::system::error_code ec;
+        auto size = boost::filesystem::file_size(filename, ec);
+        return ec ? 0 : (uint64_t)size;
+    }
+
+    void start_segment()
+    {
+        enable_recording(source, get_filename());
+        recording = true;
+        current = Segment();
+        current.first_frame = frames;
+        checked_frames = 0;
+        checked_bytes = 0;
+    }
+
+    void finish_segment(const Segment &segment, const std::string &filename)
+    {
+        if (!segmented)
+            return;
+
+        manifest << filename << " " << segment.first_frame << " "
+                 << (segment.frames > 0 ? segment.first_frame + segment.frames - 1 : segment.first_frame) << " "
+                 << segment.frames << " " << segment.first_timestamp_ns << " " << segment.last_timestamp_ns << " "
+                 << file_bytes(filename) << std::endl;
+    }
+
+    // Swaps in the segment created by the finisher, waiting for it when the creation is
+    // still under way, and hands the previous one over for closing
+    void roll()
+    {
+        auto start = std::chrono::steady_clock::now();
+        roll_pending = false;
+
+        Closing previous{current, get_filename(), nullptr};
+        std::unique_ptr<RawFrameWriter> writer;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writer = std::move(prepared);
+            segment_index++;
+        }
+
+        auto err = source->switch_recording(get_filename(), writer, sl::SVO_COMPRESSION_MODE::H264);
+        previous.writer = std::move(writer);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing.push_back(std::move(previous));
+            prepare_pending = true;
+        }
+        wake.notify_one();
+        if (err != sl::ERROR_CODE::SUCCESS)
+        {
+            recording = false;
+            throw err;
+        }
+
+        current = Segment();
+        current.first_frame = frames;
+        checked_frames = 0;
+        checked_bytes = 0;
+
+        uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+        rollovers.record(elapsed_ns);
+        if (elapsed_ns > frame_period_ns)
+            slow_rollovers++;
+    }
+
+    // Closes handed over segments in order, then creates the segment after the current
+    // one. The creation holds the lock so a switch never races it for the same file.
+    void finisher_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this] { return stopping || !closing.empty() || prepare_pending; });
+
+            if (!closing.empty())
+            {
+                Closing done = std::move(closing.front());
+                closing.pop_front();
+                lock.unlock();
+                if (done.writer)
+                    done.writer->close();
+                finish_segment(done.segment, done.filename);
+                lock.lock();
+                continue;
+            }
+
+            if (stopping)
+                break;
+
+            prepare_pending = false;
+            prepared = source->prepare_recording(segment_name(segment_index + 1));
+        }
+    }
+
+    // Writes the pending manifest lines and removes the segment created ahead of a
+    // switch that never came
+    void stop_finisher()
+    {
+        if (!finisher.joinable())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        finisher.join();
+        remove_prepared(prepared, segment_name(segment_index + 1));
+    }
+
+    static void remove_prepared(std::unique_ptr<RawFrameWriter> &writer, const std::string &filename)
+    {
+        if (!writer)
+            return;
+        writer->close();
+        writer.reset();
+        boost::system::error_code ec;
+        boost::filesystem::remove(filename, ec);
+    }
+};
+
+#endif
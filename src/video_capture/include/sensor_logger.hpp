@@ -0,0 +1,182 @@
+#ifndef __VID_SENSOR_LOGGER__
+#define __VID_SENSOR_LOGGER__
+
+#include <frame_source.hpp>
+#include <sensor_log.hpp>
+#include <spsc_queue.hpp>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#define SENSOR_POLL_HZ 400
+#define SENSOR_RING_RECORDS 4096
+#define SENSOR_WRITE_BATCH 256
+
+// Full rate inertial log next to the recording. With the SDK a poll thread samples the
+// sensors with TIME_REFERENCE::CURRENT at SENSOR_POLL_HZ, skips samples whose IMU
+// timestamp did not change and pushes the rest into a lock-free ring; a writer thread
+// drains the ring in batches. Neither thread touches the grab loop.
+// Synthetic and raw sources are not thread safe and only have one sample per frame, so
+// for them on_frame() takes that sample from the grab thread instead of a poll thread.
+class SensorLogger
+{
+public:
+    SensorLogger(FrameSource *source, const std::string &filename)
+        : source(source), filename(filename), ring(SENSOR_RING_RECORDS), polled(source->get_camera() != nullptr)
+    {
+    }
+
+    ~SensorLogger()
+    {
+        stop();
+    }
+
+    bool start()
+    {
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        SensorLogHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, SENSOR_LOG_MAGIC, sizeof(header.magic));
+        header.version = SENSOR_LOG_VERSION;
+        header.record_bytes = sizeof(SensorRecord);
+        header.poll_hz = polled ? SENSOR_POLL_HZ : (uint32_t)source->get_fps();
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        running = true;
+        writing = true;
+        started = std::chrono::steady_clock::now();
+        if (polled)
+            poll_thread = std::thread(&SensorLogger::poll_loop, this);
+        writer_thread = std::thread(&SensorLogger::writer_loop, this);
+        return true;
+    }
+
+    void stop()
+    {
+        if (!writer_thread.joinable())
+            return;
+
+        running = false;
+        if (poll_thread.joinable())
+            poll_thread.join();
+        writing = false;
+        writer_thread.join();
+        file.close();
+        elapsed = std::chrono::steady_clock::now() - started;
+    }
+
+    // After every successful grab, from the grab thread. Only sources without the SDK
+    // are sampled here, the poll thread covers the others.
+    void on_frame()
+    {
+        if (!polled && running)
+            sample(sl::TIME_REFERENCE::IMAGE);
+    }
+
+    void report(std::ostream &out)
+    {
+        double seconds = elapsed.count();
+        std::streamsize precision = out.precision();
+        out << "Sensors: " << samples << " IMU samples (" << std::fixed << std::setprecision(1)
+            << (seconds > 0.0 ? samples / seconds : 0.0) << " Hz) to " << filename << ", "
+            << duplicates << " duplicate polls, " << failures << " failed polls, " << overruns << " overruns, "
+            << ring.get_dropped() << " dropped" << std::defaultfloat << std::setprecision(precision) << std::endl;
+    }
+
+private:
+    FrameSource *source;
+    std::string filename;
+    SpscRing<SensorRecord> ring;
+    std::ofstream file;
+    std::thread poll_thread;
+    std::thread writer_thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> writing{false};
+    bool polled;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::duration<double> elapsed{0.0};
+
+    uint64_t samples = 0;
+    uint64_t duplicates = 0;
+    uint64_t failures = 0;
+    uint64_t overruns = 0;
+    uint64_t last_imu = 0;
+    uint64_t last_magnetometer = 0;
+    uint64_t last_barometer = 0;
+    sl::SensorsData data;
+    SensorRecord record;
+
+    // From the single producer, the poll thread or the grab thread
+    void sample(sl::TIME_REFERENCE reference)
+    {
+        if (source->get_sensors_data(data, reference) != sl::ERROR_CODE::SUCCESS)
+            failures++;
+        else if (data.imu.timestamp.getNanoseconds() == last_imu)
+            duplicates++;
+        else
+        {
+            sensors_to_record(data, record);
+            if (record.magnetometer_timestamp_ns != last_magnetometer)
+                record.flags |= SENSOR_NEW_MAGNETOMETER;
+            if (record.barometer_timestamp_ns != last_barometer)
+                record.flags |= SENSOR_NEW_BAROMETER;
+
+            last_imu = record.imu_timestamp_ns;
+            last_magnetometer = record.magnetometer_timestamp_ns;
+            last_barometer = record.barometer_timestamp_ns;
+            if (ring.push(record))
+                samples++;
+        }
+    }
+
+    void poll_loop()
+    {
+        const auto period = std::chrono::nanoseconds(1000000000 / SENSOR_POLL_HZ);
+        auto next = std::chrono::steady_clock::now();
+
+        while (running)
+        {
+            next += period;
+            sample(sl::TIME_REFERENCE::CURRENT);
+
+            auto now = std::chrono::steady_clock::now();
+            if (now > next)
+            {
+                overruns++;
+                next = now;
+            }
+            else
+                std::this_thread::sleep_until(next);
+        }
+    }
+
+    void writer_loop()
+    {
+        std::vector<SensorRecord> batch(SENSOR_WRITE_BATCH);
+
+        while (true)
+        {
+            bool stopping = !writing;
+            size_t count = 0;
+            while (count < batch.size() && ring.pop(batch[count]))
+                count++;
+
+            if (count > 0)
+                file.write(reinterpret_cast<const char *>(batch.data()), count * sizeof(SensorRecord));
+            if (count == batch.size())
+                continue;
+            if (stopping)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        file.flush();
+    }
+};
+
+#endif
@@ -1,10 +1,56 @@
 #ifndef __VID_TASKS__
 #define __VID_TASKS__
 
-static void record_step(sl::Camera *camera, sl::RuntimeParameters& params)
+#include <frame_source.hpp>
+#include <capture_stats.hpp>
+#include <segments.hpp>
+#include <event_recorder.hpp>
+#include <sensor_logger.hpp>
+
+static sl::ERROR_CODE timed_grab(FrameSource *source, sl::RuntimeParameters& params, CaptureStats &stats,
+                                 uint64_t &timestamp_ns)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto err = source->grab(params);
+    uint64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+
+    if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+        return err;
+
+    timestamp_ns = 0;
+    float current_fps = 0.f;
+    if (err == sl::ERROR_CODE::SUCCESS)
+    {
+        timestamp_ns = source->get_timestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+        current_fps = source->get_current_fps();
+    }
+    stats.record_grab(err, latency_ns, timestamp_ns, current_fps);
+    return err;
+}
+
+// Segment rollovers happen here, between two grabs
+static sl::ERROR_CODE record_step(FrameSource *source, sl::RuntimeParameters& params, CaptureStats &stats,
+                                  SegmentedRecorder &recorder)
+{
+    recorder.before_grab();
+
+    uint64_t timestamp_ns;
+    auto err = timed_grab(source, params, stats, timestamp_ns);
+    if (err == sl::ERROR_CODE::SUCCESS)
+        recorder.on_frame(timestamp_ns);
+    return err;
+}
+
+static sl::ERROR_CODE event_step(FrameSource *source, sl::RuntimeParameters& params, CaptureStats &stats,
+                                 EventRecorder &events, bool external_trigger)
 {
-    sl::SensorsData data;
-    camera->grab(params);
+    uint64_t timestamp_ns;
+    auto err = timed_grab(source, params, stats, timestamp_ns);
+    if (err == sl::ERROR_CODE::SUCCESS)
+        events.on_frame(external_trigger);
+    return err;
 }
 
-#endif
\ No newline at end of file
+#endif
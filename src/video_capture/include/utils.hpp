@@ -2,6 +2,7 @@
 #define __VID_UTILS__
 
 #include <sl/Camera.hpp>
+#include <sources.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <boost/filesystem.hpp>
@@ -10,84 +11,37 @@
 #include <sstream>
 #include <iostream>
 
-static std::unique_ptr<sl::Camera> get_camera(sl::RESOLUTION res, int fps)
+static std::unique_ptr<FrameSource> get_frame_source(
+    const std::string &source, const std::string &input, sl::RESOLUTION res, int fps)
 {
     sl::InitParameters params;
     params.camera_resolution = res;
     params.camera_fps = fps;
 
-    auto zed_camera = std::make_unique<sl::Camera>();
-    auto err = zed_camera->open(params);
-
-    if (err != sl::ERROR_CODE::SUCCESS)
-    {
-        throw err;
-    }
-
-    return zed_camera;
+    return open_frame_source(source, input, params);
 }
 
-static void enable_recording(sl::Camera *camera, const std::string& filename)
+static void enable_recording(FrameSource *source, const std::string& filename)
 {
-    sl::RecordingParameters recordingParameters;
-    recordingParameters.compression_mode = sl::SVO_COMPRESSION_MODE::H264;
-    recordingParameters.video_filename = sl::String(filename.c_str());
-    auto err = camera->enableRecording(recordingParameters);
+    auto err = source->enable_recording(filename, sl::SVO_COMPRESSION_MODE::H264);
     if (err != sl::ERROR_CODE::SUCCESS)
         throw err;
 }
 
-static std::string get_filename()
+// Recording name without extension, segments and sidecar files derive from it
+static std::string get_basename()
 {
     auto t = std::time(nullptr);
     auto tm = *std::localtime(&t);
     std::stringstream buffer;
     buffer << std::put_time(&tm, "%d-%m-%Y_%Hh-%Mm-%Ss");
-    std::string filename = "ZED2i_" + buffer.str() + ".svo";
-    return filename;
-}
-
-// Mapping between MAT_TYPE and CV_TYPE
-static int getOCVtype(sl::MAT_TYPE type)
-{
-    int cv_type = -1;
-    switch (type)
-    {
-    case sl::MAT_TYPE::F32_C1:
-        cv_type = CV_32FC1;
-        break;
-    case sl::MAT_TYPE::F32_C2:
-        cv_type = CV_32FC2;
-        break;
-    case sl::MAT_TYPE::F32_C3:
-        cv_type = CV_32FC3;
-        break;
-    case sl::MAT_TYPE::F32_C4:
-        cv_type = CV_32FC4;
-        break;
-    case sl::MAT_TYPE::U8_C1:
-        cv_type = CV_8UC1;
-        break;
-    case sl::MAT_TYPE::U8_C2:
-        cv_type = CV_8UC2;
-        break;
-    case sl::MAT_TYPE::U8_C3:
-        cv_type = CV_8UC3;
-        break;
-    case sl::MAT_TYPE::U8_C4:
-        cv_type = CV_8UC4;
-        break;
-    default:
-        break;
-    }
-    return cv_type;
+    return "ZED2i_" + buffer.str();
 }
 
-static cv::Mat slMat2cvMat(sl::Mat &input)
+// Sources without an SDK camera behind them can only be recorded as raw frame dumps
+static std::string get_extension(bool raw_dump)
 {
-    // Since cv::Mat data requires a uchar* pointer, we get the uchar1 pointer from sl::Mat (getPtr<T>())
-    // cv::Mat and sl::Mat will share a single memory structure
-    return cv::Mat(input.getHeight(), input.getWidth(), getOCVtype(input.getDataType()), input.getPtr<sl::uchar1>(sl::MEM::CPU), input.getStepBytes(sl::MEM::CPU));
+    return raw_dump ? ".raw" : ".svo";
 }
 
 static sl::RESOLUTION get_resolution(const std::string &resolution)
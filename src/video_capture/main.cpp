@@ -2,12 +2,16 @@
 #include <tasks.hpp>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <csignal>
 #include <arg_parser.hpp>
 
 void poll_exit();
 void show_fps(bool with_gui);
+void on_trigger_signal(int);
 bool exit_app = false;
 int fps_view = 0;
+std::atomic<bool> external_trigger{false};
 
 int main(int argc, char *argv[])
 {
@@ -25,21 +29,39 @@ int main(int argc, char *argv[])
 
     std::string s_resolution = parser.get_resolution_value();
     std::string s_fps = parser.get_fps_value();
+    std::string s_source = parser.get_source();
+    std::string s_input = parser.get_input_file();
+    std::chrono::seconds stats_interval(parser.get_stats_interval());
+    int segment_minutes = parser.get_segment_minutes();
+    int segment_mb = parser.get_segment_megabytes();
+    bool imu_logging = parser.get_imu_logging();
+    std::string s_trigger = parser.get_trigger();
+    bool event_mode = s_trigger.compare("off") != 0;
+
+    EventOptions event_options;
+    event_options.trigger = string2trigger(s_trigger);
+    event_options.pre_seconds = parser.get_pre_seconds();
+    event_options.post_seconds = parser.get_post_seconds();
+    event_options.motion_percent = parser.get_motion_threshold();
+    event_options.depth_meters = parser.get_depth_threshold();
 
     int fps = std::stoi(s_fps);
     sl::RESOLUTION resolution = get_resolution(s_resolution);
     cv::Size resolution_size = resolution_to_cvsize(resolution);
 
-    std::unique_ptr<sl::Camera> zed_camera = nullptr;
+    std::unique_ptr<FrameSource> source = nullptr;
 
     std::cout << "Resolution: " << s_resolution << std::endl;
     std::cout << "FPS: " << s_fps << std::endl;
+    std::cout << "Source: " << s_source << " " << s_input << std::endl;
 
     std::cout << "Initializing resources..." << std::endl;
 
     try
     {
-        zed_camera = get_camera(
+        source = get_frame_source(
+            s_source,
+            s_input,
             resolution,
             fps);
     }
@@ -49,31 +71,118 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    std::string filename = get_filename();
+    std::string basename = get_basename();
+    SegmentedRecorder recorder(source.get(), basename, get_extension(source->get_camera() == nullptr),
+                               segment_minutes, segment_mb);
 
-    try
+    std::unique_ptr<EventRecorder> events = nullptr;
+    sl::RuntimeParameters params;
+    params.enable_depth = false;
+
+    if (event_mode)
     {
-        enable_recording(zed_camera.get(), filename);
+        events = std::make_unique<EventRecorder>(source.get(), basename, event_options);
+        params.enable_depth = events->with_depth();
+        events->start();
+        std::signal(SIGUSR1, on_trigger_signal);
+
+        std::cout << "Event recording (" << s_trigger << "), pre-roll " << event_options.pre_seconds
+                  << " s, post-roll " << event_options.post_seconds << " s, ring "
+                  << events->get_ring_bytes() / (1024 * 1024) << " MB" << std::endl;
+        std::cout << "Type T or send SIGUSR1 to trigger manually." << std::endl;
     }
-    catch (const sl::ERROR_CODE &err)
+    else
     {
-        std::cerr << "Could not enable recording: " << err << std::endl;
-        return 1;
+        try
+        {
+            recorder.open();
+        }
+        catch (const sl::ERROR_CODE &err)
+        {
+            std::cerr << "Could not enable recording: " << err << std::endl;
+            return 1;
+        }
+
+        std::cout << "Recording started." << std::endl;
+        std::cout << "Writing to: " << recorder.get_filename() << std::endl;
+        if (recorder.is_segmented())
+            std::cout << "Segments: " << segment_minutes << " min / " << segment_mb << " MB" << std::endl;
     }
 
-    std::cout << "Recording started." << std::endl;
-    std::cout << "Writing to: " << filename << std::endl;
+    std::unique_ptr<SensorLogger> sensors = nullptr;
+    if (imu_logging)
+    {
+        sensors = std::make_unique<SensorLogger>(source.get(), basename + ".imu");
+        if (sensors->start())
+            std::cout << "Logging sensors to: " << basename << ".imu" << std::endl;
+        else
+        {
+            std::cerr << "Could not open " << basename << ".imu" << std::endl;
+            sensors.reset();
+        }
+    }
 
     std::thread poll(poll_exit);
 
-    sl::RuntimeParameters params;
-    params.enable_depth = false;
+    CaptureStats stats(source->get_fps());
+    bool end_of_input = false;
     while (exit_app == false)
     {
-        record_step(zed_camera.get(), params);
+        sl::ERROR_CODE err;
+        try
+        {
+            if (events)
+                err = event_step(source.get(), params, stats, *events, external_trigger.exchange(false));
+            else
+                err = record_step(source.get(), params, stats, recorder);
+        }
+        catch (const sl::ERROR_CODE &e)
+        {
+            std::cerr << std::endl << "Segment rollover failed: " << e << std::endl;
+            break;
+        }
+
+        if (err == sl::ERROR_CODE::SUCCESS && sensors)
+            sensors->on_frame();
+        if (err == sl::ERROR_CODE::END_OF_SVOFILE_REACHED)
+        {
+            std::cout << std::endl << "End of input reached." << std::endl;
+            end_of_input = true;
+            exit_app = true;
+        }
+        if (stats.interval_elapsed(stats_interval))
+            stats.report_interval(std::cout);
+    }
+
+    recorder.close();
+    if (events)
+        events->stop();
+    if (sensors)
+        sensors->stop();
+    std::cout << std::endl;
+    stats.report(std::cout);
+    recorder.report(std::cout);
+    if (events)
+        events->report(std::cout);
+    if (sensors)
+        sensors->report(std::cout);
+
+    std::ofstream summary(basename + ".stats");
+    if (summary.is_open())
+    {
+        stats.report(summary);
+        recorder.report(summary);
+        if (events)
+            events->report(summary);
+        if (sensors)
+            sensors->report(summary);
     }
 
-    poll.join();
+    // poll_exit is still blocked on stdin when the input runs out
+    if (end_of_input)
+        poll.detach();
+    else
+        poll.join();
 
     std::cout << "Quitting Application." << std::endl;
 }
@@ -94,8 +203,19 @@ void poll_exit()
         if (next_char == 'Q' || next_char == 'q')
             break;
 
+        if (next_char == 'T' || next_char == 't')
+        {
+            external_trigger = true;
+            next_char = 0;
+        }
+
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
 
     exit_app = true;
+}
+
+void on_trigger_signal(int)
+{
+    external_trigger = true;
 }
\ No newline at end of file